@@ -0,0 +1,82 @@
+/****************************************************************************************************************************
+  HardwareWaveform.ino
+  For Arduino and Adadruit AVR 328(P) and 32u4 boards, and Mega
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Square wave, PWM and single pulse driven by the compare-match hardware of the timers on their OCnA / OCnB pins,
+  instead of toggling the pins with digitalWrite() from the timer ISR as in FakeAnalogWrite. No interrupt, no jitter.
+  UNO / Nano: OC1A = D9, OC1B = D10, OC2B = D3. Mega: OC1A = D11, OC1B = D12, OC2B = D9. 32u4: OC1A = D9, OC1B = D10
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#define USE_TIMER_1     true
+
+#if !defined(__AVR_ATmega32U4__)
+	#define USE_TIMER_2     true
+#endif
+
+#include "TimerInterrupt_Generic.h"
+
+void printWaveform(const __FlashStringHelper* name, TimerInterrupt& timer, uint8_t channel)
+{
+	Serial.print(name);
+	Serial.print(F(" on pin "));
+	Serial.print(timer.getWaveformPin(channel));
+	Serial.print(F(", frequency = "));
+	Serial.print(timer.getWaveformFrequency(), 3);
+	Serial.print(F(" Hz, error ppm = "));
+	Serial.println(timer.getErrorPPM());
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting HardwareWaveform on "));
+	Serial.println(BOARD_TYPE);
+	Serial.println(TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// 50Hz servo-like PWM on OC1A (1.5ms = 7.5%) and OC1B (1ms = 5%), phase correct
+	if (ITimer1.setPWM(50, WAVEFORM_CHANNEL_A, 7.5, true) && ITimer1.setPWMDuty(WAVEFORM_CHANNEL_B, 5))
+		printWaveform(F("PWM"), ITimer1, WAVEFORM_CHANNEL_A);
+	else
+		Serial.println(F("Can't set ITimer1 PWM"));
+
+#if USE_TIMER_2
+
+	// 1KHz square wave on OC2B
+	if (ITimer2.setSquareWave(1000, WAVEFORM_CHANNEL_B))
+		printWaveform(F("Square wave"), ITimer2, WAVEFORM_CHANNEL_B);
+	else
+		Serial.println(F("Can't set ITimer2 square wave"));
+
+#endif
+}
+
+void loop()
+{
+	static float duty = 5;
+
+	// Sweep the OC1B duty from 5% to 10%, without glitch
+	duty = (duty >= 10) ? 5 : duty + 0.5;
+
+	ITimer1.setPWMDuty(WAVEFORM_CHANNEL_B, duty);
+
+	delay(500);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************************************************************
+  ICP_RPM_Measure.ino
+  For Arduino and Adadruit AVR 328(P) and 32u4 boards, and Mega
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  RPM measuring with the input capture of a 16-bit timer, instead of polling the sensor from a 1ms timer ISR.
+  Each falling edge of the REED SW or IR LED Sensor on the ICP pin latches the timer count in hardware, so the rotation
+  time is exact to the timer tick (4us here), with only one interrupt per rotation (plus one per 262ms overflow).
+  The sensor must be on the ICP pin: D8 for UNO / Nano, D4 for 32u4 (ICP1), D49 for Mega (ICP4).
+  Asssuming LOW is active.
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#if ( defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__) )
+	#define USE_TIMER_4_CAPTURE     true
+	#define ICapture                ICapture4
+	#define ICP_PIN                 49
+#elif defined(__AVR_ATmega32U4__)
+	#define USE_TIMER_1_CAPTURE     true
+	#define ICapture                ICapture1
+	#define ICP_PIN                 4
+#else
+	#define USE_TIMER_1_CAPTURE     true
+	#define ICapture                ICapture1
+	#define ICP_PIN                 8
+#endif
+
+#include "TimerInterrupt_Generic.h"
+
+// Rotations faster than 100ms (600RPM) are considered noise
+#define MIN_ROTATION_US           100000UL
+
+void setup()
+{
+	pinMode(ICP_PIN, INPUT_PULLUP);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ICP_RPM_Measure on "));
+	Serial.println(BOARD_TYPE);
+	Serial.println(TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Falling edge, noise canceler on, 250KHz timer clock at 16MHz
+	if (ICapture.begin(CAPTURE_EDGE_FALLING, true, PRESCALER_64))
+	{
+		Serial.print(F("Starting input capture OK, tick frequency = "));
+		Serial.println(ICapture.getTickFrequency());
+	}
+	else
+		Serial.println(F("Can't start input capture"));
+}
+
+void loop()
+{
+	static uint32_t rotationTicks = 0;
+	static float    avgRPM        = 0;
+
+	uint32_t period;
+
+	// Sum the periods shorter than MIN_ROTATION_US, i.e. the bounces, into the rotation
+	while (ICapture.read(period))
+	{
+		rotationTicks += period;
+
+		float rotationUs = (float) rotationTicks * 1000000.0f / ICapture.getTickFrequency();
+
+		if (rotationUs >= MIN_ROTATION_US)
+		{
+			float RPM = 60000000.0f / rotationUs;
+
+			avgRPM = ( 2 * avgRPM + RPM) / 3;
+
+			Serial.print(F("RPM = "));
+			Serial.print(avgRPM);
+			Serial.print(F(", rotationTime us = "));
+			Serial.println(rotationUs, 0);
+
+			rotationTicks = 0;
+		}
+	}
+
+	if (ICapture.isIdle())
+		avgRPM = 0;
+}
@@ -0,0 +1,118 @@
+/****************************************************************************************************************************
+  ISR_Cycles.ino
+  For Arduino and Adadruit AVR 328(P) and 32u4 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Measures the CPU cycles taken by each interrupt of ITimer1, vector, prologue, body and epilogue included, as the time
+  lost by a busy loop while ITimer1 interrupts at TIMER1_FREQ_HZ with an empty callback.
+  Build it once with TIMER_INTERRUPT_DIRECT_ISR false (generic ISR) and once with true (TimerInterruptDirect ISR)
+  to compare both.
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#define USE_TIMER_1     true
+
+// false => generic ISR, true => TimerInterruptDirect ISR
+#define TIMER_INTERRUPT_DIRECT_ISR        true
+#define TIMER_INTERRUPT_DIRECT_CALLBACK   TIMER_CALLBACK_NO_PARAMS
+
+#include "TimerInterrupt_Generic.h"
+
+#define TIMER1_FREQ_HZ        20000L
+
+// Busy loop iterations of a measurement
+#define LOOP_COUNT            200000UL
+
+volatile uint32_t interruptCount = 0;
+
+void TimerHandler1()
+{
+	interruptCount++;
+}
+
+// Returns the micros() taken by LOOP_COUNT iterations of a busy loop
+uint32_t busyLoop()
+{
+	volatile uint32_t i;
+
+	uint32_t startTime = micros();
+
+	for (i = 0; i < LOOP_COUNT; i++);
+
+	return micros() - startTime;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Cycles on "));
+	Serial.println(BOARD_TYPE);
+	Serial.println(TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+#if TIMER_INTERRUPT_DIRECT_ISR
+	Serial.println(F("TimerInterruptDirect ISR"));
+#else
+	Serial.println(F("Generic ISR"));
+#endif
+
+	ITimer1.init();
+}
+
+void loop()
+{
+	// Reference, without ITimer1
+	uint32_t timeOff = busyLoop();
+
+	if (!ITimer1.attachInterrupt(TIMER1_FREQ_HZ, TimerHandler1))
+	{
+		Serial.println(F("Can't set ITimer1. Select another freq. or timer"));
+
+		return;
+	}
+
+	noInterrupts();
+	interruptCount = 0;
+	interrupts();
+
+	uint32_t timeOn = busyLoop();
+
+	noInterrupts();
+	uint32_t count = interruptCount;
+	interrupts();
+
+	ITimer1.detachInterrupt();
+
+	if ( (count > 0) && (timeOn > timeOff) )
+	{
+		// lost CPU cycles per interrupt
+		float cycles = (float) (timeOn - timeOff) * (F_CPU / 1000000L) / count;
+
+		Serial.print(F("Without ITimer1 = "));
+		Serial.print(timeOff);
+		Serial.print(F(" us, with ITimer1 = "));
+		Serial.print(timeOn);
+		Serial.print(F(" us, interrupts = "));
+		Serial.print(count);
+		Serial.print(F(", cycles per interrupt = "));
+		Serial.println(cycles, 1);
+	}
+
+	delay(2000);
+}
@@ -0,0 +1,97 @@
+/****************************************************************************************************************************
+  Timer2_PowerSave.ino
+  For Arduino Mega, or 328P boards running on their internal RC oscillator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Timer2 clocked from a 32.768KHz watch crystal on TOSC1 / TOSC2 (Mega: PG4 / PG3), in asynchronous mode.
+  The MCU sleeps in power-save mode, and is woken up once a second by the Timer2 compare, with a single interrupt
+  per second instead of the many chunk interrupts of Timer2 clocked from F_CPU.
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#define USE_TIMER_2     true
+
+#include "TimerInterrupt_Generic.h"
+
+#ifndef LED_BUILTIN
+	#define LED_BUILTIN   13
+#endif
+
+volatile uint32_t seconds = 0;
+
+void TimerHandler2()
+{
+	seconds++;
+}
+
+void setup()
+{
+	pinMode(LED_BUILTIN, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer2_PowerSave on "));
+	Serial.println(BOARD_TYPE);
+	Serial.println(TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	ITimer2.init();
+
+	if (!ITimer2.setAsyncClock())
+	{
+		Serial.println(F("No asynchronous Timer2 on this board"));
+
+		return;
+	}
+
+	// Let the crystal start
+	delay(1000);
+
+	if (ITimer2.attachInterruptInterval<1000>(TimerHandler2))
+	{
+		Serial.print(F("Starting ITimer2 OK, interrupts per period = "));
+		Serial.println(ITimer2.getInterruptsPerPeriod());
+	}
+	else
+		Serial.println(F("Can't set ITimer2. Select another freq. or timer"));
+
+	Serial.flush();
+}
+
+void loop()
+{
+	static uint32_t lastSeconds = 0;
+
+	if (seconds != lastSeconds)
+	{
+		lastSeconds = seconds;
+
+		digitalWrite(LED_BUILTIN, lastSeconds & 1);
+
+		if (lastSeconds % 10 == 0)
+		{
+			Serial.print(F("Seconds = "));
+			Serial.println(lastSeconds);
+
+			// Serial is stopped in power-save
+			Serial.flush();
+		}
+	}
+
+	ITimer2.sleepPowerSave();
+}
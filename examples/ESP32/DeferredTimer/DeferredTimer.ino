@@ -0,0 +1,103 @@
+/****************************************************************************************************************************
+  DeferredTimer.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  With attachDeferredInterruptInterval(), the timer ISR only notifies a worker task, owned by the library and pinned to
+  a core, which runs the callback. The callback is not in an ISR: it can use Serial, float, Wi-Fi, MQTT or files, and
+  needs no IRAM_ATTR. Its ticks parameter counts the timer ticks since its last call: more than 1 => ticks were missed
+  while the task was late. getDeferredStats() gives the missed ticks and the ISR to task wakeup latency.
+*****************************************************************************************************************************/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+#include "TimerInterrupt_Generic.h"
+
+#define TIMER_INTERVAL_US             10000L
+
+// Worker task on the last core, Arduino loop() is on core 1 for ESP32, 0 for ESP32_S2 / C3
+#define DEFERRED_TASK_CORE            (portNUM_PROCESSORS - 1)
+#define DEFERRED_TASK_PRIORITY        10
+
+#define STATS_INTERVAL_MS             5000L
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+uint32_t totalTicks = 0;
+
+// Runs in the worker task, not in the ISR
+void TimerHandler0(uint32_t ticks)
+{
+	totalTicks += ticks;
+
+	// Not ISR-safe, but OK here
+	if (ticks > 1)
+	{
+		Serial.print(F("Missed ticks = "));
+		Serial.println(ticks - 1);
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting DeferredTimer on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if (ITimer0.attachDeferredInterruptInterval(TIMER_INTERVAL_US, TimerHandler0, DEFERRED_TASK_CORE, DEFERRED_TASK_PRIORITY))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+
+	Serial.flush();
+}
+
+void loop()
+{
+	static unsigned long lastStats = 0;
+
+	if (millis() - lastStats >= STATS_INTERVAL_MS)
+	{
+		esp32_deferred_stats_t stats;
+
+		lastStats = millis();
+
+		ITimer0.getDeferredStats(stats);
+		ITimer0.resetDeferredStats();
+
+		Serial.print(F("Runs = "));
+		Serial.print(stats.runs);
+		Serial.print(F(", missed ticks = "));
+		Serial.print(stats.missedTicks);
+		Serial.print(F(", latency (us) avg = "));
+		Serial.print(stats.runs ? (uint32_t) (stats.totalLatencyUs / stats.runs) : 0);
+		Serial.print(F(", max = "));
+		Serial.print(stats.maxLatencyUs);
+		Serial.print(F(", total ticks = "));
+		Serial.println(totalTicks);
+	}
+}
@@ -0,0 +1,111 @@
+/****************************************************************************************************************************
+  IRAM_SafeTimer.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  With TIMER_INTERRUPT_IRAM_SAFE, the timer interrupt keeps running while loop() writes to NVS, with the flash cache
+  disabled. The ISR records the longest gap between two interrupts: about TIMER_INTERVAL_US, where it reaches the
+  duration of a flash erase / write, several ms, with TIMER_INTERRUPT_IRAM_SAFE false.
+  The callback and all it calls must be IRAM_ATTR, and use DRAM data only: no const table, no Serial, no float.
+*****************************************************************************************************************************/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+// Set to false to see the timer interrupts deferred by the flash writes
+#define TIMER_INTERRUPT_IRAM_SAFE     true
+
+#include "TimerInterrupt_Generic.h"
+
+#include <Preferences.h>
+
+#define TIMER_INTERVAL_US             1000L
+
+Preferences preferences;
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+// In DRAM, as all the data of the ISR
+volatile uint32_t ticks       = 0;
+volatile uint32_t lastMicros  = 0;
+volatile uint32_t maxGap      = 0;
+
+bool IRAM_ATTR TimerHandler0(void * timerNo)
+{
+	(void) timerNo;
+
+	// micros() is IRAM_ATTR in the ESP32 core
+	uint32_t now = micros();
+
+	if ( (ticks > 0) && (now - lastMicros > maxGap) )
+		maxGap = now - lastMicros;
+
+	lastMicros = now;
+	ticks++;
+
+	return false;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting IRAM_SafeTimer on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	preferences.begin("IRAM_Safe", false);
+
+	// Interval in microsecs
+	if (ITimer0.attachInterruptInterval(TIMER_INTERVAL_US, TimerHandler0))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+
+	Serial.flush();
+}
+
+void loop()
+{
+	static uint32_t counter = 0;
+
+	// Each write disables the flash cache during the NVS page write / erase
+	for (uint8_t i = 0; i < 20; i++)
+		preferences.putUInt("counter", counter++);
+
+	noInterrupts();
+
+	uint32_t gap      = maxGap;
+	uint32_t numTicks = ticks;
+
+	maxGap  = 0;
+
+	interrupts();
+
+	Serial.print(F("ticks = "));
+	Serial.print(numTicks);
+	Serial.print(F(", longest gap (us) = "));
+	Serial.println(gap);
+
+	delay(1000);
+}
@@ -0,0 +1,127 @@
+/****************************************************************************************************************************
+  ISR_Timer_DeepSleep.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Demonstrate how to keep the ISR_Timer schedule across deep sleep. The schedule is saved into RTC memory before
+  sleeping, then restored at wake-up instead of re-creating the timers in setup(), so every timer keeps its phase.
+*****************************************************************************************************************************/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#include "TimerInterrupt_Generic.h"
+#include "ISR_Timer_Generic.h"
+
+#include <sys/time.h>
+
+#define HW_TIMER_INTERVAL_MS          10L
+
+#define TIMER_INTERVAL_1S             1000L
+#define TIMER_INTERVAL_3S             3000L
+
+// Awake for AWAKE_TIME_MS, then deep sleep for SLEEP_TIME_MS
+#define AWAKE_TIME_MS                 2500L
+#define SLEEP_TIME_MS                 4200L
+
+// Kept in RTC slow memory during deep sleep
+RTC_DATA_ATTR ISR_Timer::state_t savedState;
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ISR_Timer
+ISR_Timer ESP32_ISR_Timer;
+
+volatile uint32_t count1S = 0;
+volatile uint32_t count3S = 0;
+
+// The system time is kept by the RTC during deep sleep
+uint32_t persistentMillis()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (uint32_t) ( (uint64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000 );
+}
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	ESP32_ISR_Timer.run();
+
+	return true;
+}
+
+void doingSomething1S()
+{
+	count1S++;
+}
+
+void doingSomething3S()
+{
+	count3S++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	Serial.print(F("\nStarting ISR_Timer_DeepSleep on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_MS * 1000, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	// Only a cold boot or a new firmware has to build the schedule
+	if (ESP32_ISR_Timer.restoreState(savedState, persistentMillis()))
+	{
+		Serial.println(F("Schedule restored from RTC memory"));
+	}
+	else
+	{
+		Serial.println(F("No valid saved schedule, creating timers"));
+
+		ESP32_ISR_Timer.setInterval(TIMER_INTERVAL_1S, doingSomething1S);
+		ESP32_ISR_Timer.setInterval(TIMER_INTERVAL_3S, doingSomething3S);
+	}
+}
+
+void loop()
+{
+	if (millis() > AWAKE_TIME_MS)
+	{
+		Serial.print(F("count1S = "));
+		Serial.print(count1S);
+		Serial.print(F(", count3S = "));
+		Serial.println(count3S);
+
+		ESP32_ISR_Timer.saveState(savedState, persistentMillis());
+
+		Serial.println(F("Going to deep sleep"));
+		Serial.flush();
+
+		esp_sleep_enable_timer_wakeup(SLEEP_TIME_MS * 1000ULL);
+		esp_deep_sleep_start();
+	}
+
+	delay(10);
+}
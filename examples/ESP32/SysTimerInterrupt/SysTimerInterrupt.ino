@@ -0,0 +1,93 @@
+/****************************************************************************************************************************
+  SysTimerInterrupt.ino
+  For ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  ESP32_C3 has only 2 group timers. ESP32SysTimer adds a timer on a free alarm of the 52-bit, 16 MHz SYSTIMER, with the
+  same API. The other SYSTIMER alarms are the FreeRTOS tick and esp_timer: on ESP32_C3, alarm 1 is free.
+  On ESP32_S3, an alarm is free only with FreeRTOS on a single core, see SYSTIMER_FREE_ALARMS.
+*****************************************************************************************************************************/
+
+#if !( defined(ESP32) && ( ARDUINO_ESP32C3_DEV || ARDUINO_ESP32S3_DEV ) )
+	#error This code is intended to run on the ESP32_S3 or ESP32_C3 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+#include "TimerInterrupt_Generic.h"
+
+#define PIN_D3               3        // Pin D3 mapped to pin GPIO3
+
+// Group timers 0 and 1, and SYSTIMER alarm 1
+ESP32Timer    ITimer0(0);
+ESP32Timer    ITimer1(1);
+ESP32SysTimer ISysTimer1(1);
+
+volatile uint32_t counts[2] = { 0, 0 };
+
+bool IRAM_ATTR CountHandler(void * context)
+{
+	(*(volatile uint32_t *) context)++;
+
+	return false;
+}
+
+bool IRAM_ATTR ToggleHandler(void * context)
+{
+	static bool toggle = false;
+
+	(void) context;
+
+	digitalWrite(PIN_D3, toggle);
+	toggle = !toggle;
+
+	return false;
+}
+
+void setup()
+{
+	pinMode(PIN_D3, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting SysTimerInterrupt on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+
+	// Interval in microsecs
+	ITimer0.attachInterruptInterval(1000, CountHandler, (void *) &counts[0]);
+	ITimer1.attachInterruptInterval(100000, CountHandler, (void *) &counts[1]);
+
+	// 25 us, at 16 MHz: no period error
+	if (ISysTimer1.attachInterruptInterval(25, ToggleHandler))
+	{
+		Serial.print(F("Starting  ISysTimer1 OK, achieved frequency (Hz) = "));
+		Serial.println(ISysTimer1.getAchievedFrequency(), 3);
+	}
+	else
+		Serial.println(F("Can't set ISysTimer1. Check SYSTIMER_FREE_ALARMS"));
+
+	Serial.flush();
+}
+
+void loop()
+{
+	Serial.print(F("ITimer0 = "));
+	Serial.print(counts[0]);
+	Serial.print(F(", ITimer1 = "));
+	Serial.print(counts[1]);
+	Serial.print(F(", ISysTimer1 missed periods = "));
+	Serial.println(ISysTimer1.getMissedPeriods());
+
+	delay(2000);
+}
@@ -0,0 +1,129 @@
+/****************************************************************************************************************************
+  TimerContext.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  One callback for all the timers: attachInterruptInterval(interval, callback, context) calls callback(context) from
+  the ISR, where context points to the state of each timer, without global table nor switch on the timer number.
+  A member function can also be the callback: attachInterruptInterval(interval, &object, &Class::method).
+*****************************************************************************************************************************/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+#include "TimerInterrupt_Generic.h"
+
+// Don't use PIN_D1 in core v2.0.0 and v2.0.1. Check https://github.com/espressif/arduino-esp32/issues/5868
+// Don't use PIN_D2 with ESP32_C3 (crash)
+#define PIN_D19             19        // Pin D19 mapped to pin GPIO9 of ESP32
+#define PIN_D3               3        // Pin D3 mapped to pin GPIO3/RX0 of ESP32
+
+// State of each blinking pin, in DRAM
+typedef struct
+{
+	uint8_t           pin;
+	bool              level;
+	volatile uint32_t count;
+} Blinker;
+
+Blinker blinkers[] = { { PIN_D19, false, 0 }, { PIN_D3, false, 0 } };
+
+// One callback for the timers, context => its Blinker
+bool IRAM_ATTR BlinkHandler(void * context)
+{
+	Blinker * blinker = (Blinker *) context;
+
+	digitalWrite(blinker->pin, blinker->level);
+	blinker->level = !blinker->level;
+	blinker->count++;
+
+	return false;
+}
+
+// Member function callback
+class Counter
+{
+	public:
+
+		volatile uint32_t count = 0;
+
+		bool IRAM_ATTR tick()
+		{
+			count++;
+
+			return false;
+		}
+};
+
+Counter counter;
+
+ESP32Timer ITimer0(0);
+ESP32Timer ITimer1(1);
+
+#if (MAX_ESP32_NUM_TIMERS > 2)
+	ESP32Timer ITimer2(2);
+#endif
+
+void setup()
+{
+	pinMode(PIN_D19, OUTPUT);
+	pinMode(PIN_D3,  OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting TimerContext on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if ( ITimer0.attachInterruptInterval(500000, BlinkHandler, &blinkers[0]) &&
+	     ITimer1.attachInterruptInterval(200000, BlinkHandler, &blinkers[1]) )
+	{
+		Serial.print(F("Starting  ITimer0 and ITimer1 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0 or ITimer1. Select another freq. or timer"));
+
+#if (MAX_ESP32_NUM_TIMERS > 2)
+
+	if (ITimer2.attachInterruptInterval(1000, &counter, &Counter::tick))
+	{
+		Serial.print(F("Starting  ITimer2 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer2. Select another freq. or timer"));
+
+#endif
+
+	Serial.flush();
+}
+
+void loop()
+{
+	Serial.print(F("Blinks = "));
+	Serial.print(blinkers[0].count);
+	Serial.print(F(", "));
+	Serial.print(blinkers[1].count);
+	Serial.print(F(", counter = "));
+	Serial.println(counter.count);
+
+	delay(2000);
+}
@@ -110,6 +110,10 @@ void setup()
 	{
 		Serial.print(F("Starting  ITimer0 OK, millis() = "));
 		Serial.println(millis());
+		Serial.print(F("Divider = "));
+		Serial.print(ITimer0.getDivider());
+		Serial.print(F(", achieved frequency (Hz) = "));
+		Serial.println(ITimer0.getAchievedFrequency(), 6);
 	}
 	else
 		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
@@ -119,6 +123,10 @@ void setup()
 	{
 		Serial.print(F("Starting  ITimer1 OK, millis() = "));
 		Serial.println(millis());
+		Serial.print(F("Divider = "));
+		Serial.print(ITimer1.getDivider());
+		Serial.print(F(", achieved frequency (Hz) = "));
+		Serial.println(ITimer1.getAchievedFrequency(), 6);
 	}
 	else
 		Serial.println(F("Can't set ITimer1. Select another freq. or timer"));
@@ -0,0 +1,117 @@
+/****************************************************************************************************************************
+  Waveform.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Hardware waveforms, no interrupt per edge:
+  1) a 1 kHz, 25% PWM from the LEDC on PIN_PWM
+  2) a gap-free stream of pulses from the RMT on PIN_PULSES, from 2 pulse tables: while one is sent, the other one is
+     filled again by loop(), here with a chirp, each pulse 1 us shorter than the previous one
+
+  EXPERIMENTAL: the RMT pulse stream has not been tested on hardware yet
+*****************************************************************************************************************************/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+#include "TimerInterrupt_Generic.h"
+#include "ESP32Waveform_Generic.h"
+
+#define PIN_PWM               2
+#define PIN_PULSES            3
+
+#define LEDC_CHANNEL          0
+#define RMT_CHANNEL           0
+
+#define PULSES_PER_TABLE      256
+
+// Pulse tables, copied into the RMT RAM by its interrupt
+esp32_pulse_t pulseTables[2][PULSES_PER_TABLE];
+
+volatile bool tableFree[2] = { true, true };
+
+ESP32Waveform PWM(PIN_PWM, LEDC_CHANNEL);
+ESP32Waveform Pulses(PIN_PULSES, RMT_CHANNEL);
+
+// From the RMT interrupt
+void IRAM_ATTR PulsesDone(const esp32_pulse_t* table)
+{
+	tableFree[(table == pulseTables[0]) ? 0 : 1] = true;
+}
+
+void fillTable(esp32_pulse_t* table)
+{
+	static uint16_t width = 500;
+
+	for (uint16_t i = 0; i < PULSES_PER_TABLE; i++)
+	{
+		// us, as the default RMT tick is 1 us
+		table[i].level0     = 1;
+		table[i].duration0  = width;
+		table[i].level1     = 0;
+		table[i].duration1  = width;
+
+		width = (width > 10) ? width - 1 : 500;
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Waveform on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+
+	if (PWM.setPWM(1000.0f, 25.0f))
+	{
+		Serial.print(F("PWM OK, frequency (Hz) = "));
+		Serial.println(PWM.getWaveformFrequency(), 3);
+	}
+	else
+		Serial.println(F("Can't set PWM"));
+
+	Pulses.setPulseDone(PulsesDone);
+}
+
+void loop()
+{
+	static unsigned long lastStats = 0;
+
+	// Double buffering: queue each table again once sent
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		if (tableFree[i])
+		{
+			fillTable(pulseTables[i]);
+			tableFree[i] = false;
+
+			if (!Pulses.queuePulses(pulseTables[i], PULSES_PER_TABLE))
+				tableFree[i] = true;
+		}
+	}
+
+	if (millis() - lastStats >= 5000)
+	{
+		lastStats = millis();
+
+		Serial.print(F("Streaming = "));
+		Serial.print(Pulses.isStreaming());
+		Serial.print(F(", underruns = "));
+		Serial.println(Pulses.getUnderruns());
+	}
+
+	delay(1);
+}
@@ -0,0 +1,142 @@
+/****************************************************************************************************************************
+  TCA_Channels.ino
+  For Arduino megaAVR ATMEGA4809-based boards (UNO WiFi Rev2, NANO_EVERY, etc. )
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  TCA0 as a 16-bit timer with 3 compare channels, each with its own period, plus TCB1 and TCB2 whose clocks
+  (CLK_PER, CLK_PER / 2 or CLK_TCA) are selected from their frequencies.
+  analogWrite() on the TCA0 pins no longer works after ITimerTCA.begin()
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "megaAVR_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// No USING_16MHZ, USING_8MHZ or USING_250KHZ => TCB clock selected for each timer
+
+#define USE_TIMER_0     false
+#define USE_TIMER_1     true
+#define USE_TIMER_2     true
+#define USE_TIMER_3     false
+#define USE_TIMER_TCA   true
+
+#include "TimerInterrupt_Generic.h"
+
+#if !defined(LED_BUILTIN)
+	#define LED_BUILTIN     13
+#endif
+
+volatile uint32_t countTCA[TCA_NUM_CHANNELS];
+volatile uint32_t countTCB1, countTCB2;
+
+void TCAHandler0()
+{
+	countTCA[0]++;
+}
+
+void TCAHandler1()
+{
+	countTCA[1]++;
+}
+
+void TCAHandler2()
+{
+	static bool toggle = false;
+
+	countTCA[2]++;
+
+	digitalWrite(LED_BUILTIN, toggle);
+	toggle = !toggle;
+}
+
+void TCB1Handler()
+{
+	countTCB1++;
+}
+
+void TCB2Handler()
+{
+	countTCB2++;
+}
+
+void printTimer(const char* name, TimerInterrupt& timer)
+{
+	Serial.print(name);
+	Serial.print(F(" clock = "));
+	Serial.print(timer.getClockFrequency());
+	Serial.print(F(" Hz, CCMP = "));
+	Serial.println(timer.get_CCMPValue());
+}
+
+void setup()
+{
+	pinMode(LED_BUILTIN, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting TCA_Channels on "));
+	Serial.println(BOARD_NAME);
+	Serial.println(MEGA_AVR_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Keep the TCA0 prescaler of the core, millis() is clocked from it
+	ITimerTCA.begin();
+
+	Serial.print(F("TCA0 clock = "));
+	Serial.print(ITimerTCA.getClockFrequency());
+	Serial.println(F(" Hz"));
+
+	if ( ITimerTCA.setFrequency(0, 1000, TCAHandler0) && ITimerTCA.setFrequency(1, 3.3, TCAHandler1) &&
+	     ITimerTCA.setInterval(2, 500, TCAHandler2) )
+		Serial.println(F("Starting ITimerTCA channels OK"));
+	else
+		Serial.println(F("Can't set ITimerTCA. Select another freq."));
+
+	// 10kHz => CLK_PER, 200Hz => CLK_PER / 2, 10Hz or less => CLK_TCA
+	ITimer1.init();
+
+	if (ITimer1.attachInterrupt(10000, TCB1Handler))
+		printTimer("ITimer1", ITimer1);
+	else
+		Serial.println(F("Can't set ITimer1. Select another freq. or timer"));
+
+	ITimer2.init();
+
+	if (ITimer2.attachInterrupt(200, TCB2Handler))
+		printTimer("ITimer2", ITimer2);
+	else
+		Serial.println(F("Can't set ITimer2. Select another freq. or timer"));
+}
+
+void loop()
+{
+	static unsigned long lastTime = 0;
+
+	if (millis() - lastTime >= 10000)
+	{
+		lastTime = millis();
+
+		Serial.print(F("TCA0 = "));
+		Serial.print(countTCA[0]);
+		Serial.print(F(", "));
+		Serial.print(countTCA[1]);
+		Serial.print(F(", "));
+		Serial.print(countTCA[2]);
+		Serial.print(F(", TCB1 = "));
+		Serial.print(countTCB1);
+		Serial.print(F(", TCB2 = "));
+		Serial.println(countTCB2);
+	}
+}
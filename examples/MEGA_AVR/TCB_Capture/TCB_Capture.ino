@@ -0,0 +1,113 @@
+/****************************************************************************************************************************
+  TCB_Capture.ino
+  For Arduino megaAVR ATMEGA4809-based boards (UNO WiFi Rev2, NANO_EVERY, etc. )
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  The edges of a pin are routed by EVSYS to a TCB, which measures the period and pulse width in hardware.
+  TCB1 measures both with one interrupt per period. TCB2 measures the period with no interrupt, polled in loop().
+  Connect the PWM output PWM_PIN to CAPTURE_PIN1 and CAPTURE_PIN2 to test.
+ *****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "megaAVR_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// No USING_16MHZ, USING_8MHZ or USING_250KHZ => capture clocked by CLK_TCA, 250kHz, up to 262ms
+
+#define USE_TIMER_0     false
+#define USE_TIMER_1     true
+#define USE_TIMER_2     true
+#define USE_TIMER_3     false
+
+#include "TimerInterrupt_Generic.h"
+
+#define PWM_PIN             5
+#define CAPTURE_PIN1        2
+#define CAPTURE_PIN2        3
+
+volatile uint16_t period1;
+volatile uint16_t pulseWidth1;
+volatile uint32_t captures1;
+
+// Called once per period, after the rising edge ending it
+void CaptureHandler1()
+{
+	pulseWidth1 = ITimer1.readCapture();
+	period1     = ITimer1.getCapturePeriod();
+
+	captures1++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting TCB_Capture on "));
+	Serial.println(BOARD_NAME);
+	Serial.println(MEGA_AVR_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Test signal, 25% duty
+	analogWrite(PWM_PIN, 64);
+
+	ITimer1.init();
+
+	if (ITimer1.beginCapture(CAPTURE_PIN1, TCB_CAPTURE_FREQ_PW, CaptureHandler1))
+		Serial.println(F("Starting ITimer1 capture OK"));
+	else
+		Serial.println(F("Can't start ITimer1 capture. Select another pin"));
+
+	ITimer2.init();
+
+	// No callback => no interrupt. Noise filter on
+	if (ITimer2.beginCapture(CAPTURE_PIN2, TCB_CAPTURE_FREQUENCY, NULL, false, true))
+		Serial.println(F("Starting ITimer2 capture OK"));
+	else
+		Serial.println(F("Can't start ITimer2 capture. Select another pin"));
+}
+
+void loop()
+{
+	static unsigned long lastTime = 0;
+	static uint16_t period2       = 0;
+
+	if (ITimer2.captureAvailable())
+		period2 = ITimer2.readCapture();
+
+	if (millis() - lastTime >= 2000)
+	{
+		lastTime = millis();
+
+		noInterrupts();
+
+		uint16_t period     = period1;
+		uint16_t pulseWidth = pulseWidth1;
+		uint32_t captures   = captures1;
+
+		interrupts();
+
+		float tick = 1000000.0f / ITimer1.getClockFrequency();
+
+		Serial.print(F("TCB1: period = "));
+		Serial.print(period * tick);
+		Serial.print(F("us, pulse width = "));
+		Serial.print(pulseWidth * tick);
+		Serial.print(F("us, captures = "));
+		Serial.print(captures);
+		Serial.print(F(", TCB2: period = "));
+		Serial.print(period2 * 1000000.0f / ITimer2.getClockFrequency());
+		Serial.println(F("us"));
+	}
+}
@@ -0,0 +1,169 @@
+/****************************************************************************************************************************
+  ISR_Timer_Coroutines.ino
+
+  For RP2040-based boards such as RASPBERRY_PI_PICO, ADAFRUIT_FEATHER_RP2040 and GENERIC_RP2040.
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Foreground state machines written as C++20 coroutines, waiting with co_await sleep_for() / next_tick().
+  All the coroutines share one ISR_Timer slot, and are resumed by ISR_Timer_Coro::dispatch() in loop().
+
+  Needs C++20: add -std=gnu++20 to the compiler flags, e.g. in platformio.ini
+    build_unflags = -std=gnu++17
+    build_flags   = -std=gnu++20
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// Up to 16 coroutines alive at the same time, each frame up to 128 bytes
+#define ISR_TIMER_CORO_FRAMES         16
+#define ISR_TIMER_CORO_FRAME_SIZE     128
+
+#include "TimerInterrupt_Generic.h"
+#include "ISR_Timer_Generic.h"
+#include "ISR_Timer_Coro_Generic.h"
+
+// Init RPI_PICO_Timer
+RPI_PICO_Timer ITimer1(1);
+
+ISR_Timer RPI_PICO_ISR_Timer;
+
+ISR_Timer_Coro coro(RPI_PICO_ISR_Timer);
+
+#ifndef LED_BUILTIN
+	#define LED_BUILTIN       25
+#endif
+
+#define TIMER_INTERVAL_MS             1L
+
+#define NUMBER_WORKERS                8
+
+bool TimerHandler(struct repeating_timer *t)
+{
+	(void) t;
+
+	RPI_PICO_ISR_Timer.run();
+
+	return true;
+}
+
+// Blink pattern: 3 short, 3 long, then a pause, as a plain sequential program
+ISR_Timer_Task blinkTask()
+{
+	while (true)
+	{
+		for (uint8_t i = 0; i < 6; i++)
+		{
+			digitalWrite(LED_BUILTIN, HIGH);
+			co_await coro.sleep_for( (i < 3) ? 100 : 400 );
+
+			digitalWrite(LED_BUILTIN, LOW);
+			co_await coro.sleep_for(200);
+		}
+
+		co_await coro.sleep_for(1000);
+	}
+}
+
+// Workers waking up at different periods, without any ISR_Timer slot of their own
+ISR_Timer_Task workerTask(uint8_t id, uint32_t period)
+{
+	uint32_t count = 0;
+
+	while (true)
+	{
+		co_await coro.sleep_for(period);
+
+		if (++count % 10 == 0)
+		{
+			Serial.print(F("Worker "));
+			Serial.print(id);
+			Serial.print(F(", period = "));
+			Serial.print(period);
+			Serial.print(F(", runs = "));
+			Serial.print(count);
+			Serial.print(F(", millis() = "));
+			Serial.println(millis());
+		}
+	}
+}
+
+// Poll a button every tick, with debouncing
+ISR_Timer_Task buttonTask()
+{
+	uint8_t stable = 0;
+
+	pinMode(0, INPUT_PULLUP);
+
+	while (true)
+	{
+		co_await coro.next_tick();
+
+		stable = (digitalRead(0) == LOW) ? stable + 1 : 0;
+
+		if (stable == 20)
+		{
+			Serial.println(F("Button pressed"));
+		}
+	}
+}
+
+void setup()
+{
+	pinMode(LED_BUILTIN, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Coroutines on "));
+	Serial.println(BOARD_NAME);
+	Serial.println(RPI_PICO_TIMER_INTERRUPT_VERSION);
+	Serial.println(TIMER_INTERRUPT_GENERIC_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	if (ITimer1.attachInterruptInterval(TIMER_INTERVAL_MS * 1000, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer1 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer1. Select another freq. or timer"));
+
+	// One ISR_Timer slot for all the coroutines, ticking every 10ms
+	if (!coro.begin(10))
+		Serial.println(F("Can't start ISR_Timer_Coro"));
+
+	if (!blinkTask())
+		Serial.println(F("Can't start blinkTask"));
+
+	for (uint8_t i = 0; i < NUMBER_WORKERS; i++)
+	{
+		if (!workerTask(i, 100 * (i + 1)))
+			Serial.println(F("Can't start workerTask"));
+	}
+
+	if (!buttonTask())
+		Serial.println(F("Can't start buttonTask"));
+
+	Serial.print(F("Coroutines waiting = "));
+	Serial.print(coro.getNumWaiting());
+	Serial.print(F(", free frames = "));
+	Serial.println(ISR_Timer_Coro_Pool::getFreeFrames());
+}
+
+void loop()
+{
+	// Resume the coroutines due since the last call. Never call it from an ISR
+	coro.dispatch();
+}
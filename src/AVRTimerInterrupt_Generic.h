@@ -70,6 +70,7 @@
 
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include "Arduino.h"
 #include "pins_arduino.h"
 
@@ -129,26 +130,203 @@ enum
   T2_NUM_ITEMS
 };
 
-const unsigned int prescalerDiv   [NUM_ITEMS]     = { 1, 1, 8, 64, 256, 1024 };
-const unsigned int prescalerDivT2 [T2_NUM_ITEMS]  = { 1, 1, 8, 32,  64,  128, 256, 1024 };
+// Period planner, see planFrequency(): max error (ppm) of the period, within which the prescaler giving the fewest
+// interrupts per period is selected
+#ifndef TIMER_INTERRUPT_ERROR_BUDGET_PPM
+  #define TIMER_INTERRUPT_ERROR_BUDGET_PPM      100
+#endif
+
+// min CPU cycles of the last chunk of a long period, to be sure its OCR value is written by the ISR before the count gets there
+#ifndef TIMER_INTERRUPT_MIN_CHUNK_CYCLES
+  #define TIMER_INTERRUPT_MIN_CHUNK_CYCLES      256
+#endif
+
+typedef struct
+{
+  unsigned int  prescalerIndex;
+  uint32_t      OCRValue;             // sum of the OCR values of all the chunks of a period
+  uint32_t      OCRChunk;             // max OCR value of a chunk
+  uint32_t      interrupts;           // interrupts per period
+  float         errorPPM;             // error of the period
+} timer_plan_t;
+
+// Timer2 asynchronous mode, clocked from a watch crystal on TOSC1 / TOSC2, see setAsyncClock()
+#if ( defined(ASSR) && defined(AS2) && defined(TCR2BUB) )
+  #define TIMER2_ASYNC_AVAILABLE      true
+#else
+  #define TIMER2_ASYNC_AVAILABLE      false
+#endif
+
+#ifndef TIMER2_ASYNC_CLOCK_HZ
+  #define TIMER2_ASYNC_CLOCK_HZ       32768
+#endif
+
+// Hardware waveforms on the OCnA / OCnB pins, see setSquareWave(), setPWM() and setSinglePulse()
+#define WAVEFORM_CHANNEL_A        0
+#define WAVEFORM_CHANNEL_B        1
+
+#define WAVEFORM_NONE             0
+#define WAVEFORM_SQUARE           1
+#define WAVEFORM_FAST_PWM         2
+#define WAVEFORM_PHASE_PWM        3
+#define WAVEFORM_SINGLE_PULSE     4
+
+// constexpr for the compile-time solver of setFrequency<>()
+constexpr unsigned int prescalerDiv   [NUM_ITEMS]     = { 1, 1, 8, 64, 256, 1024 };
+constexpr unsigned int prescalerDivT2 [T2_NUM_ITEMS]  = { 1, 1, 8, 32,  64,  128, 256, 1024 };
 
 class TimerInterrupt
 {
-  private:
+  protected:
 
     bool            _timerDone;
     int8_t          _timer;
     unsigned int    _prescalerIndex;
     uint32_t        _OCRValue;
     uint32_t        _OCRValueRemaining;
+    uint32_t        _OCRChunk;
     volatile long   _toggle_count;
     double           _frequency;
 
+    uint32_t        _errorBudgetPPM;
+    uint32_t        _interruptsPerPeriod;
+    float           _errorPPM;
+
     void*           _callback;        // pointer to the callback function
     void*           _params;          // function parameter
 
+    uint8_t         _waveformMode;
+    uint16_t        _waveformTop;
+    float           _waveformFrequency;
+
+    uint32_t        _clockFreq;       // timer clock before the prescaler
+    bool            _asyncClock;      // Timer2 clocked from TOSC1
+
+    bool            _nestedCallback;    // callback run with the interrupts enabled, see setNestedCallback()
+    volatile bool   _inNestedCallback;
+    volatile bool   _nestedDetached;    // detachInterrupt() called by the nested callback
+
     ///////////////////////////////////////////
 
+    // Asynchronous Timer2: wait until the last writes to TCNT2, OCR2x and TCCR2x are done in the TOSC1 clock domain.
+    // A register written again before that may be corrupted
+    void waitAsyncUpdate() __attribute__((always_inline))
+    {
+#if TIMER2_ASYNC_AVAILABLE
+
+      if (_asyncClock)
+      {
+        while ( ASSR & ( bit(TCN2UB) | bit(OCR2AUB) | bit(OCR2BUB) | bit(TCR2AUB) | bit(TCR2BUB) ) );
+      }
+
+#endif
+    }
+
+    // In CTC mode, TCNTn is cleared on the timer clock after the compare match. With a prescaler, the ISR runs before
+    // that clock, and writing another OCRnA then cancels the clear: TCNTn counts on up to the new OCRnA, or up to MAX.
+    // TCNTn = MAX keeps the period exact, as the next timer clock wraps it to 0 anyway.
+    // Asynchronous Timer2 doesn't need it, its OCR2A being latched two TOSC1 clocks after the write
+    void keepPendingClear() __attribute__((always_inline))
+    {
+      switch (_timer)
+      {
+#if defined(OCR1A)
+
+        case 1:
+          if (TCNT1 == OCR1A)
+            TCNT1 = MAX_COUNT_16BIT;
+
+          break;
+#endif
+
+#if defined(OCR2A)
+
+        case 2:
+          if (!_asyncClock && (TCNT2 == OCR2A))
+            TCNT2 = MAX_COUNT_8BIT;
+
+          break;
+#endif
+
+#if defined(OCR3A)
+
+        case 3:
+          if (TCNT3 == OCR3A)
+            TCNT3 = MAX_COUNT_16BIT;
+
+          break;
+#endif
+
+#if defined(OCR4A) && !TIMER_INTERRUPT_USING_ATMEGA_32U4
+
+        case 4:
+          if (TCNT4 == OCR4A)
+            TCNT4 = MAX_COUNT_16BIT;
+
+          break;
+#endif
+
+#if defined(OCR5A)
+
+        case 5:
+          if (TCNT5 == OCR5A)
+            TCNT5 = MAX_COUNT_16BIT;
+
+          break;
+#endif
+      }
+    }
+
+    void callUser() __attribute__((always_inline))
+    {
+      if (_params != NULL)
+        (*(timer_callback_p)_callback)(_params);
+      else
+        (*(timer_callback)_callback)();
+    }
+
+    // Mask / unmask the compare interrupt of the timer. Run with noInterrupt()
+    void writeCompareInterrupt(const bool& enable)
+    {
+      switch (_timer)
+      {
+#if defined(TIMSK1) && defined(OCIE1A)
+
+        case 1:
+          bitWrite(TIMSK1, OCIE1A, enable);
+          break;
+#endif
+
+#if defined(TIMSK2) && defined(OCIE2A)
+
+        case 2:
+          bitWrite(TIMSK2, OCIE2A, enable);
+          break;
+#endif
+
+#if defined(TIMSK3) && defined(OCIE3A)
+
+        case 3:
+          bitWrite(TIMSK3, OCIE3A, enable);
+          break;
+#endif
+
+#if defined(TIMSK4) && defined(OCIE4A)
+
+        case 4:
+          bitWrite(TIMSK4, OCIE4A, enable);
+          break;
+#endif
+
+#if defined(TIMSK5) && defined(OCIE5A)
+
+        case 5:
+          bitWrite(TIMSK5, OCIE5A, enable);
+          break;
+#endif
+      }
+    }
+
     void set_OCR()
     {
       // Run with noInterrupt()
@@ -160,7 +338,7 @@ class TimerInterrupt
       switch (_timer)
       {
         case 1:
-          _OCRValueToUse = min(MAX_COUNT_16BIT, _OCRValueRemaining);
+          _OCRValueToUse = min(_OCRChunk, _OCRValueRemaining);
           OCR1A = _OCRValueToUse;
           _OCRValueRemaining -= _OCRValueToUse;
 
@@ -179,7 +357,11 @@ class TimerInterrupt
 #if defined(OCR2A) && defined(TIMSK2) && defined(OCIE2A)
 
         case 2:
-          _OCRValueToUse = min(MAX_COUNT_8BIT, _OCRValueRemaining);
+          _OCRValueToUse = min(_OCRChunk, _OCRValueRemaining);
+
+          // Asynchronous => the previous OCR2A value must be in the TOSC1 clock domain before writing a new one
+          waitAsyncUpdate();
+
           OCR2A = _OCRValueToUse;
           _OCRValueRemaining -= _OCRValueToUse;
 
@@ -190,7 +372,7 @@ class TimerInterrupt
 #if defined(OCR3A) && defined(TIMSK3) && defined(OCIE3A)
 
         case 3:
-          _OCRValueToUse = min(MAX_COUNT_16BIT, _OCRValueRemaining);
+          _OCRValueToUse = min(_OCRChunk, _OCRValueRemaining);
           OCR3A = _OCRValueToUse;
           _OCRValueRemaining -= _OCRValueToUse;
 
@@ -202,12 +384,8 @@ class TimerInterrupt
 
         case 4:
 
-#if TIMER_INTERRUPT_USING_ATMEGA_32U4
-          _OCRValueToUse = min(MAX_COUNT_8BIT, _OCRValueRemaining);
-#else
-          _OCRValueToUse = min(MAX_COUNT_16BIT, _OCRValueRemaining);
-#endif
-
+          // _OCRChunk <= MAX_COUNT_8BIT for the 32u4
+          _OCRValueToUse = min(_OCRChunk, _OCRValueRemaining);
           OCR4A = _OCRValueToUse;
           _OCRValueRemaining -= _OCRValueToUse;
 
@@ -218,7 +396,7 @@ class TimerInterrupt
 #if defined(OCR5A) && defined(TIMSK5) && defined(OCIE5A)
 
         case 5:
-          _OCRValueToUse = min(MAX_COUNT_16BIT, _OCRValueRemaining);
+          _OCRValueToUse = min(_OCRChunk, _OCRValueRemaining);
           OCR5A = _OCRValueToUse;
           _OCRValueRemaining -= _OCRValueToUse;
 
@@ -235,819 +413,2295 @@ class TimerInterrupt
 
     ///////////////////////////////////////////
 
-  public:
-
-    TimerInterrupt()
+    // Load the prescaler and OCR values, then start the timer. No float operation, so that the compile-time
+    // setFrequency<>() / attachInterruptInterval<>() don't link any soft-float code
+    void setTimerRegisters(const timer_plan_t& plan, void* callback, void* params)
     {
-      _timer              = -1;
-      _frequency          = 0;
-      _callback           = NULL;
-      _params             = NULL;
-      _timerDone          = false;
-      _prescalerIndex     = NO_PRESCALER;
-      _OCRValue           = 0;
-      _OCRValueRemaining  = 0;
-      _toggle_count       = -1;
-    };
+      uint8_t andMask = 0b11111000;
 
-    explicit TimerInterrupt(uint8_t timerNo)
-    {
-      _timer              = timerNo;
-      _frequency          = 0;
-      _callback           = NULL;
-      _params             = NULL;
-      _timerDone          = false;
-      _prescalerIndex     = NO_PRESCALER;
-      _OCRValue           = 0;
-      _OCRValueRemaining  = 0;
-      _toggle_count       = -1;
-    };
+      //cli();//stop interrupts
+      noInterrupts();
 
-    void callback() __attribute__((always_inline))
-    {
-      if (_callback != NULL)
-      {
-        if (_params != NULL)
-          (*(timer_callback_p)_callback)(_params);
-        else
-          (*(timer_callback)_callback)();
-      }
-    }
+      _prescalerIndex       = plan.prescalerIndex;
+      _OCRValue             = plan.OCRValue;
+      _OCRValueRemaining    = plan.OCRValue;
+      _OCRChunk             = plan.OCRChunk;
+      _interruptsPerPeriod  = plan.interrupts;
+      _errorPPM             = plan.errorPPM;
+      _callback             = callback;
+      _params             = params;
 
-    void init(int8_t timer)
-    {
-      // Set timer specific stuff
-      // All timers in CTC mode
-      // 8 bit timers will require changing prescalar values,
-      // whereas 16 bit timers are set to either ck/1 or ck/64 prescalar
+      _timerDone = false;
 
-      //cli();//stop interrupts
-      noInterrupts();
+      // 8 bit timers from here
+#if defined(TCCR2B)
 
-      switch (timer)
+      if (_timer == 2)
       {
-#if defined(TCCR1A) && defined(TCCR1B) && defined(WGM12)
+        waitAsyncUpdate();
 
-        case 1:
-          // 16 bit timer
-          TCCR1A = 0;
-          TCCR1B = 0;
-          // Page 172-173. ATmega 328/328P or Page 145-146 of ATmega 640/1280/2560
-          // Mode 4 => Clear Timer on Compare match (CTC) using OCR1A for counter value
-          bitWrite(TCCR1B, WGM12, 1);
-          // No scaling now
-          bitWrite(TCCR1B, CS10, 1);
+        TCCR2B = (TCCR2B & andMask) | _prescalerIndex;   //prescalarbits;
 
-          TISR_LOGWARN(F("T1"));
+        TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
+      }
 
-          break;
 #endif
 
-#if defined(TCCR2A) && defined(TCCR2B)
-
-        case 2:
-          // 8 bit timer
-          TCCR2A = 0;
-          TCCR2B = 0;
-          // Page 205-206. ATmegal328, Page 184-185 ATmega 640/1280/2560
-          // Mode 2 => Clear Timer on Compare match (CTC) using OCR2A for counter value
-          bitWrite(TCCR2A, WGM21, 1);
-          // No scaling now
-          bitWrite(TCCR2B, CS20, 1);
-
-          TISR_LOGWARN(F("T2"));
+      // 16 bit timers from here
+#if defined(TCCR1B)
+#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
 
-          break;
+      if (_timer == 1)
+#else
+      else if (_timer == 1)
 #endif
+      {
+        TCCR1B = (TCCR1B & andMask) | _prescalerIndex;   //prescalarbits;
 
-#if defined(TCCR3A) && defined(TCCR3B) &&  defined(TIMSK3)
+        TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
+      }
 
-        case 3:
-          // 16 bit timer
-          TCCR3A = 0;
-          TCCR3B = 0;
-          bitWrite(TCCR3B, WGM32, 1);
-          bitWrite(TCCR3B, CS30, 1);
+#endif
 
-          TISR_LOGWARN(F("T3"));
+#if defined(TCCR3B)
+      else if (_timer == 3)
+        TCCR3B = (TCCR3B & andMask) | _prescalerIndex;   //prescalarbits;
 
-          break;
 #endif
 
-#if defined(TCCR4A) && defined(TCCR4B) &&  defined(TIMSK4)
+#if defined(TCCR4B)
+      else if (_timer == 4)
+        TCCR4B = (TCCR4B & andMask) | _prescalerIndex;   //prescalarbits;
 
-        case 4:
-          // 16 bit timer
-          TCCR4A = 0;
-          TCCR4B = 0;
-#if defined(WGM42)
-          bitWrite(TCCR4B, WGM42, 1);
-#elif defined(CS43)
-          // TODO this may not be correct
-          // atmega32u4
-          bitWrite(TCCR4B, CS43, 1);
 #endif
-          bitWrite(TCCR4B, CS40, 1);
 
-          TISR_LOGWARN(F("T4"));
+#if defined(TCCR5B)
+      else if (_timer == 5)
+        TCCR5B = (TCCR5B & andMask) | _prescalerIndex;   //prescalarbits;
 
-          break;
 #endif
 
-#if defined(TCCR5A) && defined(TCCR5B) &&  defined(TIMSK5)
-
-        case 5:
-          // 16 bit timer
-          TCCR5A = 0;
-          TCCR5B = 0;
-          bitWrite(TCCR5B, WGM52, 1);
-          bitWrite(TCCR5B, CS50, 1);
+      // Set the OCR for the given timer,
+      // set the toggle count,
+      // then turn on the interrupts
+      set_OCR();
 
-          TISR_LOGWARN(F("T5"));
+#if TIMER2_ASYNC_AVAILABLE
 
-          break;
-#endif
+      // Asynchronous Timer2: wait for the new values to be in the TOSC1 clock domain, then clear the flags
+      // that could have been raised meanwhile
+      if (_asyncClock)
+      {
+        waitAsyncUpdate();
+        TIFR2 = bit(OCF2A) | bit(OCF2B) | bit(TOV2);
       }
 
-      _timer = timer;
+#endif
 
-      //sei();//enable interrupts
+      //sei();//allow interrupts
       interrupts();
-
     }
 
     ///////////////////////////////////////////
 
-    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // bool setFrequency(float frequency, timer_callback_p callback, /* void* */ uint32_t params, unsigned long duration = 0);
-
-    // frequency (in hertz) and duration (in milliseconds).
-    // Return true if frequency is OK with selected timer (OCRValue is in range)
-    bool setFrequency(float frequency, timer_callback_p callback, uint32_t params, unsigned long duration = 0)
+    // max OCR value of the timer
+    uint32_t getMaxCount()
     {
-      uint8_t       andMask = 0b11111000;
-      unsigned long OCRValue;
-      bool isSuccess = false;
+#if TIMER_INTERRUPT_USING_ATMEGA_32U4
 
-      //frequencyLimit must > 1
-      float frequencyLimit = frequency * 17179.840;
+      if (_timer == 4)
+        return MAX_COUNT_8BIT;
 
-      // Limit frequency to larger than (0.00372529 / 64) Hz or interval 17179.840s / 17179840 ms to avoid uint32_t overflow
-      if ((_timer <= 0) || (callback == NULL) || ((frequencyLimit) < 1) )
-      {
-        return false;
-      }
-      else
-      {
-        // Calculate the toggle count. Duration must be at least longer then one cycle
-        if (duration > 0)
-        {
-          _toggle_count = frequency * duration / 1000;
-
-          TISR_LOGWARN1(F("setFrequency => _toggle_count ="), _toggle_count);
-          TISR_LOGWARN3(F("Frequency ="), frequency, F(", duration ="), duration);
-
-          if (_toggle_count < 1)
-          {
-            return false;
-          }
-        }
-        else
-        {
-          _toggle_count = -1;
-        }
-
-        //Timer0 and timer2 are 8 bit timers, meaning they can store a maximum counter value of 255.
-        //Timer2 does not have the option of 1024 prescaler, only 1, 8, 32, 64
-        //Timer1 is a 16 bit timer, meaning it can store a maximum counter value of 65535.
-        int prescalerIndexStart;
+#endif
 
-        //Use smallest prescaler first, then increase until fits (<255)
-        if (_timer != 2)
-        {
-          if (frequencyLimit > 64)
-            prescalerIndexStart = NO_PRESCALER;
-          else if (frequencyLimit > 8)
-            prescalerIndexStart = PRESCALER_8;
-          else
-            prescalerIndexStart = PRESCALER_64;
+      return (_timer == 2) ? MAX_COUNT_8BIT : MAX_COUNT_16BIT;
+    }
 
+    // Largest chunk (OCR value <= maxCount) for a period of 'ticks' timer ticks. A period is loaded min(chunk, remaining)
+    // at a time, each compare taking OCR + 1 ticks, so the period is exact unless its last chunk is a single tick.
+    // That last chunk, written by the ISR, must also be long enough (minTicks) not to be missed
+    static uint32_t planChunk(const uint32_t& ticks, const uint32_t& maxCount, const uint32_t& minTicks)
+    {
+      uint32_t chunk = maxCount;
 
-          for (int prescalerIndex = prescalerIndexStart; prescalerIndex <= PRESCALER_1024; prescalerIndex++)
-          {
-            OCRValue = F_CPU / (frequency * prescalerDiv[prescalerIndex]) - 1;
+      while ( (ticks > chunk + 1) && (chunk > maxCount / 2) && ( (ticks % (chunk + 1)) != 0 )
+              && ( (ticks % (chunk + 1)) < minTicks ) )
+      {
+        chunk--;
+      }
 
-            TISR_LOGWARN1(F("Freq * 1000 ="), frequency * 1000);
-            TISR_LOGWARN3(F("F_CPU ="), F_CPU, F(", preScalerDiv ="), prescalerDiv[prescalerIndex]);
-            TISR_LOGWARN3(F("OCR ="), OCRValue, F(", preScalerIndex ="), prescalerIndex);
+      return chunk;
+    }
 
-            // We use very large _OCRValue now, and every time timer ISR activates, we deduct min(MAX_COUNT_16BIT, _OCRValueRemaining) from _OCRValueRemaining
-            // So that we can create very long timer, even if the counter is only 16-bit.
-            // Use very high frequency (OCRValue / MAX_COUNT_16BIT) around 16 * 1024 to achieve higher accuracy
-#if TIMER_INTERRUPT_USING_ATMEGA_32U4
-            uint16_t MAX_COUNT_32U4 = (_timer == 4) ? MAX_COUNT_8BIT : MAX_COUNT_16BIT;
+    // Plan a period of 1 / frequency s: among the prescalers, the one giving the fewest interrupts per period within
+    // _errorBudgetPPM, else the one giving the smallest error. singleCompare => only the periods of one compare, as
+    // needed by the hardware waveforms. Returns false if no prescaler can make it
+    bool planFrequency(const float& frequency, timer_plan_t& plan, const bool& singleCompare = false)
+    {
+      const unsigned int* divider   = (_timer == 2) ? prescalerDivT2 : prescalerDiv;
+      uint8_t             lastIndex = (_timer == 2) ? (uint8_t) T2_PRESCALER_1024 : (uint8_t) PRESCALER_1024;
+      uint32_t            maxCount  = getMaxCount();
+      bool                found     = false;
+      bool                bestInBudget = false;
+
+      // NO_PRESCALER == T2_NO_PRESCALER
+      for (uint8_t index = NO_PRESCALER; index <= lastIndex; index++)
+      {
+        float ideal = (float) _clockFreq / (frequency * divider[index]);
 
-            if ( (OCRValue / MAX_COUNT_32U4) < 16384 )
-#else
-            if ( (OCRValue / MAX_COUNT_16BIT) < 16384 )
-#endif
-            {
-              _OCRValue           = OCRValue;
-              _OCRValueRemaining  = OCRValue;
-              _prescalerIndex = prescalerIndex;
+        // OCR value >= 1 and period in uint32_t
+        if ( (ideal < 1.5f) || (ideal >= 4294967040.0f) )
+          continue;
 
-              TISR_LOGWARN1(F("OK in loop => _OCR ="), _OCRValue);
-              TISR_LOGWARN3(F("_preScalerIndex ="), _prescalerIndex, F(", preScalerDiv ="), prescalerDiv[_prescalerIndex]);
+        uint32_t  ticks       = (uint32_t) (ideal + 0.5f);
 
-              isSuccess = true;
+        if (singleCompare && (ticks > maxCount + 1))
+          continue;
 
-              break;
-            }
-          }
+        float     error       = fabs(ticks - ideal) * 1000000.0f / ideal;
+        // TIMER_INTERRUPT_MIN_CHUNK_CYCLES CPU cycles in timer ticks
+        uint32_t  minTicks    = max(2UL, (uint32_t) ( (float) TIMER_INTERRUPT_MIN_CHUNK_CYCLES * _clockFreq /
+                                                      ( (float) F_CPU * divider[index] ) + 0.999f ) );
+        uint32_t  chunk       = planChunk(ticks, maxCount, minTicks);
+        uint32_t  interrupts  = ticks / (chunk + 1) + ( (ticks % (chunk + 1)) ? 1 : 0 );
+        bool      inBudget    = (error <= _errorBudgetPPM);
 
-          if (!isSuccess)
-          {
-            // Always do this
-            _OCRValue           = OCRValue;
-            _OCRValueRemaining  = OCRValue;
-            _prescalerIndex = PRESCALER_1024;
+        TISR_LOGWARN3(F("Plan: preScalerDiv ="), divider[index], F(", ticks ="), ticks);
+        TISR_LOGWARN3(F("Plan: interrupts ="), interrupts, F(", error ppm ="), error);
 
-            TISR_LOGWARN1(F("OK out loop => _OCR ="), _OCRValue);
-            TISR_LOGWARN3(F("_preScalerIndex ="), _prescalerIndex, F(", preScalerDiv ="), prescalerDiv[_prescalerIndex]);
-          }
-        }
-        else
+        if ( !found || (inBudget && !bestInBudget) ||
+             ( (inBudget == bestInBudget) && ( inBudget ?
+                                               ( (interrupts < plan.interrupts) || ( (interrupts == plan.interrupts) && (error < plan.errorPPM) ) ) :
+                                               ( (error < plan.errorPPM) || ( (error == plan.errorPPM) && (interrupts < plan.interrupts) ) ) ) ) )
         {
-          if (frequencyLimit > 64)
-            prescalerIndexStart = T2_NO_PRESCALER;
-          else if (frequencyLimit > 8)
-            prescalerIndexStart = T2_PRESCALER_8;
-          else if (frequencyLimit > 2)
-            prescalerIndexStart = T2_PRESCALER_32;
-          else
-            prescalerIndexStart = T2_PRESCALER_64;
-
-          // Page 206-207. ATmegal328
-          //8-bit Timer2 has more options up to 1024 prescaler, from 1, 8, 32, 64, 128, 256 and 1024
-          for (int prescalerIndex = prescalerIndexStart; prescalerIndex <= T2_PRESCALER_1024; prescalerIndex++)
-          {
-            OCRValue = F_CPU / (frequency * prescalerDivT2[prescalerIndex]) - 1;
-
-            TISR_LOGWARN3(F("F_CPU ="), F_CPU, F(", preScalerDiv ="), prescalerDivT2[prescalerIndex]);
-            TISR_LOGWARN3(F("OCR2 ="), OCRValue, F(", preScalerIndex ="), prescalerIndex);
+          // sum of the OCR values of the chunks, each chunk taking OCR + 1 ticks
+          plan.prescalerIndex = index;
+          plan.OCRValue       = ticks - interrupts;
+          plan.OCRChunk       = chunk;
+          plan.interrupts     = interrupts;
+          plan.errorPPM       = error;
+
+          found         = true;
+          bestInBudget  = inBudget;
+        }
+      }
 
-            // We use very large _OCRValue now, and every time timer ISR activates, we deduct min(MAX_COUNT_8BIT, _OCRValue) from _OCRValue
-            // to create very long timer, even if the counter is only 16-bit.
-            // Use very high frequency (OCRValue / MAX_COUNT_8BIT) around 16 * 1024 to achieve higher accuracy
-            if ( (OCRValue / MAX_COUNT_8BIT) < 16384 )
-            {
-              _OCRValue           = OCRValue;
-              _OCRValueRemaining  = OCRValue;
-              // same as prescalarbits
-              _prescalerIndex = prescalerIndex;
+      return found;
+    }
 
-              TISR_LOGWARN1(F("OK in loop => _OCR ="), _OCRValue);
-              TISR_LOGWARN3(F("_preScalerIndex ="), _prescalerIndex, F(", preScalerDiv ="), prescalerDivT2[_prescalerIndex]);
+    ///////////////////////////////////////////
 
-              isSuccess = true;
+    // Load the waveform registers and start the timer. The compare interrupt is disabled, the pins are driven by the
+    // compare-match hardware only. top is OCRnA (CTC and Timer2 PWM) or ICRn (16-bit PWM)
+    void setWaveformRegisters(const uint8_t& controlA, const uint8_t& controlB, const uint16_t& top,
+                              const uint16_t& compareA, const uint16_t& compareB)
+    {
+      //cli();//stop interrupts
+      noInterrupts();
 
-              break;
-            }
-          }
+      switch (_timer)
+      {
+#if defined(TCCR1A) && defined(ICR1) && defined(OCR1B)
 
-          if (!isSuccess)
-          {
-            // Always do this
-            _OCRValue           = OCRValue;
-            _OCRValueRemaining  = OCRValue;
-            // same as prescalarbits
-            _prescalerIndex = T2_PRESCALER_1024;
-
-            TISR_LOGWARN1(F("OK out loop => _OCR ="), _OCRValue);
-            TISR_LOGWARN3(F("_preScalerIndex ="), _prescalerIndex, F(", preScalerDiv ="), prescalerDivT2[_prescalerIndex]);
-          }
-        }
+        case 1:
+          TCCR1B  = 0;
+          TCCR1A  = controlA;
+          ICR1    = top;
+          OCR1A   = compareA;
+          OCR1B   = compareB;
+          TCNT1   = 0;
+          bitWrite(TIMSK1, OCIE1A, 0);
+          TCCR1B  = controlB;
+          break;
+#endif
 
-        //cli();//stop interrupts
-        noInterrupts();
+#if defined(TCCR2A) && defined(OCR2B)
 
-        _frequency = frequency;
-        _callback  = (void*) callback;
-        _params    = reinterpret_cast<void*>(params);
+        case 2:
+          waitAsyncUpdate();
 
-        _timerDone = false;
+          TCCR2B  = 0;
+          TCCR2A  = controlA;
+          OCR2A   = compareA;
+          OCR2B   = compareB;
+          TCNT2   = 0;
+          bitWrite(TIMSK2, OCIE2A, 0);
 
-        // 8 bit timers from here
-#if defined(TCCR2B)
+          waitAsyncUpdate();
 
-        if (_timer == 2)
-        {
-          TCCR2B = (TCCR2B & andMask) | _prescalerIndex;   //prescalarbits;
+          TCCR2B  = controlB;
+          break;
+#endif
 
-          TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
-        }
+#if defined(TCCR3A) && defined(ICR3) && defined(OCR3B)
 
+        case 3:
+          TCCR3B  = 0;
+          TCCR3A  = controlA;
+          ICR3    = top;
+          OCR3A   = compareA;
+          OCR3B   = compareB;
+          TCNT3   = 0;
+          bitWrite(TIMSK3, OCIE3A, 0);
+          TCCR3B  = controlB;
+          break;
 #endif
 
-        // 16 bit timers from here
-#if defined(TCCR1B)
-#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
+#if defined(TCCR4A) && defined(ICR4) && defined(OCR4B)
 
-        if (_timer == 1)
-#else
-        else if (_timer == 1)
+        case 4:
+          TCCR4B  = 0;
+          TCCR4A  = controlA;
+          ICR4    = top;
+          OCR4A   = compareA;
+          OCR4B   = compareB;
+          TCNT4   = 0;
+          bitWrite(TIMSK4, OCIE4A, 0);
+          TCCR4B  = controlB;
+          break;
 #endif
-        {
-          TCCR1B = (TCCR1B & andMask) | _prescalerIndex;   //prescalarbits;
 
-          TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
-        }
+#if defined(TCCR5A) && defined(ICR5) && defined(OCR5B)
 
+        case 5:
+          TCCR5B  = 0;
+          TCCR5A  = controlA;
+          ICR5    = top;
+          OCR5A   = compareA;
+          OCR5B   = compareB;
+          TCNT5   = 0;
+          bitWrite(TIMSK5, OCIE5A, 0);
+          TCCR5B  = controlB;
+          break;
 #endif
+      }
 
-#if defined(TCCR3B)
-        else if (_timer == 3)
-          TCCR3B = (TCCR3B & andMask) | _prescalerIndex;   //prescalarbits;
+      //sei();//enable interrupts
+      interrupts();
+    }
 
-#endif
+    // true if the timer can drive its OCnA / OCnB pins. Not the 10-bit high speed Timer4 of the 32u4
+    bool hasWaveform()
+    {
+#if TIMER_INTERRUPT_USING_ATMEGA_32U4
 
-#if defined(TCCR4B)
-        else if (_timer == 4)
-          TCCR4B = (TCCR4B & andMask) | _prescalerIndex;   //prescalarbits;
+      if (_timer == 4)
+        return false;
 
 #endif
 
-#if defined(TCCR5B)
-        else if (_timer == 5)
-          TCCR5B = (TCCR5B & andMask) | _prescalerIndex;   //prescalarbits;
+      return (getWaveformPin(WAVEFORM_CHANNEL_A) >= 0);
+    }
 
-#endif
+    // Make the OCnx pin an output, driven low when the compare output is off
+    bool setWaveformPin(const uint8_t& channel)
+    {
+      int8_t pin = getWaveformPin(channel);
 
-        // Set the OCR for the given timer,
-        // set the toggle count,
-        // then turn on the interrupts
-        set_OCR();
+      if (pin < 0)
+        return false;
 
-        //sei();//allow interrupts
-        interrupts();
+      digitalWrite(pin, LOW);
+      pinMode(pin, OUTPUT);
 
-        return true;
-      }
+      return true;
+    }
+
+    // COMnx bits (bits 7-6 for channel A, 5-4 for channel B) of TCCRnA
+    static uint8_t compareOutput(const uint8_t& channel, const uint8_t& mode)
+    {
+      return (channel == WAVEFORM_CHANNEL_A) ? (mode << 6) : (mode << 4);
     }
 
     ///////////////////////////////////////////
 
+    // Compile-time version of planFrequency() for a frequency of num / den Hz, with the
+    // TIMER_INTERRUPT_ERROR_BUDGET_PPM budget. All in 64-bit integer, as an OCR value can't fit in 32-bit
+    // with a small prescaler
 
-    void init()
+    static constexpr uint32_t ctDivider(const uint8_t index, const bool T2)
     {
-      init(_timer);
-    };
-
+      return T2 ? prescalerDivT2[index] : prescalerDiv[index];
+    }
 
-    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    bool setFrequency(float frequency, timer_callback callback, unsigned long duration = 0)
+    static constexpr uint64_t ctTicks(const uint32_t num, const uint32_t den, const uint32_t clock, const uint32_t divider)
     {
-      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+      return ( ( (uint64_t) clock * den * 2 ) / ( (uint64_t) num * divider ) + 1 ) / 2;
     }
 
-    // interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    template<typename TArg>
-    bool setInterval(unsigned long interval, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    static constexpr bool ctValid(const uint32_t num, const uint32_t den, const uint32_t clock, const uint32_t divider)
     {
-      static_assert(sizeof(TArg) <= sizeof(uint32_t), "setInterval() callback argument size must be <= 4 bytes");
-      return setFrequency((float) (1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), (uint32_t) params,
-                          duration);
+      return (ctTicks(num, den, clock, divider) >= 2) && (ctTicks(num, den, clock, divider) <= 0xFFFFFF00UL);
     }
 
-    // interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    bool setInterval(unsigned long interval, timer_callback callback, unsigned long duration = 0)
+    static constexpr uint64_t ctErrorPPM(const uint32_t num, const uint32_t den, const uint32_t clock, const uint32_t divider)
     {
-      return setFrequency((float) (1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+      return ( ( (ctTicks(num, den, clock, divider) * num * divider > (uint64_t) clock * den) ?
+                 (ctTicks(num, den, clock, divider) * num * divider - (uint64_t) clock * den) :
+                 ((uint64_t) clock * den - ctTicks(num, den, clock, divider) * num * divider) ) * 1000000ULL ) / ( (uint64_t) clock * den );
     }
 
-    template<typename TArg>
-    bool attachInterrupt(float frequency, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    // TIMER_INTERRUPT_MIN_CHUNK_CYCLES CPU cycles in timer ticks
+    static constexpr uint32_t ctMinTicks(const uint32_t clock, const uint32_t divider)
     {
-      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterrupt() callback argument size must be <= 4 bytes");
-      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), (uint32_t) params, duration);
+      return ( ( (uint64_t) TIMER_INTERRUPT_MIN_CHUNK_CYCLES * clock + (uint64_t) F_CPU * divider - 1 ) /
+               ( (uint64_t) F_CPU * divider ) < 2 ) ? 2 :
+             (uint32_t) ( ( (uint64_t) TIMER_INTERRUPT_MIN_CHUNK_CYCLES * clock + (uint64_t) F_CPU * divider - 1 ) /
+                          ( (uint64_t) F_CPU * divider ) );
     }
 
-    bool attachInterrupt(float frequency, timer_callback callback, unsigned long duration = 0)
+    static constexpr uint32_t ctChunk(const uint64_t ticks, const uint32_t maxCount, const uint32_t minTicks,
+                                      const uint32_t chunk)
     {
-      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+      return ( (ticks > chunk + 1) && (chunk > maxCount / 2) && ( (ticks % (chunk + 1)) != 0 )
+               && ( (ticks % (chunk + 1)) < minTicks ) ) ? ctChunk(ticks, maxCount, minTicks, chunk - 1) : chunk;
     }
 
-    // Interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    template<typename TArg>
-    bool attachInterruptInterval(unsigned long interval, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    static constexpr uint32_t ctChunkOf(const uint32_t num, const uint32_t den, const uint32_t clock, const bool T2, const uint32_t maxCount,
+                                        const uint8_t index)
     {
-      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterruptInterval() callback argument size must be <= 4 bytes");
-      return setFrequency( (float) ( 1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), (uint32_t) params,
-                           duration);
+      return ctChunk(ctTicks(num, den, clock, ctDivider(index, T2)), maxCount, ctMinTicks(clock, ctDivider(index, T2)), maxCount);
     }
 
-    // Interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    bool attachInterruptInterval(unsigned long interval, timer_callback callback, unsigned long duration = 0)
+    static constexpr uint64_t ctInterrupts(const uint32_t num, const uint32_t den, const uint32_t clock, const bool T2, const uint32_t maxCount,
+                                           const uint8_t index)
     {
-      return setFrequency( (float) ( 1000.0f / interval), reinterpret_cast<timer_callback_p> (callback), /*NULL*/ 0,
-                           duration);
+      return ( ctTicks(num, den, clock, ctDivider(index, T2)) + ctChunkOf(num, den, clock, T2, maxCount, index) ) /
+             ( (uint64_t) ctChunkOf(num, den, clock, T2, maxCount, index) + 1 );
     }
 
-
-    ///////////////////////////////////////////
-
-    // void detachInterrupt();
-
-    void detachInterrupt()
+    // true if prescaler index 'a' is a better plan than 'b', as in planFrequency()
+    static constexpr bool ctBetter(const uint32_t num, const uint32_t den, const uint32_t clock, const bool T2, const uint32_t maxCount,
+                                   const uint8_t a, const uint8_t b)
     {
-      //cli();//stop interrupts
-      noInterrupts();
-
-      switch (_timer)
-      {
-#if defined(TIMSK1) && defined(OCIE1A)
-
-        case 1:
-          bitWrite(TIMSK1, OCIE1A, 0);
-
-          TISR_LOGWARN(F("Disable T1"));
-
-          break;
-#endif
-
-        case 2:
-#if defined(TIMSK2) && defined(OCIE2A)
-          bitWrite(TIMSK2, OCIE2A, 0); // disable interrupt
-#endif
-
-          TISR_LOGWARN(F("Disable T2"));
+      return ctValid(num, den, clock, ctDivider(a, T2)) && ( !ctValid(num, den, clock, ctDivider(b, T2)) ||
+             ( (ctErrorPPM(num, den, clock, ctDivider(a, T2)) <= TIMER_INTERRUPT_ERROR_BUDGET_PPM)
+               != (ctErrorPPM(num, den, clock, ctDivider(b, T2)) <= TIMER_INTERRUPT_ERROR_BUDGET_PPM) ?
+               (ctErrorPPM(num, den, clock, ctDivider(a, T2)) <= TIMER_INTERRUPT_ERROR_BUDGET_PPM) :
+               ( (ctErrorPPM(num, den, clock, ctDivider(a, T2)) <= TIMER_INTERRUPT_ERROR_BUDGET_PPM) ?
+                 ( (ctInterrupts(num, den, clock, T2, maxCount, a) < ctInterrupts(num, den, clock, T2, maxCount, b)) ||
+                   ( (ctInterrupts(num, den, clock, T2, maxCount, a) == ctInterrupts(num, den, clock, T2, maxCount, b))
+                     && (ctErrorPPM(num, den, clock, ctDivider(a, T2)) < ctErrorPPM(num, den, clock, ctDivider(b, T2))) ) ) :
+                 ( (ctErrorPPM(num, den, clock, ctDivider(a, T2)) < ctErrorPPM(num, den, clock, ctDivider(b, T2))) ||
+                   ( (ctErrorPPM(num, den, clock, ctDivider(a, T2)) == ctErrorPPM(num, den, clock, ctDivider(b, T2)))
+                     && (ctInterrupts(num, den, clock, T2, maxCount, a) < ctInterrupts(num, den, clock, T2, maxCount, b)) ) ) ) ) );
+    }
 
-          break;
+    // best prescaler index from 'index' to the last one, 'best' being the best one so far
+    static constexpr uint8_t ctPrescalerIndex(const uint32_t num, const uint32_t den, const uint32_t clock, const bool T2, const uint32_t maxCount,
+                                              const uint8_t index, const uint8_t best)
+    {
+      return (index > (T2 ? (uint8_t) T2_PRESCALER_1024 : (uint8_t) PRESCALER_1024)) ? best :
+             ctPrescalerIndex(num, den, clock, T2, maxCount, index + 1, ctBetter(num, den, clock, T2, maxCount, index, best) ? index : best);
+    }
 
-#if defined(TIMSK3) && defined(OCIE3A)
+    template<uint32_t num, uint32_t den, uint32_t clock, bool T2, uint32_t maxCount>
+    static constexpr bool ctPlanValid()
+    {
+      return ctValid(num, den, clock, ctDivider(ctPrescalerIndex(num, den, clock, T2, maxCount, NO_PRESCALER, NO_PRESCALER), T2));
+    }
 
-        case 3:
-          bitWrite(TIMSK3, OCIE3A, 0);
+    // mustBeValid = false => to be checked with ctPlanValid() at runtime
+    template<uint32_t num, uint32_t den, uint32_t clock, bool T2, uint32_t maxCount, bool mustBeValid = true>
+    static timer_plan_t ctPlan()
+    {
+      // all constants, folded at compile time
+      static_assert( !mustBeValid || ctPlanValid<num, den, clock, T2, maxCount>(), "Frequency unreachable by the timer" );
 
-          TISR_LOGWARN(F("Disable T3"));
+      const uint8_t index = ctPrescalerIndex(num, den, clock, T2, maxCount, NO_PRESCALER, NO_PRESCALER);
 
-          break;
-#endif
+      timer_plan_t plan;
 
-#if defined(TIMSK4) && defined(OCIE4A)
+      plan.prescalerIndex = index;
+      plan.OCRChunk       = ctChunkOf(num, den, clock, T2, maxCount, index);
+      plan.interrupts     = (uint32_t) ctInterrupts(num, den, clock, T2, maxCount, index);
+      plan.OCRValue       = (uint32_t) ctTicks(num, den, clock, ctDivider(index, T2)) - plan.interrupts;
+      plan.errorPPM       = ctErrorPPM(num, den, clock, ctDivider(index, T2));
 
-        case 4:
-          bitWrite(TIMSK4, OCIE4A, 0);
+      return plan;
+    }
 
-          TISR_LOGWARN(F("Disable T4"));
+    template<uint32_t num, uint32_t den>
+    bool setFrequencyRatio(timer_callback_p callback, uint32_t params, unsigned long duration)
+    {
+      static_assert( (num > 0) && (den > 0), "Frequency and interval must be > 0" );
+      static_assert( (uint64_t) F_CPU * den >= 2ULL * num, "Frequency too high for the timer, OCR value would be 0" );
+      static_assert( (uint64_t) den * 100 <= (uint64_t) num * 1717984, "Interval too long for the timer, max 17179.840s" );
 
-          break;
-#endif
+      timer_plan_t plan;
 
-#if defined(TIMSK5) && defined(OCIE5A)
+      if ( (_timer <= 0) || (callback == NULL) )
+      {
+        return false;
+      }
 
-        case 5:
-          bitWrite(TIMSK5, OCIE5A, 0);
+      // All planned at compile time, only the choice of the timer (and of the Timer2 clock) is left to runtime
+      if (_timer == 2)
+      {
+#if TIMER2_ASYNC_AVAILABLE
 
-          TISR_LOGWARN(F("Disable T5"));
+        // Checked at runtime, Timer2 being asynchronous or not
+        if (_asyncClock)
+        {
+          if (!ctPlanValid<num, den, TIMER2_ASYNC_CLOCK_HZ, true, MAX_COUNT_8BIT>())
+            return false;
 
-          break;
+          plan = ctPlan<num, den, TIMER2_ASYNC_CLOCK_HZ, true, MAX_COUNT_8BIT, false>();
+        }
+        else
 #endif
+          plan = ctPlan<num, den, F_CPU, true, MAX_COUNT_8BIT>();
       }
 
-      //sei();//allow interrupts
-      interrupts();
-    }
+#if TIMER_INTERRUPT_USING_ATMEGA_32U4
+      else if (_timer == 4)
+        plan = ctPlan<num, den, F_CPU, false, MAX_COUNT_8BIT>();
 
-    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    void reattachInterrupt(unsigned long duration = 0)
-    {
-      //cli();//stop interrupts
-      noInterrupts();
+#endif
+      else
+        plan = ctPlan<num, den, F_CPU, false, MAX_COUNT_16BIT>();
 
-      // Calculate the toggle count
+      // Calculate the toggle count, in integer. Duration must be at least longer then one cycle
       if (duration > 0)
       {
-        _toggle_count = _frequency * duration / 1000;
+        _toggle_count = ( (uint64_t) num * duration ) / ( 1000ULL * den );
+
+        if (_toggle_count < 1)
+        {
+          return false;
+        }
       }
       else
       {
         _toggle_count = -1;
       }
 
-      switch (_timer)
-      {
-#if defined(TIMSK1) && defined(OCIE1A)
+      // constant, folded at compile time
+      _frequency = (double) num / den;
 
-        case 1:
-          bitWrite(TIMSK1, OCIE1A, 1);
+      setTimerRegisters(plan, (void*) callback, reinterpret_cast<void*>(params));
 
-          TISR_LOGWARN(F("Enable T1"));
+      return true;
+    }
 
-          break;
-#endif
+    ///////////////////////////////////////////
 
-        case 2:
-#if defined(TIMSK2) && defined(OCIE2A)
-          bitWrite(TIMSK2, OCIE2A, 1); // enable interrupt
-#endif
+  public:
 
-          TISR_LOGWARN(F("Enable T2"));
+    TimerInterrupt()
+    {
+      _timer              = -1;
+      _frequency          = 0;
+      _callback           = NULL;
+      _params             = NULL;
+      _timerDone          = false;
+      _prescalerIndex     = NO_PRESCALER;
+      _OCRValue           = 0;
+      _OCRValueRemaining  = 0;
+      _OCRChunk           = MAX_COUNT_16BIT;
+      _toggle_count       = -1;
 
-          break;
+      _errorBudgetPPM       = TIMER_INTERRUPT_ERROR_BUDGET_PPM;
+      _interruptsPerPeriod  = 0;
+      _errorPPM             = 0;
 
-#if defined(TIMSK3) && defined(OCIE3A)
+      _waveformMode         = WAVEFORM_NONE;
+      _waveformTop          = 0;
+      _waveformFrequency    = 0;
 
-        case 3:
-          bitWrite(TIMSK3, OCIE3A, 1);
+      _clockFreq            = F_CPU;
+      _asyncClock           = false;
 
-          TISR_LOGWARN(F("Enable T3"));
+      _nestedCallback       = false;
+      _inNestedCallback     = false;
+      _nestedDetached       = false;
+    };
+
+    explicit TimerInterrupt(uint8_t timerNo)
+    {
+      _timer              = timerNo;
+      _frequency          = 0;
+      _callback           = NULL;
+      _params             = NULL;
+      _timerDone          = false;
+      _prescalerIndex     = NO_PRESCALER;
+      _OCRValue           = 0;
+      _OCRValueRemaining  = 0;
+      _OCRChunk           = MAX_COUNT_16BIT;
+      _toggle_count       = -1;
+
+      _errorBudgetPPM       = TIMER_INTERRUPT_ERROR_BUDGET_PPM;
+      _interruptsPerPeriod  = 0;
+      _errorPPM             = 0;
+
+      _waveformMode         = WAVEFORM_NONE;
+      _waveformTop          = 0;
+      _waveformFrequency    = 0;
+
+      _clockFreq            = F_CPU;
+      _asyncClock           = false;
+
+      _nestedCallback       = false;
+      _inNestedCallback     = false;
+      _nestedDetached       = false;
+    };
+
+    void callback() __attribute__((always_inline))
+    {
+      if (_callback != NULL)
+      {
+        if (_nestedCallback)
+        {
+          // Re-entered, after the callback unmasked its own interrupt, e.g. with reattachInterrupt() => skip
+          if (_inNestedCallback)
+            return;
+
+          _inNestedCallback = true;
+          _nestedDetached   = false;
+
+          // The compare flag is already cleared by the hardware when entering the ISR.
+          // Mask only the interrupt of this timer, then let the other ones preempt the callback
+          writeCompareInterrupt(false);
+          interrupts();
+
+          callUser();
+
+          noInterrupts();
+
+          // A compare during the callback is still pending, and runs the ISR again at once
+          if (!_nestedDetached)
+            writeCompareInterrupt(true);
+
+          _inNestedCallback = false;
+        }
+        else
+          callUser();
+      }
+    }
+
+    void init(int8_t timer)
+    {
+      // Set timer specific stuff
+      // All timers in CTC mode
+      // 8 bit timers will require changing prescalar values,
+      // whereas 16 bit timers are set to either ck/1 or ck/64 prescalar
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      switch (timer)
+      {
+#if defined(TCCR1A) && defined(TCCR1B) && defined(WGM12)
+
+        case 1:
+          // 16 bit timer
+          TCCR1A = 0;
+          TCCR1B = 0;
+          // Page 172-173. ATmega 328/328P or Page 145-146 of ATmega 640/1280/2560
+          // Mode 4 => Clear Timer on Compare match (CTC) using OCR1A for counter value
+          bitWrite(TCCR1B, WGM12, 1);
+          // No scaling now
+          bitWrite(TCCR1B, CS10, 1);
+
+          TISR_LOGWARN(F("T1"));
+
+          break;
+#endif
+
+#if defined(TCCR2A) && defined(TCCR2B)
+
+        case 2:
+          // 8 bit timer
+          TCCR2A = 0;
+          TCCR2B = 0;
+
+          waitAsyncUpdate();
+
+          // Page 205-206. ATmegal328, Page 184-185 ATmega 640/1280/2560
+          // Mode 2 => Clear Timer on Compare match (CTC) using OCR2A for counter value
+          bitWrite(TCCR2A, WGM21, 1);
+          // No scaling now
+          bitWrite(TCCR2B, CS20, 1);
+
+          TISR_LOGWARN(F("T2"));
+
+          break;
+#endif
+
+#if defined(TCCR3A) && defined(TCCR3B) &&  defined(TIMSK3)
+
+        case 3:
+          // 16 bit timer
+          TCCR3A = 0;
+          TCCR3B = 0;
+          bitWrite(TCCR3B, WGM32, 1);
+          bitWrite(TCCR3B, CS30, 1);
+
+          TISR_LOGWARN(F("T3"));
+
+          break;
+#endif
+
+#if defined(TCCR4A) && defined(TCCR4B) &&  defined(TIMSK4)
+
+        case 4:
+          // 16 bit timer
+          TCCR4A = 0;
+          TCCR4B = 0;
+#if defined(WGM42)
+          bitWrite(TCCR4B, WGM42, 1);
+#elif defined(CS43)
+          // TODO this may not be correct
+          // atmega32u4
+          bitWrite(TCCR4B, CS43, 1);
+#endif
+          bitWrite(TCCR4B, CS40, 1);
+
+          TISR_LOGWARN(F("T4"));
+
+          break;
+#endif
+
+#if defined(TCCR5A) && defined(TCCR5B) &&  defined(TIMSK5)
+
+        case 5:
+          // 16 bit timer
+          TCCR5A = 0;
+          TCCR5B = 0;
+          bitWrite(TCCR5B, WGM52, 1);
+          bitWrite(TCCR5B, CS50, 1);
+
+          TISR_LOGWARN(F("T5"));
+
+          break;
+#endif
+      }
+
+      _timer = timer;
+
+      //sei();//enable interrupts
+      interrupts();
+
+    }
+
+    ///////////////////////////////////////////
+
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // bool setFrequency(float frequency, timer_callback_p callback, /* void* */ uint32_t params, unsigned long duration = 0);
+
+    // frequency (in hertz) and duration (in milliseconds).
+    // Return true if frequency is OK with selected timer (OCRValue is in range)
+    bool setFrequency(float frequency, timer_callback_p callback, uint32_t params, unsigned long duration = 0)
+    {
+      timer_plan_t plan;
+
+      //frequencyLimit must > 1
+      float frequencyLimit = frequency * 17179.840;
+
+      // Limit frequency to larger than (0.00372529 / 64) Hz or interval 17179.840s / 17179840 ms to avoid uint32_t overflow
+      if ((_timer <= 0) || (callback == NULL) || ((frequencyLimit) < 1) )
+      {
+        return false;
+      }
+      else
+      {
+        // Calculate the toggle count. Duration must be at least longer then one cycle
+        if (duration > 0)
+        {
+          _toggle_count = frequency * duration / 1000;
+
+          TISR_LOGWARN1(F("setFrequency => _toggle_count ="), _toggle_count);
+          TISR_LOGWARN3(F("Frequency ="), frequency, F(", duration ="), duration);
+
+          if (_toggle_count < 1)
+          {
+            return false;
+          }
+        }
+        else
+        {
+          _toggle_count = -1;
+        }
+
+        //Timer0 and timer2 are 8 bit timers, meaning they can store a maximum counter value of 255.
+        //Timer2 does not have the option of 1024 prescaler, only 1, 8, 32, 64
+        //Timer1 is a 16 bit timer, meaning it can store a maximum counter value of 65535.
+        // A period longer than the counter is made of several chunks, an interrupt each, see planFrequency()
+        if (!planFrequency(frequency, plan))
+        {
+          return false;
+        }
+
+        TISR_LOGWARN3(F("OK => _OCR ="), plan.OCRValue, F(", _preScalerIndex ="), plan.prescalerIndex);
+        TISR_LOGWARN3(F("Interrupts per period ="), plan.interrupts, F(", error ppm ="), plan.errorPPM);
+
+        _frequency = frequency;
+
+        setTimerRegisters(plan, (void*) callback, reinterpret_cast<void*>(params));
+
+        return true;
+      }
+    }
+
+    ///////////////////////////////////////////
+
+
+    void init()
+    {
+      init(_timer);
+    };
+
+
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    bool setFrequency(float frequency, timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+    // interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    template<typename TArg>
+    bool setInterval(unsigned long interval, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    {
+      static_assert(sizeof(TArg) <= sizeof(uint32_t), "setInterval() callback argument size must be <= 4 bytes");
+      return setFrequency((float) (1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), (uint32_t) params,
+                          duration);
+    }
+
+    // interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    bool setInterval(unsigned long interval, timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequency((float) (1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+    template<typename TArg>
+    bool attachInterrupt(float frequency, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    {
+      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterrupt() callback argument size must be <= 4 bytes");
+      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), (uint32_t) params, duration);
+    }
+
+    bool attachInterrupt(float frequency, timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequency(frequency, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+    // Interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    template<typename TArg>
+    bool attachInterruptInterval(unsigned long interval, void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    {
+      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterruptInterval() callback argument size must be <= 4 bytes");
+      return setFrequency( (float) ( 1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), (uint32_t) params,
+                           duration);
+    }
+
+    // Interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    bool attachInterruptInterval(unsigned long interval, timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequency( (float) ( 1000.0f / interval), reinterpret_cast<timer_callback_p> (callback), /*NULL*/ 0,
+                           duration);
+    }
+
+    ///////////////////////////////////////////
+
+    // Compile-time versions, e.g. ITimer1.attachInterruptInterval<50>(TimerHandler) or ITimer2.setFrequency<1000>(...).
+    // The prescaler and OCR values are solved by the compiler, an unreachable frequency fails with a static_assert,
+    // and no float code is linked unless the float versions above, or reattachInterrupt(duration), are also used
+
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    template<uint32_t frequency>
+    bool setFrequency(timer_callback_p callback, uint32_t params, unsigned long duration = 0)
+    {
+      return setFrequencyRatio<frequency, 1>(callback, params, duration);
+    }
+
+    template<uint32_t frequency>
+    bool setFrequency(timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequencyRatio<frequency, 1>(reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+    template<uint32_t frequency, typename TArg>
+    bool attachInterrupt(void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    {
+      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterrupt() callback argument size must be <= 4 bytes");
+      return setFrequencyRatio<frequency, 1>(reinterpret_cast<timer_callback_p>(callback), (uint32_t) params, duration);
+    }
+
+    template<uint32_t frequency>
+    bool attachInterrupt(timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequencyRatio<frequency, 1>(reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+    // Interval (in ms) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    template<uint32_t interval, typename TArg>
+    bool attachInterruptInterval(void (*callback)(TArg), TArg params, unsigned long duration = 0)
+    {
+      static_assert(sizeof(TArg) <= sizeof(uint32_t), "attachInterruptInterval() callback argument size must be <= 4 bytes");
+      return setFrequencyRatio<1000, interval>(reinterpret_cast<timer_callback_p>(callback), (uint32_t) params, duration);
+    }
+
+    template<uint32_t interval>
+    bool attachInterruptInterval(timer_callback callback, unsigned long duration = 0)
+    {
+      return setFrequencyRatio<1000, interval>(reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, duration);
+    }
+
+
+    ///////////////////////////////////////////
+
+    // void detachInterrupt();
+
+    void detachInterrupt()
+    {
+      //cli();//stop interrupts
+      noInterrupts();
+
+      // Called by a nested callback => don't unmask at its end
+      if (_inNestedCallback)
+        _nestedDetached = true;
+
+      switch (_timer)
+      {
+#if defined(TIMSK1) && defined(OCIE1A)
+
+        case 1:
+          bitWrite(TIMSK1, OCIE1A, 0);
+
+          TISR_LOGWARN(F("Disable T1"));
+
+          break;
+#endif
+
+        case 2:
+#if defined(TIMSK2) && defined(OCIE2A)
+          bitWrite(TIMSK2, OCIE2A, 0); // disable interrupt
+#endif
+
+          TISR_LOGWARN(F("Disable T2"));
+
+          break;
+
+#if defined(TIMSK3) && defined(OCIE3A)
+
+        case 3:
+          bitWrite(TIMSK3, OCIE3A, 0);
+
+          TISR_LOGWARN(F("Disable T3"));
+
+          break;
+#endif
+
+#if defined(TIMSK4) && defined(OCIE4A)
+
+        case 4:
+          bitWrite(TIMSK4, OCIE4A, 0);
+
+          TISR_LOGWARN(F("Disable T4"));
+
+          break;
+#endif
+
+#if defined(TIMSK5) && defined(OCIE5A)
+
+        case 5:
+          bitWrite(TIMSK5, OCIE5A, 0);
+
+          TISR_LOGWARN(F("Disable T5"));
+
+          break;
+#endif
+      }
+
+      //sei();//allow interrupts
+      interrupts();
+    }
+
+    // Duration (in milliseconds). Duration = 0 => run indefinitely
+    void reattachInterrupt(unsigned long duration)
+    {
+      // Calculate the toggle count
+      if (duration > 0)
+      {
+        //cli();//stop interrupts
+        noInterrupts();
+
+        _toggle_count = _frequency * duration / 1000;
+
+        //sei();//allow interrupts
+        interrupts();
+
+        enableCompareInterrupt();
+      }
+      else
+      {
+        reattachInterrupt();
+      }
+    }
+
+    // Run indefinitely. Separate from reattachInterrupt(duration) to stay float-free
+    void reattachInterrupt()
+    {
+      //cli();//stop interrupts
+      noInterrupts();
+
+      _toggle_count = -1;
+
+      //sei();//allow interrupts
+      interrupts();
+
+      enableCompareInterrupt();
+    }
+
+    ///////////////////////////////////////////
+
+    // Enable the compare match interrupt of the timer
+    void enableCompareInterrupt()
+    {
+      //cli();//stop interrupts
+      noInterrupts();
+
+      switch (_timer)
+      {
+#if defined(TIMSK1) && defined(OCIE1A)
+
+        case 1:
+          bitWrite(TIMSK1, OCIE1A, 1);
+
+          TISR_LOGWARN(F("Enable T1"));
+
+          break;
+#endif
+
+        case 2:
+#if defined(TIMSK2) && defined(OCIE2A)
+          bitWrite(TIMSK2, OCIE2A, 1); // enable interrupt
+#endif
+
+          TISR_LOGWARN(F("Enable T2"));
+
+          break;
+
+#if defined(TIMSK3) && defined(OCIE3A)
+
+        case 3:
+          bitWrite(TIMSK3, OCIE3A, 1);
+
+          TISR_LOGWARN(F("Enable T3"));
+
+          break;
+#endif
+
+#if defined(TIMSK4) && defined(OCIE4A)
+
+        case 4:
+          bitWrite(TIMSK4, OCIE4A, 1);
+
+          TISR_LOGWARN(F("Enable T4"));
+
+          break;
+#endif
+
+#if defined(TIMSK5) && defined(OCIE5A)
+
+        case 5:
+          bitWrite(TIMSK5, OCIE5A, 1);
+
+          TISR_LOGWARN(F("Enable T5"));
+
+          break;
+#endif
+      }
+
+      //sei();//allow interrupts
+      interrupts();
+    }
+
+    ///////////////////////////////////////////
+
+    void disableTimer()
+    {
+      detachInterrupt();
+    }
+
+    // Duration (in milliseconds). Duration = 0 => run indefinitely
+    void enableTimer(unsigned long duration) __attribute__((always_inline))
+    {
+      reattachInterrupt(duration);
+    }
+
+    void enableTimer() __attribute__((always_inline))
+    {
+      reattachInterrupt();
+    }
+
+    ///////////////////////////////////////////
+
+    // Just stop clock source, still keep the count
+    // void pauseTimer();
+
+    // Just stop clock source, still keep the count
+    void pauseTimer()
+    {
+      uint8_t andMask = 0b11111000;
+
+      //Just clear the CSx2-CSx0. Still keep the count in TCNT and Timer Interrupt mask TIMKSx.
+
+      // 8 bit timers from here
+#if defined(TCCR2B)
+
+      if (_timer == 2)
+      {
+        waitAsyncUpdate();
+
+        TCCR2B = (TCCR2B & andMask);
+
+        TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
+      }
+
+#endif
+
+      // 16 bit timers from here
+#if defined(TCCR1B)
+#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
+
+      if (_timer == 1)
+#else
+      else if (_timer == 1)
+#endif
+      {
+        TCCR1B = (TCCR1B & andMask);
+
+        TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
+      }
+
+#endif
+
+#if defined(TCCR3B)
+      else if (_timer == 3)
+        TCCR3B = (TCCR3B & andMask);
+
+#endif
+
+#if defined(TCCR4B)
+      else if (_timer == 4)
+        TCCR4B = (TCCR4B & andMask);
+
+#endif
+
+#if defined(TCCR5B)
+      else if (_timer == 5)
+        TCCR5B = (TCCR5B & andMask);
+
+#endif
+    }
+
+    // Just reconnect clock source, continue from the current count
+    // void resumeTimer();
+
+    // Just reconnect clock source, continue from the current count
+    void resumeTimer()
+    {
+      uint8_t andMask = 0b11111000;
+
+      //Just restore the CSx2-CSx0 stored in _prescalerIndex. Still keep the count in TCNT and Timer Interrupt mask TIMKSx.
+      // 8 bit timers from here
+#if defined(TCCR2B)
+
+      if (_timer == 2)
+      {
+        waitAsyncUpdate();
+
+        TCCR2B = (TCCR2B & andMask) | _prescalerIndex;   //prescalarbits;
+
+        TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
+      }
+
+#endif
+
+      // 16 bit timers from here
+#if defined(TCCR1B)
+#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
+
+      if (_timer == 1)
+#else
+      else if (_timer == 1)
+#endif
+      {
+        TCCR1B = (TCCR1B & andMask) | _prescalerIndex;   //prescalarbits;
+
+        TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
+      }
+
+#endif
+
+#if defined(TCCR3B)
+      else if (_timer == 3)
+        TCCR3B = (TCCR3B & andMask) | _prescalerIndex;   //prescalarbits;
+
+#endif
+
+#if defined(TCCR4B)
+      else if (_timer == 4)
+        TCCR4B = (TCCR4B & andMask) | _prescalerIndex;   //prescalarbits;
+
+#endif
+
+#if defined(TCCR5B)
+      else if (_timer == 5)
+        TCCR5B = (TCCR5B & andMask) | _prescalerIndex;   //prescalarbits;
+
+#endif
+    }
+
+    ///////////////////////////////////////////
+
+
+    // Just stop clock source, clear the count
+    void stopTimer()
+    {
+      detachInterrupt();
+    }
+
+    // Just reconnect clock source, start current count from 0
+    void restartTimer(unsigned long duration)
+    {
+      reattachInterrupt(duration);
+    }
+
+    void restartTimer()
+    {
+      reattachInterrupt();
+    }
+
+    ///////////////////////////////////////////
+
+    // Timer2 only: clock it from a TIMER2_ASYNC_CLOCK_HZ watch crystal on TOSC1 / TOSC2 (or from an external clock on
+    // TOSC1 if externalClock), instead of F_CPU. Timer2 then keeps running in power-save sleep, see sleepPowerSave(),
+    // and long intervals take few interrupts: 1s is one compare of 256 ticks at 32768Hz / 128.
+    // On the 328P, TOSC1 / TOSC2 are the XTAL1 / XTAL2 pins, so only for a 328P running on its internal RC oscillator.
+    // Let the crystal start (about 1s) before relying on it. Call before setFrequency() / attachInterrupt()
+    bool setAsyncClock(const bool& enable = true, const bool& externalClock = false)
+    {
+#if TIMER2_ASYNC_AVAILABLE
+
+      if (_timer != 2)
+        return false;
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      // Datasheet sequence: Timer2 interrupts disabled, clock source selected, registers written, update done,
+      // then interrupt flags cleared
+      TIMSK2 = 0;
+
+#if defined(EXCLK)
+      // EXCLK must be selected before AS2
+      ASSR = (enable && externalClock) ? bit(EXCLK) : 0;
+#endif
+
+      ASSR = enable ? ( ASSR | bit(AS2) ) : 0;
+
+      _asyncClock = enable;
+      _clockFreq  = enable ? TIMER2_ASYNC_CLOCK_HZ : F_CPU;
+
+      // CTC, no prescaler, as init()
+      TCNT2   = 0;
+      OCR2A   = 0;
+      TCCR2A  = bit(WGM21);
+      TCCR2B  = bit(CS20);
+
+      waitAsyncUpdate();
+
+      TIFR2 = bit(OCF2A) | bit(OCF2B) | bit(TOV2);
+
+      //sei();//enable interrupts
+      interrupts();
+
+      TISR_LOGWARN3(F("Timer2 async ="), enable, F(", clock ="), _clockFreq);
+
+      return true;
+#else
+      (void) enable;
+      (void) externalClock;
+
+      return false;
+#endif
+    }
+
+    bool isAsyncClock()
+    {
+      return _asyncClock;
+    }
+
+    // returns the timer clock (Hz), before the prescaler
+    uint32_t getClockFrequency()
+    {
+      return _clockFreq;
+    }
+
+    // Sleep in power-save mode until the next interrupt, e.g. the next compare of an asynchronous Timer2.
+    // Timer0 is stopped meanwhile, so millis() / micros() don't count the time asleep
+    void sleepPowerSave()
+    {
+#if TIMER2_ASYNC_AVAILABLE
+
+      // After a Timer2 interrupt, one TOSC1 cycle must pass before sleeping, or the MCU could never wake up:
+      // rewrite TCCR2A and wait for its update
+      if (_asyncClock)
+      {
+        TCCR2A = TCCR2A;
+        waitAsyncUpdate();
+      }
+
+#endif
+
+      set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+
+      // No interrupt between sei and sleep, the instruction after sei being always executed
+      noInterrupts();
+      sleep_enable();
+      interrupts();
+      sleep_cpu();
+      sleep_disable();
+    }
+
+    ///////////////////////////////////////////
+
+    // Hardware waveforms. The OCnA / OCnB pins are driven by the compare-match hardware, with no interrupt and
+    // no CPU work per edge. The timer can't call any callback meanwhile, until stopWaveform() and a new attachInterrupt().
+    // The frequency is solved by the same planner as setFrequency(), restricted to one compare per period
+
+    // returns the Arduino pin of the OCnA / OCnB output of the timer, -1 if none
+    int8_t getWaveformPin(const uint8_t& channel)
+    {
+      uint8_t timerOutput = NOT_ON_TIMER;
+
+      switch (_timer)
+      {
+#if defined(TIMER1B)
+
+        case 1:
+          timerOutput = (channel == WAVEFORM_CHANNEL_A) ? TIMER1A : TIMER1B;
+          break;
+#endif
+
+#if defined(TIMER2B)
+
+        case 2:
+          timerOutput = (channel == WAVEFORM_CHANNEL_A) ? TIMER2A : TIMER2B;
+          break;
+#endif
+
+#if defined(TIMER3B)
+
+        case 3:
+          timerOutput = (channel == WAVEFORM_CHANNEL_A) ? TIMER3A : TIMER3B;
+          break;
+#endif
+
+#if defined(TIMER4B)
+
+        case 4:
+          timerOutput = (channel == WAVEFORM_CHANNEL_A) ? TIMER4A : TIMER4B;
+          break;
+#endif
+
+#if defined(TIMER5B)
+
+        case 5:
+          timerOutput = (channel == WAVEFORM_CHANNEL_A) ? TIMER5A : TIMER5B;
+          break;
+#endif
+      }
+
+      if (timerOutput == NOT_ON_TIMER)
+        return -1;
+
+      // From the pin map of the board variant
+      for (uint8_t pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+      {
+        if (digitalPinToTimer(pin) == timerOutput)
+          return pin;
+      }
+
+      return -1;
+    }
+
+    // Square wave of 'frequency' Hz, 50% duty, on OCnA or OCnB. CTC mode, the pin toggling at each compare match
+    bool setSquareWave(const float& frequency, const uint8_t& channel = WAVEFORM_CHANNEL_A)
+    {
+      timer_plan_t plan;
+
+      if ( (frequency <= 0) || !hasWaveform() || !planFrequency(frequency * 2, plan, true) || !setWaveformPin(channel) )
+      {
+        return false;
+      }
+
+      _prescalerIndex     = plan.prescalerIndex;
+      _waveformMode       = WAVEFORM_SQUARE;
+      _waveformTop        = plan.OCRValue;
+      _waveformFrequency  = (float) _clockFreq / ( 2.0f * ( (_timer == 2) ? prescalerDivT2 : prescalerDiv )[_prescalerIndex]
+                                                  * (_waveformTop + 1) );
+      _errorPPM           = plan.errorPPM;
+
+      // Toggle on compare match. OCRnB = 0 also toggles channel B once per period
+      if (_timer == 2)
+        setWaveformRegisters(compareOutput(channel, 1) | 0x02 /* CTC, WGM21 */, _prescalerIndex, 0, _waveformTop, 0);
+      else
+        setWaveformRegisters(compareOutput(channel, 1), 0x08 /* CTC, WGMn2 */ | _prescalerIndex, 0, _waveformTop, 0);
+
+      TISR_LOGWARN3(F("Square wave: frequency ="), _waveformFrequency, F(", OCR ="), _waveformTop);
+
+      return true;
+    }
+
+    // PWM of 'frequency' Hz and 'duty' % on OCnA or OCnB, fast or phase correct (half the frequency resolution, but
+    // symmetric). The other channel of a 16-bit timer runs at the same frequency, see setPWMDuty().
+    // Timer2 uses OCR2A as TOP, so only channel B is available
+    bool setPWM(const float& frequency, const uint8_t& channel, const float& duty, const bool& phaseCorrect = false)
+    {
+      timer_plan_t plan;
+
+      if ( (frequency <= 0) || !hasWaveform() || ( (_timer == 2) && (channel != WAVEFORM_CHANNEL_B) ) )
+      {
+        return false;
+      }
+
+      // Phase correct period = 2 * TOP ticks, fast period = TOP + 1 ticks
+      if (!planFrequency(phaseCorrect ? frequency * 2 : frequency, plan, true) || !setWaveformPin(channel)
+          || (phaseCorrect && (plan.OCRValue + 1 > getMaxCount())) )
+      {
+        return false;
+      }
+
+      _prescalerIndex     = plan.prescalerIndex;
+      _waveformMode       = phaseCorrect ? WAVEFORM_PHASE_PWM : WAVEFORM_FAST_PWM;
+      _waveformTop        = phaseCorrect ? plan.OCRValue + 1 : plan.OCRValue;
+      _waveformFrequency  = (float) _clockFreq / ( ( (_timer == 2) ? prescalerDivT2 : prescalerDiv )[_prescalerIndex] *
+                                                  (phaseCorrect ? 2.0f * _waveformTop : _waveformTop + 1.0f) );
+      _errorPPM           = plan.errorPPM;
+
+      if (_timer == 2)
+      {
+        // Mode 7 (fast) or 5 (phase correct), TOP = OCR2A
+        setWaveformRegisters(phaseCorrect ? 0x01 : 0x03, 0x08 | _prescalerIndex, 0, _waveformTop, 0);
+      }
+      else
+      {
+        // Mode 14 (fast) or 10 (phase correct), TOP = ICRn
+        setWaveformRegisters(0x02, (phaseCorrect ? 0x10 : 0x18) | _prescalerIndex, _waveformTop, 0, 0);
+      }
+
+      TISR_LOGWARN3(F("PWM: frequency ="), _waveformFrequency, F(", TOP ="), _waveformTop);
+
+      return setPWMDuty(channel, duty);
+    }
+
+    // Change the duty (%) of a channel of the running PWM, without glitch (OCRnx is double buffered in PWM modes).
+    // A 16-bit timer can run both channels with their own duty. 0% turns the output off, the pin staying low
+    bool setPWMDuty(const uint8_t& channel, const float& duty)
+    {
+      uint16_t  compare;
+      uint8_t   output      = 2;    // clear on compare match when up-counting, non-inverting
+      bool      fast        = (_waveformMode == WAVEFORM_FAST_PWM);
+
+      if ( ( (_waveformMode != WAVEFORM_FAST_PWM) && (_waveformMode != WAVEFORM_PHASE_PWM) ) || (duty < 0) || (duty > 100) ||
+           ( (_timer == 2) && (channel != WAVEFORM_CHANNEL_B) ) || !setWaveformPin(channel) )
+      {
+        return false;
+      }
+
+      // Fast: high for OCR + 1 of TOP + 1 ticks. Phase correct: high for 2 * OCR of 2 * TOP ticks
+      if (fast)
+      {
+        float high = duty * (_waveformTop + 1.0f) / 100 + 0.5f;
+
+        if (high < 1)
+          output = 0;
+
+        compare = (high < 1) ? 0 : (uint16_t) high - 1;
+      }
+      else
+      {
+        compare = (uint16_t) (duty * _waveformTop / 100 + 0.5f);
+      }
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      switch (_timer)
+      {
+#if defined(TCCR1A) && defined(OCR1B)
+
+        case 1:
+          TCCR1A = (TCCR1A & ~compareOutput(channel, 3)) | compareOutput(channel, output);
+
+          if (channel == WAVEFORM_CHANNEL_A)
+            OCR1A = compare;
+          else
+            OCR1B = compare;
+
+          break;
+#endif
+
+#if defined(TCCR2A) && defined(OCR2B)
+
+        case 2:
+          TCCR2A = (TCCR2A & ~compareOutput(channel, 3)) | compareOutput(channel, output);
+          OCR2B  = compare;
+          break;
+#endif
+
+#if defined(TCCR3A) && defined(OCR3B)
+
+        case 3:
+          TCCR3A = (TCCR3A & ~compareOutput(channel, 3)) | compareOutput(channel, output);
+
+          if (channel == WAVEFORM_CHANNEL_A)
+            OCR3A = compare;
+          else
+            OCR3B = compare;
+
+          break;
+#endif
+
+#if defined(TCCR4A) && defined(OCR4B)
+
+        case 4:
+          TCCR4A = (TCCR4A & ~compareOutput(channel, 3)) | compareOutput(channel, output);
+
+          if (channel == WAVEFORM_CHANNEL_A)
+            OCR4A = compare;
+          else
+            OCR4B = compare;
+
+          break;
+#endif
+
+#if defined(TCCR5A) && defined(OCR5B)
+
+        case 5:
+          TCCR5A = (TCCR5A & ~compareOutput(channel, 3)) | compareOutput(channel, output);
+
+          if (channel == WAVEFORM_CHANNEL_A)
+            OCR5A = compare;
+          else
+            OCR5B = compare;
+
+          break;
+#endif
+      }
+
+      //sei();//enable interrupts
+      interrupts();
+
+      return true;
+    }
+
+    // One high pulse of 'width' us on OCnA or OCnB, then the pin stays low. Normal mode: the pin is forced high,
+    // then cleared in hardware by the compare match 'width' us later
+    bool setSinglePulse(const float& width, const uint8_t& channel = WAVEFORM_CHANNEL_A)
+    {
+      timer_plan_t  plan;
+      uint8_t       forceCompare = (channel == WAVEFORM_CHANNEL_A) ? 0x80 : 0x40;   // FOCnA / FOCnB
+
+      if ( (width <= 0) || !hasWaveform() || !planFrequency(1000000.0f / width, plan, true) || !setWaveformPin(channel) )
+      {
+        return false;
+      }
+
+      // The pin is cleared when the count reaches OCR, i.e. after OCR ticks
+      if (plan.OCRValue + 1 > getMaxCount())
+        return false;
+
+      _prescalerIndex     = plan.prescalerIndex;
+      _waveformMode       = WAVEFORM_SINGLE_PULSE;
+      _waveformTop        = plan.OCRValue + 1;
+      _waveformFrequency  = 0;
+      _errorPPM           = plan.errorPPM;
+
+      // Timer stopped, set on compare match, forced
+      setWaveformRegisters(compareOutput(channel, 3), 0, 0, _waveformTop, _waveformTop);
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      switch (_timer)
+      {
+#if defined(TCCR1C)
+
+        case 1:
+          TCCR1C = forceCompare;
+          TCCR1A = compareOutput(channel, 2);
+          TCCR1B = _prescalerIndex;
+          break;
+#endif
+
+#if defined(TCCR2A) && defined(OCR2B)
+
+        case 2:
+          // FOC2A / FOC2B are in TCCR2B
+          waitAsyncUpdate();
+
+          TCCR2B = forceCompare;
+          TCCR2A = compareOutput(channel, 2);
+
+          waitAsyncUpdate();
+
+          TCCR2B = _prescalerIndex;
+          break;
+#endif
+
+#if defined(TCCR3C)
+
+        case 3:
+          TCCR3C = forceCompare;
+          TCCR3A = compareOutput(channel, 2);
+          TCCR3B = _prescalerIndex;
+          break;
+#endif
+
+#if defined(TCCR4C) && !TIMER_INTERRUPT_USING_ATMEGA_32U4
+
+        case 4:
+          TCCR4C = forceCompare;
+          TCCR4A = compareOutput(channel, 2);
+          TCCR4B = _prescalerIndex;
+          break;
+#endif
+
+#if defined(TCCR5C)
+
+        case 5:
+          TCCR5C = forceCompare;
+          TCCR5A = compareOutput(channel, 2);
+          TCCR5B = _prescalerIndex;
+          break;
+#endif
+      }
+
+      //sei();//enable interrupts
+      interrupts();
+
+      return true;
+    }
+
+    // Turn the OCnA / OCnB outputs off, the pins back to their PORT value (low), and stop the timer.
+    // attachInterrupt() / setFrequency() set the timer back to CTC for the callbacks
+    void stopWaveform()
+    {
+      if (_waveformMode == WAVEFORM_NONE)
+        return;
+
+      setWaveformRegisters(0, 0, 0, 0, 0);
+
+      // setFrequency() expects CTC
+      init(_timer);
+
+      _waveformMode = WAVEFORM_NONE;
+    }
+
+    // returns the frequency of the running square wave or PWM, as achieved by the timer
+    float getWaveformFrequency()
+    {
+      return _waveformFrequency;
+    }
+
+    uint8_t getWaveformMode()
+    {
+      return _waveformMode;
+    }
+
+    int8_t getTimer() __attribute__((always_inline))
+    {
+      return _timer;
+    };
+
+    long getCount() __attribute__((always_inline))
+    {
+      return _toggle_count;
+    };
+
+    void setCount(long countInput) __attribute__((always_inline))
+    {
+      //cli();//stop interrupts
+      //noInterrupts();
+
+      _toggle_count = countInput;
+
+      //sei();//enable interrupts
+      //interrupts();
+    };
+
+    long get_OCRValue() __attribute__((always_inline))
+    {
+      return _OCRValue;
+    };
+
+    long get_OCRValueRemaining() __attribute__((always_inline))
+    {
+      return _OCRValueRemaining;
+    };
+
+    // max OCR value of a chunk. A period with _OCRValue > _OCRChunk takes several interrupts
+    uint32_t get_OCRChunk() __attribute__((always_inline))
+    {
+      return _OCRChunk;
+    };
+
+    // Max error (ppm) of the period allowed to the planner of setFrequency() to take fewer interrupts per period.
+    // The compile-time setFrequency<>() uses TIMER_INTERRUPT_ERROR_BUDGET_PPM
+    void setErrorBudgetPPM(const uint32_t& errorBudgetPPM)
+    {
+      _errorBudgetPPM = errorBudgetPPM;
+    };
+
+    uint32_t getErrorBudgetPPM()
+    {
+      return _errorBudgetPPM;
+    };
+
+    // true => the callback runs with the interrupts enabled, as with ISR_NOBLOCK, and only the compare interrupt of
+    // this timer masked. millis(), Serial and the other timers are no longer blocked by a long callback.
+    // The callback must be reentrant with respect to the other ISRs, and take less than one interrupt interval: the
+    // period, or one chunk, get_OCRChunk() ticks, when getInterruptsPerPeriod() > 1. Only one compare stays pending
+    // while it runs, so a longer callback loses chunk compares, and the period silently gets longer
+    void setNestedCallback(const bool& nestedCallback)
+    {
+      _nestedCallback = nestedCallback;
+    };
+
+    bool isNestedCallback()
+    {
+      return _nestedCallback;
+    };
+
+    // returns the number of interrupts per period, including the intermediate chunk interrupts
+    uint32_t getInterruptsPerPeriod()
+    {
+      return _interruptsPerPeriod;
+    };
+
+    // returns the error (ppm) of the period, due to the resolution of the prescaled timer clock
+    float getErrorPPM()
+    {
+      return _errorPPM;
+    };
 
-          break;
+    void adjust_OCRValue() //__attribute__((always_inline))
+    {
+      // Called from the ISR => restore the I-flag as it was, instead of enabling the interrupts
+      uint8_t oldSREG = SREG;
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      // Last chunk => load its OCR value. Else the OCR register keeps the _OCRChunk of the previous chunk
+      if (_OCRValueRemaining < _OCRChunk)
+      {
+        keepPendingClear();
+        set_OCR();
+      }
+
+      _OCRValueRemaining -= min(_OCRChunk, _OCRValueRemaining);
+
+      if (_OCRValueRemaining <= 0)
+      {
+        // Reset value for next cycle
+        _OCRValueRemaining = _OCRValue;
+        _timerDone = true;
+      }
+      else
+        _timerDone = false;
+
+      SREG = oldSREG;
+    };
+
+    void reload_OCRValue() //__attribute__((always_inline))
+    {
+      uint8_t oldSREG = SREG;
+
+      //cli();//stop interrupts
+      noInterrupts();
+
+      // Reset value for next cycle, have to deduct the value already loaded to OCR register
+
+      _OCRValueRemaining = _OCRValue;
+      keepPendingClear();
+      set_OCR();
+
+      _timerDone = false;
+
+      SREG = oldSREG;
+    };
+
+    bool checkTimerDone() //__attribute__((always_inline))
+    {
+      return _timerDone;
+    };
+
+}; // class TimerInterrupt
+
+//////////////////////////////////////////////
+
+// Callback kinds of TimerInterruptDirect, fixed at compile time
+#define TIMER_CALLBACK_ANY            0     // callback with or without params, tested in the ISR as in TimerInterrupt
+#define TIMER_CALLBACK_NO_PARAMS      1     // only timer_callback
+#define TIMER_CALLBACK_WITH_PARAMS    2     // only timer_callback_p
+
+// true => ITimer1-5 are TimerInterruptDirect, with a specialised ISR each
+#ifndef TIMER_INTERRUPT_DIRECT_ISR
+  #define TIMER_INTERRUPT_DIRECT_ISR        false
 #endif
 
-#if defined(TIMSK4) && defined(OCIE4A)
+// Callback kind of the ITimer1-5 of TIMER_INTERRUPT_DIRECT_ISR
+#ifndef TIMER_INTERRUPT_DIRECT_CALLBACK
+  #define TIMER_INTERRUPT_DIRECT_CALLBACK   TIMER_CALLBACK_ANY
+#endif
 
-        case 4:
-          bitWrite(TIMSK4, OCIE4A, 1);
+// OCRnA and TIMSKn registers of each timer, known at compile time
+template<uint8_t timerNo>
+struct TimerRegisters;
 
-          TISR_LOGWARN(F("Enable T4"));
+#if defined(OCR1A)
+template<>
+struct TimerRegisters<1>
+{
+  static void setOCR(const uint16_t& OCRValue) __attribute__((always_inline))
+  {
+    OCR1A = OCRValue;
+  }
 
-          break;
+  // See TimerInterrupt::keepPendingClear()
+  static void keepPendingClear() __attribute__((always_inline))
+  {
+    if (TCNT1 == OCR1A)
+      TCNT1 = MAX_COUNT_16BIT;
+  }
+
+  static void setCompareInterrupt(const bool& enable) __attribute__((always_inline))
+  {
+    bitWrite(TIMSK1, OCIE1A, enable);
+  }
+};
 #endif
 
-#if defined(TIMSK5) && defined(OCIE5A)
+#if defined(OCR2A)
+template<>
+struct TimerRegisters<2>
+{
+  static void setOCR(const uint16_t& OCRValue) __attribute__((always_inline))
+  {
+    OCR2A = OCRValue;
+  }
 
-        case 5:
-          bitWrite(TIMSK5, OCIE5A, 1);
+  // See TimerInterrupt::keepPendingClear()
+  static void keepPendingClear() __attribute__((always_inline))
+  {
+    if (TCNT2 == OCR2A)
+      TCNT2 = MAX_COUNT_8BIT;
+  }
 
-          TISR_LOGWARN(F("Enable T5"));
+  static void setCompareInterrupt(const bool& enable) __attribute__((always_inline))
+  {
+    bitWrite(TIMSK2, OCIE2A, enable);
+  }
+};
+#endif
 
-          break;
+#if defined(OCR3A)
+template<>
+struct TimerRegisters<3>
+{
+  static void setOCR(const uint16_t& OCRValue) __attribute__((always_inline))
+  {
+    OCR3A = OCRValue;
+  }
+
+  // See TimerInterrupt::keepPendingClear()
+  static void keepPendingClear() __attribute__((always_inline))
+  {
+    if (TCNT3 == OCR3A)
+      TCNT3 = MAX_COUNT_16BIT;
+  }
+
+  static void setCompareInterrupt(const bool& enable) __attribute__((always_inline))
+  {
+    bitWrite(TIMSK3, OCIE3A, enable);
+  }
+};
 #endif
-      }
 
-      //sei();//allow interrupts
-      interrupts();
-    }
+#if defined(OCR4A)
+template<>
+struct TimerRegisters<4>
+{
+  static void setOCR(const uint16_t& OCRValue) __attribute__((always_inline))
+  {
+    OCR4A = OCRValue;
+  }
 
-    ///////////////////////////////////////////
+  // See TimerInterrupt::keepPendingClear()
+  static void keepPendingClear() __attribute__((always_inline))
+  {
+#if !TIMER_INTERRUPT_USING_ATMEGA_32U4
 
-    void disableTimer()
-    {
-      detachInterrupt();
-    }
+    if (TCNT4 == OCR4A)
+      TCNT4 = MAX_COUNT_16BIT;
 
-    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    void enableTimer(unsigned long duration = 0) __attribute__((always_inline))
-    {
-      reattachInterrupt(duration);
-    }
+#endif
+  }
 
-    ///////////////////////////////////////////
+  static void setCompareInterrupt(const bool& enable) __attribute__((always_inline))
+  {
+    bitWrite(TIMSK4, OCIE4A, enable);
+  }
+};
+#endif
 
-    // Just stop clock source, still keep the count
-    // void pauseTimer();
+#if defined(OCR5A)
+template<>
+struct TimerRegisters<5>
+{
+  static void setOCR(const uint16_t& OCRValue) __attribute__((always_inline))
+  {
+    OCR5A = OCRValue;
+  }
 
-    // Just stop clock source, still keep the count
-    void pauseTimer()
+  // See TimerInterrupt::keepPendingClear()
+  static void keepPendingClear() __attribute__((always_inline))
+  {
+    if (TCNT5 == OCR5A)
+      TCNT5 = MAX_COUNT_16BIT;
+  }
+
+  static void setCompareInterrupt(const bool& enable) __attribute__((always_inline))
+  {
+    bitWrite(TIMSK5, OCIE5A, enable);
+  }
+};
+#endif
+
+// TimerInterrupt bound to timer 'timerNo' at compile time. Same API, but its handleInterrupt(), the whole body of
+// ISR(TIMERn_COMPA_vect), has no getTimer() check, no switch (_timer) to find the OCRnA / TIMSKn registers, no
+// noInterrupts() / interrupts() (interrupts are already disabled in an AVR ISR), no reload of TIMSKn, and with
+// TIMER_CALLBACK_NO_PARAMS / TIMER_CALLBACK_WITH_PARAMS no _params test.
+// The cycles of both ISRs can be compared with the ISR_Cycles example
+template<uint8_t timerNo, uint8_t callbackKind = TIMER_INTERRUPT_DIRECT_CALLBACK>
+class TimerInterruptDirect : public TimerInterrupt
+{
+  public:
+
+    TimerInterruptDirect() : TimerInterrupt(timerNo)
     {
-      uint8_t andMask = 0b11111000;
+    };
 
-      //Just clear the CSx2-CSx0. Still keep the count in TCNT and Timer Interrupt mask TIMKSx.
+    // The timer is fixed, init(timer) is hidden
+    void init()
+    {
+      TimerInterrupt::init(timerNo);
+    };
 
-      // 8 bit timers from here
-#if defined(TCCR2B)
+    // To be called from ISR(TIMERn_COMPA_vect) only
+    void handleInterrupt() __attribute__((always_inline))
+    {
+      long countLocal = _toggle_count;
 
-      if (_timer == 2)
+      if (countLocal == 0)
       {
-        TCCR2B = (TCCR2B & andMask);
+        detachInterrupt();
 
-        TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
+        return;
       }
 
-#endif
+      if (_timerDone)
+      {
+        // Several chunks => reload the first one, before a long callback can delay it
+        if (_OCRValue > _OCRChunk)
+        {
+          if ( (timerNo != 2) || !_asyncClock )
+            TimerRegisters<timerNo>::keepPendingClear();
 
-      // 16 bit timers from here
-#if defined(TCCR1B)
-#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
+          if (timerNo == 2)
+            waitAsyncUpdate();
 
-      if (_timer == 1)
-#else
-      else if (_timer == 1)
-#endif
+          TimerRegisters<timerNo>::setOCR(_OCRChunk);
+
+          _OCRValueRemaining  = _OCRValue - _OCRChunk;
+          _timerDone          = false;
+        }
+
+        if (countLocal > 0)
+          _toggle_count = countLocal - 1;
+
+        callbackDirect();
+      }
+      else
       {
-        TCCR1B = (TCCR1B & andMask);
+        // Same as adjust_OCRValue()
+        uint32_t remaining = _OCRValueRemaining;
 
-        TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
+        if (remaining < _OCRChunk)
+        {
+          // Last chunk
+          if ( (timerNo != 2) || !_asyncClock )
+            TimerRegisters<timerNo>::keepPendingClear();
+
+          if (timerNo == 2)
+            waitAsyncUpdate();
+
+          TimerRegisters<timerNo>::setOCR(remaining);
+          remaining = 0;
+        }
+        else
+          remaining -= _OCRChunk;
+
+        if (remaining == 0)
+        {
+          _OCRValueRemaining  = _OCRValue;
+          _timerDone          = true;
+        }
+        else
+          _OCRValueRemaining  = remaining;
       }
+    };
 
-#endif
+  private:
 
-#if defined(TCCR3B)
-      else if (_timer == 3)
-        TCCR3B = (TCCR3B & andMask);
+    void callbackDirect() __attribute__((always_inline))
+    {
+      if (_nestedCallback)
+      {
+        // Same as TimerInterrupt::callback(), with TIMSKn known at compile time
+        if (_inNestedCallback || (_callback == NULL))
+          return;
 
-#endif
+        _inNestedCallback = true;
+        _nestedDetached   = false;
 
-#if defined(TCCR4B)
-      else if (_timer == 4)
-        TCCR4B = (TCCR4B & andMask);
+        TimerRegisters<timerNo>::setCompareInterrupt(false);
+        interrupts();
 
-#endif
+        callUserDirect();
 
-#if defined(TCCR5B)
-      else if (_timer == 5)
-        TCCR5B = (TCCR5B & andMask);
+        noInterrupts();
 
-#endif
-    }
+        if (!_nestedDetached)
+          TimerRegisters<timerNo>::setCompareInterrupt(true);
 
-    // Just reconnect clock source, continue from the current count
-    // void resumeTimer();
+        _inNestedCallback = false;
+      }
+      else
+        callUserDirect();
+    };
 
-    // Just reconnect clock source, continue from the current count
-    void resumeTimer()
+    void callUserDirect() __attribute__((always_inline))
     {
-      uint8_t andMask = 0b11111000;
+      if (callbackKind == TIMER_CALLBACK_NO_PARAMS)
+        (*(timer_callback) _callback)();
+      else if (callbackKind == TIMER_CALLBACK_WITH_PARAMS)
+        (*(timer_callback_p) _callback)(_params);
+      else if (_callback != NULL)
+        callUser();
+    };
+};
 
-      //Just restore the CSx2-CSx0 stored in _prescalerIndex. Still keep the count in TCNT and Timer Interrupt mask TIMKSx.
-      // 8 bit timers from here
-#if defined(TCCR2B)
+//////////////////////////////////////////////
 
-      if (_timer == 2)
+// Input capture of a 16-bit timer: the timer runs free, and each edge on its ICPn pin latches the count in ICRn,
+// in hardware. The period between two edges, extended to 32 bits by counting the overflows, goes to a ring buffer.
+// One capture interrupt per edge, plus one overflow interrupt every 65536 ticks.
+// ICP pins: 328P ICP1 = D8; 32u4 ICP1 = D4, ICP3 = D13; Mega ICP4 = D49, ICP5 = D48 (ICP1 / ICP3 not routed on the Mega)
+// A timer used by TimerCapture can't be used by TimerInterrupt at the same time
+
+#define CAPTURE_EDGE_FALLING      0
+#define CAPTURE_EDGE_RISING       1
+
+// Number of periods kept until read(), must be a power of 2
+#ifndef TIMER_CAPTURE_BUFFER_SIZE
+  #define TIMER_CAPTURE_BUFFER_SIZE     8
+#endif
+
+class TimerCapture
+{
+  private:
+
+    int8_t              _timer;
+    uint8_t             _prescalerIndex;
+
+    volatile uint16_t   _overflows;         // high 16 bits of the 32-bit count
+    volatile uint16_t   _idleOverflows;     // overflows since the last edge
+    uint32_t            _lastCapture;
+    bool                _hasLastCapture;
+
+    volatile uint32_t   _periods[TIMER_CAPTURE_BUFFER_SIZE];
+    volatile uint8_t    _head;              // only written by handleCapture()
+    volatile uint8_t    _tail;              // only written by read()
+    volatile uint16_t   _overruns;
+
+    void setControl(const uint8_t& edge, const bool& noiseCanceler)
+    {
+      // ICNCn is bit 7, ICESn bit 6 and CSn2-0 bits 2-0 of TCCRnB for all the 16-bit timers
+      uint8_t controlB = (noiseCanceler ? 0x80 : 0) | ( (edge == CAPTURE_EDGE_RISING) ? 0x40 : 0 ) | _prescalerIndex;
+
+      switch (_timer)
       {
-        TCCR2B = (TCCR2B & andMask) | _prescalerIndex;   //prescalarbits;
+#if defined(ICR1)
 
-        TISR_LOGWARN1(F("TCCR2B ="), TCCR2B);
-      }
+        case 1:
+          TCCR1A  = 0;
+          TCCR1B  = controlB;
+          break;
+#endif
+
+#if defined(ICR3)
 
+        case 3:
+          TCCR3A  = 0;
+          TCCR3B  = controlB;
+          break;
 #endif
 
-      // 16 bit timers from here
-#if defined(TCCR1B)
-#if ( TIMER_INTERRUPT_USING_ATMEGA_32U4 )
+#if defined(ICR4)
 
-      if (_timer == 1)
-#else
-      else if (_timer == 1)
+        case 4:
+          TCCR4A  = 0;
+          TCCR4B  = controlB;
+          break;
 #endif
-      {
-        TCCR1B = (TCCR1B & andMask) | _prescalerIndex;   //prescalarbits;
 
-        TISR_LOGWARN1(F("TCCR1B ="), TCCR1B);
+#if defined(ICR5)
+
+        case 5:
+          TCCR5A  = 0;
+          TCCR5B  = controlB;
+          break;
+#endif
       }
+    }
+
+    // Enable or disable the capture and overflow interrupts, clearing their pending flags
+    void enableInterrupts(const bool& enable)
+    {
+      switch (_timer)
+      {
+#if defined(ICR1)
 
+        case 1:
+          TIFR1 = bit(ICF1) | bit(TOV1);
+          bitWrite(TIMSK1, ICIE1, enable);
+          bitWrite(TIMSK1, TOIE1, enable);
+          break;
 #endif
 
-#if defined(TCCR3B)
-      else if (_timer == 3)
-        TCCR3B = (TCCR3B & andMask) | _prescalerIndex;   //prescalarbits;
+#if defined(ICR3)
 
+        case 3:
+          TIFR3 = bit(ICF3) | bit(TOV3);
+          bitWrite(TIMSK3, ICIE3, enable);
+          bitWrite(TIMSK3, TOIE3, enable);
+          break;
 #endif
 
-#if defined(TCCR4B)
-      else if (_timer == 4)
-        TCCR4B = (TCCR4B & andMask) | _prescalerIndex;   //prescalarbits;
+#if defined(ICR4)
 
+        case 4:
+          TIFR4 = bit(ICF4) | bit(TOV4);
+          bitWrite(TIMSK4, ICIE4, enable);
+          bitWrite(TIMSK4, TOIE4, enable);
+          break;
 #endif
 
-#if defined(TCCR5B)
-      else if (_timer == 5)
-        TCCR5B = (TCCR5B & andMask) | _prescalerIndex;   //prescalarbits;
+#if defined(ICR5)
 
+        case 5:
+          TIFR5 = bit(ICF5) | bit(TOV5);
+          bitWrite(TIMSK5, ICIE5, enable);
+          bitWrite(TIMSK5, TOIE5, enable);
+          break;
 #endif
+      }
     }
 
-    ///////////////////////////////////////////
-
+  public:
 
-    // Just stop clock source, clear the count
-    void stopTimer()
+    TimerCapture(const int8_t& timer)
     {
-      detachInterrupt();
-    }
+      _timer          = timer;
+      _prescalerIndex = PRESCALER_64;
+      _overflows      = 0;
+      _idleOverflows  = 0;
+      _lastCapture    = 0;
+      _hasLastCapture = false;
+      _head           = 0;
+      _tail           = 0;
+      _overruns       = 0;
+    };
 
-    // Just reconnect clock source, start current count from 0
-    void restartTimer(unsigned long duration = 0)
+    // Start capturing the periods between 'edge' edges, timer clocked at F_CPU / prescaler.
+    // The noise canceler delays the capture by 4 CPU cycles, filtering out shorter glitches.
+    // Returns false if the timer has no input capture
+    bool begin(const uint8_t& edge = CAPTURE_EDGE_RISING, const bool& noiseCanceler = true,
+               const uint8_t& prescalerIndex = PRESCALER_64)
     {
-      reattachInterrupt(duration);
-    }
+      if ( (prescalerIndex < NO_PRESCALER) || (prescalerIndex > PRESCALER_1024) )
+        return false;
 
-    int8_t getTimer() __attribute__((always_inline))
-    {
-      return _timer;
-    };
+      switch (_timer)
+      {
+#if defined(ICR1)
 
-    long getCount() __attribute__((always_inline))
-    {
-      return _toggle_count;
-    };
+        case 1:
+#endif
+#if defined(ICR3)
+        case 3:
+#endif
+#if defined(ICR4)
+        case 4:
+#endif
+#if defined(ICR5)
+        case 5:
+#endif
+          break;
+
+        default:
+          TISR_LOGERROR1(F("TimerCapture: no input capture for timer"), _timer);
+
+          return false;
+      }
 
-    void setCount(long countInput) __attribute__((always_inline))
-    {
       //cli();//stop interrupts
-      //noInterrupts();
+      noInterrupts();
 
-      _toggle_count = countInput;
+      _prescalerIndex = prescalerIndex;
+      _overflows      = 0;
+      _idleOverflows  = 0;
+      _hasLastCapture = false;
+      _head           = 0;
+      _tail           = 0;
+      _overruns       = 0;
+
+      // Normal mode, free running
+      setControl(edge, noiseCanceler);
+      enableInterrupts(true);
 
       //sei();//enable interrupts
-      //interrupts();
-    };
+      interrupts();
 
-    long get_OCRValue() __attribute__((always_inline))
-    {
-      return _OCRValue;
-    };
+      TISR_LOGWARN3(F("TimerCapture: timer ="), _timer, F(", preScalerIndex ="), _prescalerIndex);
 
-    long get_OCRValueRemaining() __attribute__((always_inline))
+      return true;
+    }
+
+    // Stop the capture. The periods not read yet are kept
+    void end()
     {
-      return _OCRValueRemaining;
-    };
+      //cli();//stop interrupts
+      noInterrupts();
 
-    void adjust_OCRValue() //__attribute__((always_inline))
+      enableInterrupts(false);
+
+      //sei();//enable interrupts
+      interrupts();
+    }
+
+    // Change the capture edge. The next period is measured from the first new edge
+    void setEdge(const uint8_t& edge, const bool& noiseCanceler = true)
     {
       //cli();//stop interrupts
       noInterrupts();
 
-      if (_timer != 2)
-      {
-#if TIMER_INTERRUPT_USING_ATMEGA_32U4
+      setControl(edge, noiseCanceler);
 
-        if (_timer == 4)
-        {
-          if (_OCRValueRemaining < MAX_COUNT_8BIT)
-          {
-            set_OCR();
-          }
+      // ICESn change can trigger a false capture
+      enableInterrupts(true);
+      _hasLastCapture = false;
 
-          _OCRValueRemaining -= min(MAX_COUNT_8BIT, _OCRValueRemaining);
-        }
-        else
-        {
-          if (_OCRValueRemaining < MAX_COUNT_16BIT)
-          {
-            set_OCR();
-          }
+      //sei();//enable interrupts
+      interrupts();
+    }
 
-          _OCRValueRemaining -= min(MAX_COUNT_16BIT, _OCRValueRemaining);
-        }
+    ///////////////////////////////////////////
 
-#else
+    // returns the number of periods to read
+    uint8_t available()
+    {
+      return (uint8_t) (_head - _tail);
+    }
 
-        if (_OCRValueRemaining < MAX_COUNT_16BIT)
-        {
-          set_OCR();
-        }
+    // Pop the oldest period, in timer ticks. Returns false if none
+    bool read(uint32_t& period)
+    {
+      uint8_t tail = _tail;
 
-        _OCRValueRemaining -= min(MAX_COUNT_16BIT, _OCRValueRemaining);
-#endif
-      }
-      else
-      {
-        if (_OCRValueRemaining < MAX_COUNT_8BIT)
-        {
-          set_OCR();
-        }
+      if (tail == _head)
+        return false;
 
-        _OCRValueRemaining -= min(MAX_COUNT_8BIT, _OCRValueRemaining);
-      }
+      period  = _periods[tail % TIMER_CAPTURE_BUFFER_SIZE];
+      _tail   = tail + 1;
 
-      if (_OCRValueRemaining <= 0)
-      {
-        // Reset value for next cycle
-        _OCRValueRemaining = _OCRValue;
-        _timerDone = true;
-      }
-      else
-        _timerDone = false;
+      return true;
+    }
 
-      //sei();//enable interrupts
-      interrupts();
-    };
+    // returns the timer frequency (Hz), to convert the periods from ticks
+    uint32_t getTickFrequency()
+    {
+      return F_CPU / prescalerDiv[_prescalerIndex];
+    }
 
-    void reload_OCRValue() //__attribute__((always_inline))
+    // returns the number of periods lost because the buffer was full
+    uint16_t getOverruns()
     {
-      //cli();//stop interrupts
-      noInterrupts();
+      return _overruns;
+    }
 
-      // Reset value for next cycle, have to deduct the value already loaded to OCR register
+    // true if no edge for over 2^32 ticks. The next edge starts a new measurement
+    bool isIdle()
+    {
+      return (_idleOverflows == 0xFFFF);
+    }
 
-      _OCRValueRemaining = _OCRValue;
-      set_OCR();
+    ///////////////////////////////////////////
 
-      _timerDone = false;
+    // To be called from ISR(TIMERn_CAPT_vect) only, with ICRn and the TOVn flag
+    void handleCapture(const uint16_t& capture, const bool& overflowPending) __attribute__((always_inline))
+    {
+      uint16_t high = _overflows;
 
-      //sei();//enable interrupts
-      interrupts();
-    };
+      // Overflow not handled yet, with the capture after it
+      if (overflowPending && (capture < 0x8000))
+        high++;
 
-    bool checkTimerDone() //__attribute__((always_inline))
+      uint32_t now = ( (uint32_t) high << 16 ) | capture;
+
+      if (_hasLastCapture && (_idleOverflows != 0xFFFF))
+      {
+        uint8_t head = _head;
+
+        if ( (uint8_t) (head - _tail) < TIMER_CAPTURE_BUFFER_SIZE )
+        {
+          _periods[head % TIMER_CAPTURE_BUFFER_SIZE] = now - _lastCapture;
+          _head = head + 1;
+        }
+        else
+          _overruns = _overruns + 1;
+      }
+
+      _lastCapture    = now;
+      _hasLastCapture = true;
+      _idleOverflows  = 0;
+    }
+
+    // To be called from ISR(TIMERn_OVF_vect) only
+    void handleOverflow() __attribute__((always_inline))
     {
-      return _timerDone;
-    };
+      _overflows = _overflows + 1;
 
-}; // class TimerInterrupt
+      if (_idleOverflows != 0xFFFF)
+        _idleOverflows = _idleOverflows + 1;
+    }
+};
 
 //////////////////////////////////////////////
 
@@ -1092,12 +2746,57 @@ class TimerInterrupt
   #error Timer5 is only available for Mega
 #endif
 
+// Input capture, with ICapture1, 3, 4 or 5
+#if !defined(USE_TIMER_1_CAPTURE)
+  #define USE_TIMER_1_CAPTURE     false
+#elif ( USE_TIMER_1_CAPTURE && USE_TIMER_1 )
+  #error Timer1 cannot be used by both USE_TIMER_1 and USE_TIMER_1_CAPTURE
+#endif
+
+#if !defined(USE_TIMER_3_CAPTURE)
+  #define USE_TIMER_3_CAPTURE     false
+#elif ( USE_TIMER_3_CAPTURE && USE_TIMER_3 )
+  #error Timer3 cannot be used by both USE_TIMER_3 and USE_TIMER_3_CAPTURE
+#elif ( USE_TIMER_3_CAPTURE && !( TIMER_INTERRUPT_USING_ATMEGA_32U4 || TIMER_INTERRUPT_USING_ATMEGA2560 ) )
+  #error Timer3 capture is only available for ATMEGA_32U4 and Mega
+#endif
+
+#if !defined(USE_TIMER_4_CAPTURE)
+  #define USE_TIMER_4_CAPTURE     false
+#elif ( USE_TIMER_4_CAPTURE && USE_TIMER_4 )
+  #error Timer4 cannot be used by both USE_TIMER_4 and USE_TIMER_4_CAPTURE
+#elif ( USE_TIMER_4_CAPTURE && !TIMER_INTERRUPT_USING_ATMEGA2560 )
+  #error Timer4 capture is only available for Mega
+#endif
+
+#if !defined(USE_TIMER_5_CAPTURE)
+  #define USE_TIMER_5_CAPTURE     false
+#elif ( USE_TIMER_5_CAPTURE && USE_TIMER_5 )
+  #error Timer5 cannot be used by both USE_TIMER_5 and USE_TIMER_5_CAPTURE
+#elif ( USE_TIMER_5_CAPTURE && !TIMER_INTERRUPT_USING_ATMEGA2560 )
+  #error Timer5 capture is only available for Mega
+#endif
+
 //////////////////////////////////////////////
 
 #if USE_TIMER_1
 #ifndef TIMER1_INSTANTIATED
 // To force pre-instatiate only once
 #define TIMER1_INSTANTIATED
+#if TIMER_INTERRUPT_DIRECT_ISR
+
+TimerInterruptDirect<HW_TIMER_1> ITimer1;
+
+// Timer0 is used for micros(), millis(), delay(), etc and can't be used
+// Pre-instatiate
+
+ISR(TIMER1_COMPA_vect)
+{
+  ITimer1.handleInterrupt();
+}
+
+#else
+
 TimerInterrupt ITimer1(HW_TIMER_1);
 
 // Timer0 is used for micros(), millis(), delay(), etc and can't be used
@@ -1115,22 +2814,23 @@ ISR(TIMER1_COMPA_vect)
       {
         TISR_LOGDEBUG3(("T1 callback, _OCRValueRemaining ="), ITimer1.get_OCRValueRemaining(), (", millis ="), millis());
 
-        ITimer1.callback();
-
-        // To reload _OCRValueRemaining as well as _OCR register to MAX_COUNT_16BIT if _OCRValueRemaining > MAX_COUNT_16BIT
-        if (ITimer1.get_OCRValue() > MAX_COUNT_16BIT)
+        // To reload _OCRValueRemaining as well as _OCR register to _OCRChunk if the period takes several chunks.
+        // Before the callback, so that a long callback does not delay it
+        if (ITimer1.get_OCRValue() > ITimer1.get_OCRChunk())
         {
           ITimer1.reload_OCRValue();
         }
 
         if (countLocal > 0)
           ITimer1.setCount(countLocal - 1);
+
+        ITimer1.callback();
       }
       else
       {
-        //Deduct _OCRValue by min(MAX_COUNT_16BIT, _OCRValue)
+        //Deduct _OCRValue by min(_OCRChunk, _OCRValue)
         // If _OCRValue == 0, flag _timerDone for next cycle
-        // If last one (_OCRValueRemaining < MAX_COUNT_16BIT) => load _OCR register _OCRValueRemaining
+        // If last one (_OCRValueRemaining < _OCRChunk) => load _OCR register _OCRValueRemaining
         ITimer1.adjust_OCRValue();
       }
     }
@@ -1143,12 +2843,25 @@ ISR(TIMER1_COMPA_vect)
   }
 }
 
+#endif    // TIMER_INTERRUPT_DIRECT_ISR
+
 #endif  //#ifndef TIMER1_INSTANTIATED
 #endif    //#if USE_TIMER_1
 
 #if USE_TIMER_2
 #ifndef TIMER2_INSTANTIATED
 #define TIMER2_INSTANTIATED
+#if TIMER_INTERRUPT_DIRECT_ISR
+
+TimerInterruptDirect<HW_TIMER_2> ITimer2;
+
+ISR(TIMER2_COMPA_vect)
+{
+  ITimer2.handleInterrupt();
+}
+
+#else
+
 TimerInterrupt ITimer2(HW_TIMER_2);
 
 ISR(TIMER2_COMPA_vect)
@@ -1163,10 +2876,9 @@ ISR(TIMER2_COMPA_vect)
       {
         TISR_LOGDEBUG3(("T2 callback, _OCRValueRemaining ="), ITimer2.get_OCRValueRemaining(), (", millis ="), millis());
 
-        ITimer2.callback();
-
-        // To reload _OCRValue
-        if (ITimer2.get_OCRValue() > MAX_COUNT_8BIT)
+        // To reload _OCRValue if the period takes several chunks.
+        // Before the callback, so that a long callback does not delay it
+        if (ITimer2.get_OCRValue() > ITimer2.get_OCRChunk())
         {
           ITimer2.reload_OCRValue();
         }
@@ -1174,10 +2886,11 @@ ISR(TIMER2_COMPA_vect)
         if (countLocal > 0)
           ITimer2.setCount(countLocal - 1);
 
+        ITimer2.callback();
       }
       else
       {
-        //Deduct _OCRValue by min(MAX_COUNT_8BIT, _OCRValue)
+        //Deduct _OCRValue by min(_OCRChunk, _OCRValue)
         // If _OCRValue == 0, flag _timerDone for next cycle
         ITimer2.adjust_OCRValue();
       }
@@ -1190,6 +2903,8 @@ ISR(TIMER2_COMPA_vect)
     }
   }
 }
+#endif    // TIMER_INTERRUPT_DIRECT_ISR
+
 #endif  //#ifndef TIMER2_INSTANTIATED
 #endif    //#if USE_TIMER_2
 
@@ -1200,6 +2915,17 @@ ISR(TIMER2_COMPA_vect)
 #ifndef TIMER3_INSTANTIATED
 // To force pre-instatiate only once
 #define TIMER3_INSTANTIATED
+#if TIMER_INTERRUPT_DIRECT_ISR
+
+TimerInterruptDirect<HW_TIMER_3> ITimer3;
+
+ISR(TIMER3_COMPA_vect)
+{
+  ITimer3.handleInterrupt();
+}
+
+#else
+
 TimerInterrupt ITimer3(HW_TIMER_3);
 
 ISR(TIMER3_COMPA_vect)
@@ -1214,22 +2940,23 @@ ISR(TIMER3_COMPA_vect)
       {
         TISR_LOGDEBUG3(("T3 callback, _OCRValueRemaining ="), ITimer3.get_OCRValueRemaining(), (", millis ="), millis());
 
-        ITimer3.callback();
-
-        // To reload _OCRValueRemaining as well as _OCR register to MAX_COUNT_16BIT
-        if (ITimer3.get_OCRValue() > MAX_COUNT_16BIT)
+        // To reload _OCRValueRemaining as well as _OCR register to _OCRChunk if the period takes several chunks.
+        // Before the callback, so that a long callback does not delay it
+        if (ITimer3.get_OCRValue() > ITimer3.get_OCRChunk())
         {
           ITimer3.reload_OCRValue();
         }
 
         if (countLocal > 0)
           ITimer3.setCount(countLocal - 1);
+
+        ITimer3.callback();
       }
       else
       {
-        //Deduct _OCRValue by min(MAX_COUNT_16BIT, _OCRValue)
+        //Deduct _OCRValue by min(_OCRChunk, _OCRValue)
         // If _OCRValue == 0, flag _timerDone for next cycle
-        // If last one (_OCRValueRemaining < MAX_COUNT_16BIT) => load _OCR register _OCRValueRemaining
+        // If last one (_OCRValueRemaining < _OCRChunk) => load _OCR register _OCRValueRemaining
         ITimer3.adjust_OCRValue();
       }
     }
@@ -1242,6 +2969,8 @@ ISR(TIMER3_COMPA_vect)
   }
 }
 
+#endif    // TIMER_INTERRUPT_DIRECT_ISR
+
 #endif  //#ifndef TIMER3_INSTANTIATED
 #endif    //#if USE_TIMER_3
 
@@ -1256,6 +2985,17 @@ ISR(TIMER3_COMPA_vect)
 #ifndef TIMER4_INSTANTIATED
 // To force pre-instatiate only once
 #define TIMER4_INSTANTIATED
+#if TIMER_INTERRUPT_DIRECT_ISR
+
+TimerInterruptDirect<HW_TIMER_4> ITimer4;
+
+ISR(TIMER4_COMPA_vect)
+{
+  ITimer4.handleInterrupt();
+}
+
+#else
+
 TimerInterrupt ITimer4(HW_TIMER_4);
 
 ISR(TIMER4_COMPA_vect)
@@ -1270,22 +3010,23 @@ ISR(TIMER4_COMPA_vect)
       {
         TISR_LOGDEBUG3(("T4 callback, _OCRValueRemaining ="), ITimer4.get_OCRValueRemaining(), (", millis ="), millis());
 
-        ITimer4.callback();
-
-        // To reload _OCRValueRemaining as well as _OCR register to MAX_COUNT_16BIT (Mega2560) or MAX_COUNT_8BIT (32u4)
-        if (ITimer4.get_OCRValue() > MAX_COUNT_16BIT)
+        // To reload _OCRValueRemaining as well as _OCR register to _OCRChunk if the period takes several chunks.
+        // Before the callback, so that a long callback does not delay it
+        if (ITimer4.get_OCRValue() > ITimer4.get_OCRChunk())
         {
           ITimer4.reload_OCRValue();
         }
 
         if (countLocal > 0)
           ITimer4.setCount(countLocal - 1);
+
+        ITimer4.callback();
       }
       else
       {
-        //Deduct _OCRValue by min(MAX_COUNT_16BIT, _OCRValue) or min(MAX_COUNT_8BIT, _OCRValue)
+        //Deduct _OCRValue by min(_OCRChunk, _OCRValue)
         // If _OCRValue == 0, flag _timerDone for next cycle
-        // If last one (_OCRValueRemaining < MAX_COUNT_16BIT / MAX_COUNT_8BIT) => load _OCR register _OCRValueRemaining
+        // If last one (_OCRValueRemaining < _OCRChunk) => load _OCR register _OCRValueRemaining
         ITimer4.adjust_OCRValue();
       }
     }
@@ -1299,6 +3040,8 @@ ISR(TIMER4_COMPA_vect)
 }
 
 
+#endif    // TIMER_INTERRUPT_DIRECT_ISR
+
 #endif  //#ifndef TIMER4_INSTANTIATED
 #endif    //#if USE_TIMER_4
 
@@ -1310,6 +3053,17 @@ ISR(TIMER4_COMPA_vect)
 #ifndef TIMER5_INSTANTIATED
 // To force pre-instatiate only once
 #define TIMER5_INSTANTIATED
+#if TIMER_INTERRUPT_DIRECT_ISR
+
+TimerInterruptDirect<HW_TIMER_5> ITimer5;
+
+ISR(TIMER5_COMPA_vect)
+{
+  ITimer5.handleInterrupt();
+}
+
+#else
+
 TimerInterrupt ITimer5(HW_TIMER_5);
 
 ISR(TIMER5_COMPA_vect)
@@ -1324,22 +3078,23 @@ ISR(TIMER5_COMPA_vect)
       {
         TISR_LOGDEBUG3(("T5 callback, _OCRValueRemaining ="), ITimer5.get_OCRValueRemaining(), (", millis ="), millis());
 
-        ITimer5.callback();
-
-        // To reload _OCRValueRemaining as well as _OCR register to MAX_COUNT_16BIT
-        if (ITimer5.get_OCRValue() > MAX_COUNT_16BIT)
+        // To reload _OCRValueRemaining as well as _OCR register to _OCRChunk if the period takes several chunks.
+        // Before the callback, so that a long callback does not delay it
+        if (ITimer5.get_OCRValue() > ITimer5.get_OCRChunk())
         {
           ITimer5.reload_OCRValue();
         }
 
         if (countLocal > 0)
           ITimer5.setCount(countLocal - 1);
+
+        ITimer5.callback();
       }
       else
       {
-        //Deduct _OCRValue by min(MAX_COUNT_16BIT, _OCRValue)
+        //Deduct _OCRValue by min(_OCRChunk, _OCRValue)
         // If _OCRValue == 0, flag _timerDone for next cycle
-        // If last one (_OCRValueRemaining < MAX_COUNT_16BIT) => load _OCR register _OCRValueRemaining
+        // If last one (_OCRValueRemaining < _OCRChunk) => load _OCR register _OCRValueRemaining
         ITimer5.adjust_OCRValue();
       }
     }
@@ -1352,10 +3107,90 @@ ISR(TIMER5_COMPA_vect)
   }
 }
 
+#endif    // TIMER_INTERRUPT_DIRECT_ISR
+
 #endif  //#ifndef TIMER5_INSTANTIATED
 #endif    //#if USE_TIMER_5
 
 #endif      //#if TIMER_INTERRUPT_USING_ATMEGA2560
 
+//////////////////////////////////////////////
+
+#if USE_TIMER_1_CAPTURE
+#ifndef TIMER1_CAPTURE_INSTANTIATED
+#define TIMER1_CAPTURE_INSTANTIATED
+
+TimerCapture ICapture1(HW_TIMER_1);
+
+ISR(TIMER1_CAPT_vect)
+{
+  ICapture1.handleCapture(ICR1, bitRead(TIFR1, TOV1));
+}
+
+ISR(TIMER1_OVF_vect)
+{
+  ICapture1.handleOverflow();
+}
+
+#endif  //#ifndef TIMER1_CAPTURE_INSTANTIATED
+#endif    //#if USE_TIMER_1_CAPTURE
+
+#if USE_TIMER_3_CAPTURE
+#ifndef TIMER3_CAPTURE_INSTANTIATED
+#define TIMER3_CAPTURE_INSTANTIATED
+
+TimerCapture ICapture3(HW_TIMER_3);
+
+ISR(TIMER3_CAPT_vect)
+{
+  ICapture3.handleCapture(ICR3, bitRead(TIFR3, TOV3));
+}
+
+ISR(TIMER3_OVF_vect)
+{
+  ICapture3.handleOverflow();
+}
+
+#endif  //#ifndef TIMER3_CAPTURE_INSTANTIATED
+#endif    //#if USE_TIMER_3_CAPTURE
+
+#if USE_TIMER_4_CAPTURE
+#ifndef TIMER4_CAPTURE_INSTANTIATED
+#define TIMER4_CAPTURE_INSTANTIATED
+
+TimerCapture ICapture4(HW_TIMER_4);
+
+ISR(TIMER4_CAPT_vect)
+{
+  ICapture4.handleCapture(ICR4, bitRead(TIFR4, TOV4));
+}
+
+ISR(TIMER4_OVF_vect)
+{
+  ICapture4.handleOverflow();
+}
+
+#endif  //#ifndef TIMER4_CAPTURE_INSTANTIATED
+#endif    //#if USE_TIMER_4_CAPTURE
+
+#if USE_TIMER_5_CAPTURE
+#ifndef TIMER5_CAPTURE_INSTANTIATED
+#define TIMER5_CAPTURE_INSTANTIATED
+
+TimerCapture ICapture5(HW_TIMER_5);
+
+ISR(TIMER5_CAPT_vect)
+{
+  ICapture5.handleCapture(ICR5, bitRead(TIFR5, TOV5));
+}
+
+ISR(TIMER5_OVF_vect)
+{
+  ICapture5.handleOverflow();
+}
+
+#endif  //#ifndef TIMER5_CAPTURE_INSTANTIATED
+#endif    //#if USE_TIMER_5_CAPTURE
+
 #endif      //#ifndef TimerInterrupt_h
 
@@ -129,6 +129,40 @@
 #include "TimerInterrupt_Generic_Debug.h"
 
 #include <driver/timer.h>
+#include <esp_timer.h>
+
+////////////////////////////////////////
+
+// true => the timer interrupt is registered with ESP_INTR_FLAG_IRAM, and keeps running while the flash cache is
+// disabled by NVS / SPIFFS writes or OTA, instead of being deferred until the end of the flash operation.
+// The callback, and all it calls, must then be IRAM_ATTR and only use data in DRAM: a callback out of IRAM is refused
+#ifndef TIMER_INTERRUPT_IRAM_SAFE
+  #define TIMER_INTERRUPT_IRAM_SAFE       false
+#endif
+
+#if TIMER_INTERRUPT_IRAM_SAFE
+  #include <soc/soc_memory_layout.h>
+
+  #define TIMER_INTR_ALLOC_FLAGS          ESP_INTR_FLAG_IRAM
+#else
+  #define TIMER_INTR_ALLOC_FLAGS          0
+#endif
+
+////////////////////////////////////////
+
+// Deferred mode, attachDeferredInterrupt(): the timer ISR only notifies a worker task, running the callback out of the
+// ISR, where it can use Wi-Fi, MQTT, files, Serial or float. Default core, priority and stack of this task
+#ifndef TIMER_DEFERRED_TASK_CORE
+  #define TIMER_DEFERRED_TASK_CORE        (portNUM_PROCESSORS - 1)
+#endif
+
+#ifndef TIMER_DEFERRED_TASK_PRIORITY
+  #define TIMER_DEFERRED_TASK_PRIORITY    (configMAX_PRIORITIES - 5)
+#endif
+
+#ifndef TIMER_DEFERRED_TASK_STACK_SIZE
+  #define TIMER_DEFERRED_TASK_STACK_SIZE  4096
+#endif
 
 ////////////////////////////////////////
 
@@ -259,9 +293,32 @@ typedef ESP32TimerInterrupt ESP32Timer;
 
 ////////////////////////////////////////
 
-#define TIMER_DIVIDER             80                                //  Hardware timer clock divider
-// TIMER_BASE_CLK = APB_CLK_FREQ = Frequency of the clock on the input of the timer groups
-#define TIMER_SCALE               (TIMER_BASE_CLK / TIMER_DIVIDER)  // convert counter value to seconds
+// The 16-bit prescaler divides the timer group clock by 2 to 65536. setFrequency() selects, for each timer, the smallest
+// divider whose alarm count fits the counter: the finest resolution, or a period error within one timer group clock cycle
+#define TIMER_MIN_DIVIDER         2
+#define TIMER_MAX_DIVIDER         65536
+
+// 64-bit counter on ESP32, 54-bit on ESP32_S2, ESP32_S3 and ESP32_C3
+#if defined(SOC_TIMER_GROUP_COUNTER_BIT_WIDTH)
+  #define TIMER_COUNTER_BITS      SOC_TIMER_GROUP_COUNTER_BIT_WIDTH
+#elif USING_ESP32_NEW_TIMERINTERRUPT
+  #define TIMER_COUNTER_BITS      64
+#else
+  #define TIMER_COUNTER_BITS      54
+#endif
+
+#define TIMER_MAX_COUNT           ( ~0ULL >> (64 - TIMER_COUNTER_BITS) )
+
+// Shortest alarm count, in timer ticks. The ISR takes some us, so that the shortest usable period is much longer
+#ifndef TIMER_MIN_ALARM_COUNT
+  #define TIMER_MIN_ALARM_COUNT   2
+#endif
+
+// true => ESP32_S3 and ESP32_C3 timer groups on the 40 MHz XTAL, not affected by CPU / APB frequency changes,
+// instead of the 80 MHz APB clock. No effect on ESP32 and ESP32_S2, always on APB
+#ifndef TIMER_USE_XTAL_CLOCK
+  #define TIMER_USE_XTAL_CLOCK    false
+#endif
 
 ////////////////////////////////////////
 
@@ -275,8 +332,26 @@ typedef ESP32TimerInterrupt ESP32Timer;
 
 ////////////////////////////////////////
 
+// Called from the timer ISR with the context given to setFrequency() / attachInterruptInterval(), or the timer number
+// (void *) timerNo without context. Returns true if a higher priority task has been woken
 typedef bool (*esp32_timer_callback)  (void *);
 
+// Deferred mode: called by the worker task, with the number of timer ticks since its last call. More than 1 => the
+// task was late, and (ticks - 1) ticks were missed
+typedef void (*esp32_deferred_callback)  (uint32_t ticks);
+
+////////////////////////////////////////
+
+// Deferred mode statistics, see getDeferredStats()
+typedef struct
+{
+  uint32_t  runs;             // calls of the deferred callback
+  uint32_t  missedTicks;      // ticks merged into a later call, as the task was late
+  uint32_t  lastLatencyUs;    // last ISR to task wakeup latency
+  uint32_t  maxLatencyUs;     // longest ISR to task wakeup latency
+  uint64_t  totalLatencyUs;   // sum of the latencies: average = totalLatencyUs / runs
+} esp32_deferred_stats_t;
+
 // For ESP32_C3, TIMER_MAX == 1
 // For ESP32 and ESP32_S2, TIMER_MAX == 2
 
@@ -292,11 +367,6 @@ typedef struct
 
 ////////////////////////////////////////
 
-// Warning: TIMER_SRC_CLK_XTAL only good for ESP32
-// Use TIMER_SRC_CLK_APB for ESP32_C3, ESP32_S2 and ESP32_S3
-
-////////////////////////////////////////
-
 class ESP32TimerInterrupt
 {
   private:
@@ -308,9 +378,9 @@ class ESP32TimerInterrupt
       .intr_type    = TIMER_INTR_MAX,
       .counter_dir  = TIMER_COUNT_UP,       //counts from 0 to counter value
       .auto_reload  = TIMER_AUTORELOAD_EN,  //reloads counter automatically
-      .divider      = TIMER_DIVIDER,
+      .divider      = TIMER_MIN_DIVIDER,
 #if (SOC_TIMER_GROUP_SUPPORT_XTAL)
-#if (USING_ESP32_TIMERINTERRUPT)
+#if (TIMER_USE_XTAL_CLOCK)
       .clk_src      = TIMER_SRC_CLK_XTAL    //Use XTAL as source clock
 #else
       .clk_src      = TIMER_SRC_CLK_APB     //Use APB as source clock
@@ -327,87 +397,198 @@ class ESP32TimerInterrupt
     uint8_t           _timerNo;
 
     esp32_timer_callback _callback;        // pointer to the callback function
-    float             _frequency;       // Timer frequency
+    float             _frequency;       // Timer tick frequency, timer group clock / divider
     uint64_t          _timerCount;      // count to activate timer
 
+    float             _interruptFrequency;  // requested interrupt frequency
+    uint32_t          _timerClock;          // clock on the input of the timer group
+    float             _periodErrorPPM;      // period error achieved by the last (re)configuration
+    bool              _apbCallbackAdded;
+
+    // Deferred mode
+    esp32_deferred_callback   _deferredCallback;
+    TaskHandle_t              _deferredTask;
+    volatile uint32_t         _isrMicros;           // time of the last ISR, low 32 bits of esp_timer_get_time()
+    esp32_deferred_stats_t    _deferredStats;
+    portMUX_TYPE              _statsMux;
+
     //xQueueHandle      s_timer_queue;
 
-  public:
+    ////////////////////////////////////////
+
+    uint32_t timerInputClock()
+    {
+#if (SOC_TIMER_GROUP_SUPPORT_XTAL)
+
+      // XTAL is not affected by CPU / APB frequency changes
+      if (stdConfig.clk_src == TIMER_SRC_CLK_XTAL)
+        return getXtalFrequencyMhz() * 1000000UL;
+
+#endif
+
+      return getApbFrequency();
+    }
 
     ////////////////////////////////////////
 
-    ESP32TimerInterrupt(uint8_t timerNo)
+    void updatePeriodError()
     {
-      _callback = NULL;
+      // achieved period = _timerCount / _frequency, requested period = 1 / _interruptFrequency
+      _periodErrorPPM = (float) ( ( ( (double) _timerCount * _interruptFrequency / _frequency ) - 1.0 ) * 1000000.0 );
+    }
 
-      if (timerNo < MAX_ESP32_NUM_TIMERS)
-      {
-        _timerNo  = timerNo;
+    ////////////////////////////////////////
 
-#if USING_ESP32_C3_NEW_TIMERINTERRUPT
+    // Divider and alarm count of a frequency, for all ESP32 variants: the smallest divider whose count fits the counter.
+    // Returns false if the frequency is out of range for this clock
+    static bool solveDivider(const uint32_t& clock, const float& frequency, uint32_t& divider, uint64_t& count)
+    {
+      if (frequency <= 0)
+        return false;
 
-        // Always using TIMER_INTR_T0
-        _timerIndex = (timer_idx_t)   ( (uint32_t) 0 );
+      // Timer group clock cycles per period
+      double clockCycles  = (double) clock / frequency;
+      double minDivider   = ceil(clockCycles / (double) TIMER_MAX_COUNT);
 
-        // timerNo == 0 => Group 0, timerNo == 1 => Group 1
-        _timerGroup = (timer_group_t) ( (uint32_t) timerNo);
+      if (minDivider > TIMER_MAX_DIVIDER)
+        return false;
 
-#else
+      divider = (minDivider < TIMER_MIN_DIVIDER) ? TIMER_MIN_DIVIDER : (uint32_t) minDivider;
 
-        _timerIndex = (timer_idx_t)   (_timerNo % TIMER_MAX);
+      double ticks = (clockCycles / divider) + 0.5;
 
-        _timerGroup = (timer_group_t) (_timerNo / TIMER_MAX);
+      count = (ticks >= (double) TIMER_MAX_COUNT) ? TIMER_MAX_COUNT : (uint64_t) ticks;
 
-#endif
-      }
-      else
+      return (count >= TIMER_MIN_ALARM_COUNT);
+    }
+
+    ////////////////////////////////////////
+
+    // Deferred mode ISR: only a notification, counting the ticks, to the worker task
+    static bool IRAM_ATTR deferredISR(void * arg)
+    {
+      ESP32TimerInterrupt * timer   = (ESP32TimerInterrupt *) arg;
+      BaseType_t            woken   = pdFALSE;
+
+      if (timer->_deferredTask == NULL)
+        return false;
+
+      timer->_isrMicros = (uint32_t) esp_timer_get_time();
+
+      vTaskNotifyGiveFromISR(timer->_deferredTask, &woken);
+
+      // true => the timer driver yields to the worker task at the end of the ISR
+      return (woken == pdTRUE);
+    }
+
+    ////////////////////////////////////////
+
+    // Deferred mode worker task
+    static void deferredTask(void * arg)
+    {
+      ESP32TimerInterrupt * timer = (ESP32TimerInterrupt *) arg;
+
+      for (;;)
       {
-        _timerNo  = MAX_ESP32_NUM_TIMERS;
+        // Ticks notified since the last wakeup
+        uint32_t ticks    = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t latency  = (uint32_t) esp_timer_get_time() - timer->_isrMicros;
+
+        if (ticks == 0)
+          continue;
+
+        portENTER_CRITICAL(&timer->_statsMux);
+
+        timer->_deferredStats.runs++;
+        timer->_deferredStats.missedTicks     += ticks - 1;
+        timer->_deferredStats.lastLatencyUs   = latency;
+        timer->_deferredStats.totalLatencyUs  += latency;
+
+        if (latency > timer->_deferredStats.maxLatencyUs)
+          timer->_deferredStats.maxLatencyUs = latency;
+
+        portEXIT_CRITICAL(&timer->_statsMux);
+
+        esp32_deferred_callback callback = timer->_deferredCallback;
+
+        if (callback)
+          callback(ticks);
       }
-    };
+    }
 
     ////////////////////////////////////////
 
-    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool setFrequency(const float& frequency, esp32_timer_callback callback)
+    static void apbChangeCallback(void * arg, apb_change_ev_t ev_type, uint32_t old_apb, uint32_t new_apb)
+    {
+      (void) old_apb;
+      (void) new_apb;
+
+      if (ev_type == APB_AFTER_CHANGE)
+        ((ESP32TimerInterrupt *) arg)->clockChanged();
+    }
+
+    ////////////////////////////////////////
+
+    // Starts the timer, callback called from the timer ISR with arg
+    bool configure(const float& frequency, esp32_timer_callback callback, void * arg)
     {
+#if TIMER_INTERRUPT_IRAM_SAFE
+
+      // Called with the flash cache disabled, a callback in flash would crash the CPU
+      if (!esp_ptr_in_iram( (const void *) callback))
+      {
+        TISR_LOGERROR(F("Error. TIMER_INTERRUPT_IRAM_SAFE: the callback must be IRAM_ATTR"));
+
+        return false;
+      }
+
+#endif
+
       if (_timerNo < MAX_ESP32_NUM_TIMERS)
       {
-        // select timer frequency is 1MHz for better accuracy. We don't use 16-bit prescaler for now.
-        // Will use later if very low frequency is needed.
-        _frequency  = TIMER_BASE_CLK / TIMER_DIVIDER;   //1000000;
-        _timerCount = (uint64_t) _frequency / frequency;
+        // Use the actual clock, as the APB clock may have been lowered by setCpuFrequencyMhz()
+        uint32_t  clock = timerInputClock();
+        uint32_t  divider;
+        uint64_t  count;
+
+        if (!solveDivider(clock, frequency, divider, count))
+        {
+          TISR_LOGERROR3(F("Error. Frequency out of range, clock ="), clock, F(", frequency ="), frequency);
+
+          return false;
+        }
+
+        _timerClock         = clock;
+        stdConfig.divider   = divider;
+        _frequency          = (float) _timerClock / divider;
+        _timerCount         = count;
+        _interruptFrequency = frequency;
+
+        updatePeriodError();
         // count up
 
 #if USING_ESP32_S2_NEW_TIMERINTERRUPT
-        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
-        TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
-        TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32), F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
+        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), _frequency);
 #elif USING_ESP32_S3_NEW_TIMERINTERRUPT
         // ESP32-S3 is embedded with four 54-bit general-purpose timers, which are based on 16-bit prescalers
         // and 54-bit auto-reload-capable up/down-timers
-        TISR_LOGWARN3(F("ESP32_S3_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
-        TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
-        TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32), F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
+        TISR_LOGWARN3(F("ESP32_S3_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), _frequency);
+#elif USING_ESP32_C3_NEW_TIMERINTERRUPT
+        TISR_LOGWARN3(F("ESP32_C3_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), _frequency);
 #else
-        TISR_LOGWARN3(F("ESP32_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
+        TISR_LOGWARN3(F("ESP32_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), _frequency);
+#endif
+        TISR_LOGWARN3(F("Timer clock ="), _timerClock, F(", divider ="), divider);
         TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
         TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32), F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
-#endif
+        TISR_LOGWARN3(F("Achieved frequency ="), getAchievedFrequency(), F(", period error (ppm) ="), _periodErrorPPM);
 
         timer_init(_timerGroup, _timerIndex, &stdConfig);
 
         // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
         timer_set_counter_value(_timerGroup, _timerIndex, 0x00000000ULL);
 
-        timer_set_alarm_value(_timerGroup, _timerIndex, TIMER_SCALE / frequency);
+        timer_set_alarm_value(_timerGroup, _timerIndex, _timerCount);
 
         // enable interrupts for _timerGroup, _timerIndex
         timer_enable_intr(_timerGroup, _timerIndex);
@@ -417,11 +598,17 @@ class ESP32TimerInterrupt
         // Register the ISR handler
         // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
         // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
-        //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
-        timer_isr_callback_add(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, 0);
+        // The ISR of the timer driver, calling _callback, is IRAM_ATTR, see TIMER_INTERRUPT_IRAM_SAFE
+        timer_isr_callback_add(_timerGroup, _timerIndex, _callback, arg, TIMER_INTR_ALLOC_FLAGS);
 
         timer_start(_timerGroup, _timerIndex);
 
+        // To be notified of CPU / APB frequency changes, see clockChanged()
+        if (!_apbCallbackAdded)
+        {
+          _apbCallbackAdded = addApbChangeCallback(this, apbChangeCallback);
+        }
+
         return true;
       }
       else
@@ -436,10 +623,106 @@ class ESP32TimerInterrupt
       }
     }
 
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32TimerInterrupt(uint8_t timerNo)
+    {
+      _callback = NULL;
+
+      _frequency          = 0;
+      _timerCount         = 0;
+      _interruptFrequency = 0;
+      _timerClock         = 0;
+      _periodErrorPPM     = 0;
+      _apbCallbackAdded   = false;
+
+      _deferredCallback   = NULL;
+      _deferredTask       = NULL;
+      _isrMicros          = 0;
+      _statsMux           = portMUX_INITIALIZER_UNLOCKED;
+
+      resetDeferredStats();
+
+      if (timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        _timerNo  = timerNo;
+
+#if USING_ESP32_C3_NEW_TIMERINTERRUPT
+
+        // Always using TIMER_INTR_T0
+        _timerIndex = (timer_idx_t)   ( (uint32_t) 0 );
+
+        // timerNo == 0 => Group 0, timerNo == 1 => Group 1
+        _timerGroup = (timer_group_t) ( (uint32_t) timerNo);
+
+#else
+
+        _timerIndex = (timer_idx_t)   (_timerNo % TIMER_MAX);
+
+        _timerGroup = (timer_group_t) (_timerNo / TIMER_MAX);
+
+#endif
+      }
+      else
+      {
+        _timerNo  = MAX_ESP32_NUM_TIMERS;
+      }
+    };
+
+    ////////////////////////////////////////
+
+    // The APB change callback, the timer ISR and the deferred task all use this object: none must outlive it
+    ~ESP32TimerInterrupt()
+    {
+      if (_apbCallbackAdded)
+      {
+        removeApbChangeCallback(this, apbChangeCallback);
+      }
+
+      if ( (_timerNo < MAX_ESP32_NUM_TIMERS) && (_callback != NULL) )
+      {
+        timer_pause(_timerGroup, _timerIndex);
+        timer_isr_callback_remove(_timerGroup, _timerIndex);
+      }
+
+      if (_deferredTask != NULL)
+      {
+        vTaskDelete(_deferredTask);
+      }
+    };
+
+    ////////////////////////////////////////
+
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // No duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    // callback(context), or callback((void *) timerNo) without context
+    bool setFrequency(const float& frequency, esp32_timer_callback callback, void * context)
+    {
+      _deferredCallback = NULL;
+
+      return configure(frequency, callback, context);
+    }
+
+    ////////////////////////////////////////
+
+    bool setFrequency(const float& frequency, esp32_timer_callback callback)
+    {
+      return setFrequency(frequency, callback, (void *) (uint32_t) _timerNo);
+    }
+
     ////////////////////////////////////////
 
     // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    // No duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool setInterval(const unsigned long& interval, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency((float) (1000000.0f / interval), callback, context);
+    }
+
+    ////////////////////////////////////////
+
     bool setInterval(const unsigned long& interval, esp32_timer_callback callback)
     {
       return setFrequency((float) (1000000.0f / interval), callback);
@@ -447,6 +730,13 @@ class ESP32TimerInterrupt
 
     ////////////////////////////////////////
 
+    bool attachInterrupt(const float& frequency, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency(frequency, callback, context);
+    }
+
+    ////////////////////////////////////////
+
     bool attachInterrupt(const float& frequency, esp32_timer_callback callback)
     {
       return setFrequency(frequency, callback);
@@ -455,7 +745,14 @@ class ESP32TimerInterrupt
     ////////////////////////////////////////
 
     // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    // No duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback, context);
+    }
+
+    ////////////////////////////////////////
+
     bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback)
     {
       return setFrequency( (float) ( 1000000.0f / interval), callback);
@@ -463,6 +760,114 @@ class ESP32TimerInterrupt
 
     ////////////////////////////////////////
 
+    // Member function callbacks: ITimer0.attachInterrupt(frequency, &motor, &Motor::step) calls motor.step() from the ISR.
+    // No trampoline: with the g++ bound member function extension, the ISR of the timer driver calls Motor::step
+    // directly, with &motor as this. A virtual method is resolved here, once. It must be IRAM_ATTR, as any callback
+    template<class T, class C>
+    bool attachInterrupt(const float& frequency, T * object, bool (C::*method)())
+    {
+      C * context = static_cast<C *>(object);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+      esp32_timer_callback callback = (esp32_timer_callback) (context->*method);
+#pragma GCC diagnostic pop
+
+      return setFrequency(frequency, callback, (void *) context);
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds)
+    template<class T, class C>
+    bool attachInterruptInterval(const unsigned long& interval, T * object, bool (C::*method)())
+    {
+      return attachInterrupt( (float) ( 1000000.0f / interval), object, method);
+    }
+
+    ////////////////////////////////////////
+
+    // Deferred mode: callback(ticks) runs in a worker task, pinned to core, notified by the timer ISR, instead of in the
+    // ISR. The task is created by the first call: later calls change callback and priority, not core nor stack size
+    bool attachDeferredInterrupt(const float& frequency, esp32_deferred_callback callback,
+                                 const BaseType_t& core = TIMER_DEFERRED_TASK_CORE,
+                                 const UBaseType_t& priority = TIMER_DEFERRED_TASK_PRIORITY,
+                                 const uint32_t& stackSize = TIMER_DEFERRED_TASK_STACK_SIZE)
+    {
+      if ( (callback == NULL) || (_timerNo >= MAX_ESP32_NUM_TIMERS) )
+      {
+        TISR_LOGERROR(F("Error. attachDeferredInterrupt: no callback or bad timer"));
+
+        return false;
+      }
+
+      _deferredCallback = callback;
+
+      if (_deferredTask == NULL)
+      {
+        static const char * const taskNames[] = { "Timer0Defer", "Timer1Defer", "Timer2Defer", "Timer3Defer" };
+
+        if (xTaskCreatePinnedToCore(deferredTask, taskNames[_timerNo], stackSize, this, priority, &_deferredTask,
+                                    core) != pdPASS)
+        {
+          _deferredTask = NULL;
+
+          TISR_LOGERROR(F("Error. attachDeferredInterrupt: can't create the task"));
+
+          return false;
+        }
+
+        TISR_LOGWARN3(F("Deferred task on core"), core, F(", priority ="), priority);
+      }
+      else
+      {
+        vTaskPrioritySet(_deferredTask, priority);
+      }
+
+      resetDeferredStats();
+
+      return configure(frequency, deferredISR, this);
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds)
+    bool attachDeferredInterruptInterval(const unsigned long& interval, esp32_deferred_callback callback,
+                                         const BaseType_t& core = TIMER_DEFERRED_TASK_CORE,
+                                         const UBaseType_t& priority = TIMER_DEFERRED_TASK_PRIORITY,
+                                         const uint32_t& stackSize = TIMER_DEFERRED_TASK_STACK_SIZE)
+    {
+      return attachDeferredInterrupt( (float) ( 1000000.0f / interval), callback, core, priority, stackSize);
+    }
+
+    ////////////////////////////////////////
+
+    // Deferred mode statistics, copied at once
+    void getDeferredStats(esp32_deferred_stats_t& stats)
+    {
+      portENTER_CRITICAL(&_statsMux);
+      stats = _deferredStats;
+      portEXIT_CRITICAL(&_statsMux);
+    }
+
+    ////////////////////////////////////////
+
+    void resetDeferredStats()
+    {
+      portENTER_CRITICAL(&_statsMux);
+      memset(&_deferredStats, 0, sizeof(_deferredStats));
+      portEXIT_CRITICAL(&_statsMux);
+    }
+
+    ////////////////////////////////////////
+
+    TaskHandle_t getDeferredTask() __attribute__((always_inline))
+    {
+      return _deferredTask;
+    };
+
+    ////////////////////////////////////////
+
     void detachInterrupt()
     {
 #if USING_ESP32_C3_NEW_TIMERINTERRUPT
@@ -526,6 +931,99 @@ class ESP32TimerInterrupt
 
     ////////////////////////////////////////
 
+    // Reload divider and counts after a change of the timer input clock, keeping the current phase.
+    // Called automatically by setCpuFrequencyMhz() through the APB change callback
+    // Returns false if the timer is not running
+    bool clockChanged()
+    {
+      if ( (_timerNo >= MAX_ESP32_NUM_TIMERS) || (_callback == NULL) || (_frequency <= 0) )
+      {
+        return false;
+      }
+
+      uint32_t newClock = timerInputClock();
+
+      if (newClock == _timerClock)
+      {
+        return true;
+      }
+
+      uint32_t  divider;
+      uint64_t  newCount;
+
+      if (!solveDivider(newClock, _interruptFrequency, divider, newCount))
+      {
+        TISR_LOGERROR3(F("clockChanged: frequency out of range, clock ="), newClock, F(", frequency ="), _interruptFrequency);
+
+        return false;
+      }
+
+      float     newFrequency  = (float) newClock / divider;
+      uint64_t  counterValue;
+
+      timer_pause(_timerGroup, _timerIndex);
+      timer_get_counter_value(_timerGroup, _timerIndex, &counterValue);
+
+      timer_set_divider(_timerGroup, _timerIndex, divider);
+
+      if (newCount != _timerCount)
+      {
+        // Same position inside the current period
+        counterValue = (uint64_t) ( (double) counterValue * newCount / _timerCount );
+
+        timer_set_counter_value(_timerGroup, _timerIndex, counterValue);
+        timer_set_alarm_value(_timerGroup, _timerIndex, newCount);
+      }
+
+      timer_start(_timerGroup, _timerIndex);
+
+      stdConfig.divider = divider;
+      _timerClock       = newClock;
+      _frequency        = newFrequency;
+      _timerCount       = newCount;
+
+      updatePeriodError();
+
+      TISR_LOGWARN3(F("clockChanged: _timerNo ="), _timerNo, F(", clock ="), newClock);
+      TISR_LOGWARN3(F("divider ="), divider, F(", period error (ppm) ="), _periodErrorPPM);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Period error, in ppm, achieved by the last setFrequency() or clock change
+    float getPeriodErrorPPM() __attribute__((always_inline))
+    {
+      return _periodErrorPPM;
+    };
+
+    ////////////////////////////////////////
+
+    // Interrupt frequency achieved by the last setFrequency() or clock change, tick frequency / alarm count
+    float getAchievedFrequency()
+    {
+      return (_timerCount == 0) ? 0 : (float) ( (double) _frequency / _timerCount );
+    };
+
+    ////////////////////////////////////////
+
+    // Prescaler divider selected for the current frequency, 2-65536
+    uint32_t getDivider() __attribute__((always_inline))
+    {
+      return stdConfig.divider;
+    };
+
+    ////////////////////////////////////////
+
+    // Clock on the input of the timer group: APB or XTAL, see TIMER_USE_XTAL_CLOCK
+    uint32_t getClockFrequency() __attribute__((always_inline))
+    {
+      return _timerClock;
+    };
+
+    ////////////////////////////////////////
+
     int8_t getTimer() __attribute__((always_inline))
     {
       return _timerIndex;
@@ -542,5 +1040,357 @@ class ESP32TimerInterrupt
 
 }; // class ESP32TimerInterrupt
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+#if ( USING_ESP32_S3_NEW_TIMERINTERRUPT || USING_ESP32_C3_NEW_TIMERINTERRUPT )
+
+#include <hal/systimer_ll.h>
+#include <esp_intr_alloc.h>
+
+////////////////////////////////////////
+
+// ESP32_S3 and ESP32_C3 SYSTIMER: 52-bit counter at 16 MHz, from the XTAL, whatever the CPU / APB frequency,
+// and 3 alarms, shared with ESP-IDF: alarms 0 and 1 are the FreeRTOS tick of core 0 and 1, alarm 2 is esp_timer.
+// ESP32SysTimerInterrupt(alarm) can use the alarms of SYSTIMER_FREE_ALARMS: by default alarm 1 when FreeRTOS runs
+// on a single core (ESP32_C3, or CONFIG_FREERTOS_UNICORE), alarms 0 and 1 when the tick doesn't use the SYSTIMER
+#define SYSTIMER_CLOCK_FREQUENCY        16000000UL
+#define SYSTIMER_NUM_ALARMS             3
+
+// Counter 0, of esp_timer, always running: the alarms are on the esp_timer_get_time() timebase
+#define SYSTIMER_COUNTER                0
+
+#ifndef SYSTIMER_FREE_ALARMS
+  #if ( defined(CONFIG_FREERTOS_SYSTICK_USES_SYSTIMER) || USING_ESP32_C3_NEW_TIMERINTERRUPT )
+    #if ( CONFIG_FREERTOS_UNICORE || USING_ESP32_C3_NEW_TIMERINTERRUPT )
+      #define SYSTIMER_FREE_ALARMS      0x02
+    #else
+      #define SYSTIMER_FREE_ALARMS      0x00
+    #endif
+  #else
+    #define SYSTIMER_FREE_ALARMS        0x03
+  #endif
+#endif
+
+// Shortest period, and shortest time from now to a new alarm target, in SYSTIMER ticks
+#define SYSTIMER_MIN_ALARM_TICKS        64
+#define SYSTIMER_MIN_LEAD_TICKS         32
+
+// Longest period: half the 52-bit counter
+#define SYSTIMER_MAX_ALARM_TICKS        ( 1ULL << 51 )
+
+#if SOC_SYSTIMER_INT_LEVEL
+  #define SYSTIMER_INTR_ALLOC_FLAGS     TIMER_INTR_ALLOC_FLAGS
+#else
+  #define SYSTIMER_INTR_ALLOC_FLAGS     ( TIMER_INTR_ALLOC_FLAGS | ESP_INTR_FLAG_EDGE )
+#endif
+
+////////////////////////////////////////
+
+class ESP32SysTimerInterrupt;
+
+typedef ESP32SysTimerInterrupt ESP32SysTimer;
+
+////////////////////////////////////////
+
+// Same API as ESP32TimerInterrupt, on a SYSTIMER alarm. Each alarm is re-armed by its ISR on the absolute target
+// previous target + period: no prescaler, no chunking, no drift, and periods up to years
+class ESP32SysTimerInterrupt
+{
+  private:
+
+    uint8_t               _alarm;
+    esp32_timer_callback  _callback;
+    void *                _context;
+    intr_handle_t         _intrHandle;
+
+    uint64_t              _period;              // in SYSTIMER ticks
+    uint64_t              _target;              // next alarm, on counter SYSTIMER_COUNTER
+    float                 _frequency;           // requested interrupt frequency
+    volatile bool         _enabled;
+    volatile uint32_t     _missedPeriods;       // periods skipped, as the ISR was later than a period
+
+    ////////////////////////////////////////
+
+    // esp_timer_get_time() is counter 0 / 16, read safely against esp_timer, and up to 15 ticks late
+    static uint64_t IRAM_ATTR counterNow()
+    {
+      return (uint64_t) esp_timer_get_time() * (SYSTIMER_CLOCK_FREQUENCY / 1000000UL) + 15;
+    }
+
+    ////////////////////////////////////////
+
+    void IRAM_ATTR setTarget(const uint64_t& target)
+    {
+      systimer_ll_enable_alarm(&SYSTIMER, _alarm, false);
+      systimer_ll_set_alarm_target(&SYSTIMER, _alarm, target);
+      systimer_ll_apply_alarm_value(&SYSTIMER, _alarm);
+      systimer_ll_enable_alarm(&SYSTIMER, _alarm, true);
+    }
+
+    ////////////////////////////////////////
+
+    // Next alarm on target + k * period, skipping the periods already passed, as a target in the past never fires
+    void IRAM_ATTR rearm()
+    {
+      uint64_t earliest = counterNow() + SYSTIMER_MIN_LEAD_TICKS;
+
+      _target += _period;
+
+      if (_target < earliest)
+      {
+        uint64_t skipped = ( (earliest - _target) / _period ) + 1;
+
+        _target         += skipped * _period;
+        _missedPeriods  += (uint32_t) skipped;
+      }
+
+      setTarget(_target);
+    }
+
+    ////////////////////////////////////////
+
+    static void IRAM_ATTR alarmISR(void * arg)
+    {
+      ESP32SysTimerInterrupt * timer = (ESP32SysTimerInterrupt *) arg;
+
+      systimer_ll_clear_alarm_int(&SYSTIMER, timer->_alarm);
+
+      if (!timer->_enabled)
+        return;
+
+      timer->rearm();
+
+      if ( timer->_callback && (*timer->_callback)(timer->_context) )
+        portYIELD_FROM_ISR();
+    }
+
+    ////////////////////////////////////////
+
+    void startAlarm()
+    {
+      _target   = counterNow() + _period;
+      _enabled  = true;
+
+      setTarget(_target);
+    }
+
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32SysTimerInterrupt(uint8_t alarm)
+    {
+      _alarm          = alarm;
+      _callback       = NULL;
+      _context        = NULL;
+      _intrHandle     = NULL;
+      _period         = 0;
+      _target         = 0;
+      _frequency      = 0;
+      _enabled        = false;
+      _missedPeriods  = 0;
+    };
+
+    ////////////////////////////////////////
+
+    // frequency (in hertz), callback(context) called from the alarm ISR
+    bool setFrequency(const float& frequency, esp32_timer_callback callback, void * context)
+    {
+      if ( (_alarm >= SYSTIMER_NUM_ALARMS) || !(SYSTIMER_FREE_ALARMS & (1 << _alarm)) )
+      {
+        TISR_LOGERROR3(F("Error. SYSTIMER alarm"), _alarm, F("not free, SYSTIMER_FREE_ALARMS ="), SYSTIMER_FREE_ALARMS);
+
+        return false;
+      }
+
+#if TIMER_INTERRUPT_IRAM_SAFE
+
+      if (!esp_ptr_in_iram( (const void *) callback))
+      {
+        TISR_LOGERROR(F("Error. TIMER_INTERRUPT_IRAM_SAFE: the callback must be IRAM_ATTR"));
+
+        return false;
+      }
+
+#endif
+
+      double ticks = (frequency > 0) ? ( ( (double) SYSTIMER_CLOCK_FREQUENCY / frequency ) + 0.5 ) : 0;
+
+      if ( (ticks < SYSTIMER_MIN_ALARM_TICKS) || (ticks > (double) SYSTIMER_MAX_ALARM_TICKS) )
+      {
+        TISR_LOGERROR1(F("Error. SYSTIMER frequency out of range ="), frequency);
+
+        return false;
+      }
+
+      _enabled = false;
+      systimer_ll_enable_alarm(&SYSTIMER, _alarm, false);
+
+      _period         = (uint64_t) ticks;
+      _frequency      = frequency;
+      _callback       = callback;
+      _context        = context;
+      _missedPeriods  = 0;
+
+      if (_intrHandle == NULL)
+      {
+        systimer_ll_connect_alarm_counter(&SYSTIMER, _alarm, SYSTIMER_COUNTER);
+        systimer_ll_enable_alarm_oneshot(&SYSTIMER, _alarm);
+
+        if (esp_intr_alloc(ETS_SYSTIMER_TARGET0_EDGE_INTR_SOURCE + _alarm, SYSTIMER_INTR_ALLOC_FLAGS, alarmISR, this,
+                           &_intrHandle) != ESP_OK)
+        {
+          _intrHandle = NULL;
+
+          TISR_LOGERROR1(F("Error. Can't allocate the interrupt of SYSTIMER alarm"), _alarm);
+
+          return false;
+        }
+
+        systimer_ll_enable_alarm_int(&SYSTIMER, _alarm, true);
+      }
+
+      TISR_LOGWARN3(F("ESP32SysTimer: alarm ="), _alarm, F(", period (ticks) ="), (uint32_t) _period);
+      TISR_LOGWARN3(F("Achieved frequency ="), getAchievedFrequency(), F(", period error (ppm) ="), getPeriodErrorPPM());
+
+      startAlarm();
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    bool setFrequency(const float& frequency, esp32_timer_callback callback)
+    {
+      return setFrequency(frequency, callback, (void *) (uint32_t) _alarm);
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds)
+    bool setInterval(const unsigned long& interval, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback, context);
+    }
+
+    ////////////////////////////////////////
+
+    bool setInterval(const unsigned long& interval, esp32_timer_callback callback)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback);
+    }
+
+    ////////////////////////////////////////
+
+    bool attachInterrupt(const float& frequency, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency(frequency, callback, context);
+    }
+
+    ////////////////////////////////////////
+
+    bool attachInterrupt(const float& frequency, esp32_timer_callback callback)
+    {
+      return setFrequency(frequency, callback);
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds)
+    bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback, void * context)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback, context);
+    }
+
+    ////////////////////////////////////////
+
+    bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback);
+    }
+
+    ////////////////////////////////////////
+
+    void detachInterrupt()
+    {
+      _enabled = false;
+      systimer_ll_enable_alarm(&SYSTIMER, _alarm, false);
+    }
+
+    ////////////////////////////////////////
+
+    void disableTimer()
+    {
+      detachInterrupt();
+    }
+
+    ////////////////////////////////////////
+
+    // Restarts a full period from now
+    void reattachInterrupt()
+    {
+      if (_period != 0)
+        startAlarm();
+    }
+
+    ////////////////////////////////////////
+
+    void enableTimer()
+    {
+      reattachInterrupt();
+    }
+
+    ////////////////////////////////////////
+
+    // The SYSTIMER counter keeps running, only the alarm stops
+    void stopTimer()
+    {
+      detachInterrupt();
+    }
+
+    ////////////////////////////////////////
+
+    void restartTimer()
+    {
+      reattachInterrupt();
+    }
+
+    ////////////////////////////////////////
+
+    float getAchievedFrequency()
+    {
+      return (_period == 0) ? 0 : (float) ( (double) SYSTIMER_CLOCK_FREQUENCY / _period );
+    };
+
+    ////////////////////////////////////////
+
+    // Period error, in ppm, of the last setFrequency()
+    float getPeriodErrorPPM()
+    {
+      return (_period == 0) ? 0 : (float) ( ( ( (double) _period * _frequency / SYSTIMER_CLOCK_FREQUENCY ) - 1.0 ) * 1000000.0 );
+    };
+
+    ////////////////////////////////////////
+
+    // Periods skipped since setFrequency(), as the ISR was later than a period
+    uint32_t getMissedPeriods() __attribute__((always_inline))
+    {
+      return _missedPeriods;
+    };
+
+    ////////////////////////////////////////
+
+    int8_t getAlarm() __attribute__((always_inline))
+    {
+      return _alarm;
+    };
+
+    ////////////////////////////////////////
+
+}; // class ESP32SysTimerInterrupt
+
+#endif    // ( USING_ESP32_S3_NEW_TIMERINTERRUPT || USING_ESP32_C3_NEW_TIMERINTERRUPT )
+
 #endif    // ESP32_NEW_TIMERINTERRUPT_H
 
@@ -0,0 +1,697 @@
+/********************************************************************************************************************************
+  ESP32Waveform_Generic.h
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.0+
+  Written by Khoi Hoang
+
+  Hardware waveforms, with the frequency / interval API of ESP32TimerInterrupt, instead of toggling a pin in a timer
+  callback: no interrupt per edge, and no jitter from Wi-Fi or other interrupts.
+
+    setPWM(frequency, duty), setSquareWave(frequency)       LEDC: fixed duty PWM, no CPU work at all
+    queuePulses(table, count)                               RMT: gap-free stream of pulse tables, double buffered
+
+  A pulse table is an array of esp32_pulse_t, each two levels with their durations in RMT ticks, see
+  setPulseResolution(). At most two tables are queued: while the RMT plays one, the next one is filled and queued.
+  The RAM of the RMT channel is used as two halves: while the RMT sends one, its TX threshold interrupt copies the
+  next items of the queued tables into the other one, going on with the next table straight after the last item of
+  the previous one. The pulses are then one gap-free stream, the CPU only copies WAVEFORM_RMT_MEM_ITEMS / 2 items
+  per interrupt. A table is free again, with the setPulseDone() callback, as soon as its last items are copied. When
+  no table is queued in time, the stream ends, on the idle level, and getUnderruns() counts it.
+
+  The RMT interrupt is registered with rmt_isr_register(): the RMT driver, rmt_driver_install(), can't be used on
+  the other RMT channels at the same time.
+
+  EXPERIMENTAL: queuePulses() has not been tested on hardware yet.
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Version: 1.13.0
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32_WAVEFORM_GENERIC_H
+#define ESP32_WAVEFORM_GENERIC_H
+
+#if !( defined(ESP32) || ESP32 )
+  #error ESP32Waveform_Generic.h is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+#include <Arduino.h>
+
+#include "TimerInterrupt_Generic_Debug.h"
+
+#include <driver/rmt.h>
+#include <hal/rmt_ll.h>
+#include <soc/rmt_struct.h>
+#include <soc/soc_caps.h>
+
+///////////////////////////////////////////
+
+// LEDC counter width: 20 bits on ESP32, 14 on ESP32_S2, ESP32_S3 and ESP32_C3
+#if defined(SOC_LEDC_TIMER_BIT_WIDE_NUM)
+  #define WAVEFORM_LEDC_MAX_BITS        SOC_LEDC_TIMER_BIT_WIDE_NUM
+#else
+  #define WAVEFORM_LEDC_MAX_BITS        14
+#endif
+
+// Default RMT tick, in ns: 1 us, the durations of an esp32_pulse_t are then up to 32767 us
+#ifndef WAVEFORM_RMT_TICK_NS
+  #define WAVEFORM_RMT_TICK_NS          1000
+#endif
+
+// RMT memory blocks of the channel, 64 items each on ESP32 / ESP32_S2, 48 on ESP32_S3 / ESP32_C3. More blocks, taken
+// from the next channels, refill less often
+#ifndef WAVEFORM_RMT_MEM_BLOCKS
+  #define WAVEFORM_RMT_MEM_BLOCKS       1
+#endif
+
+// Items in the RMT RAM of the channel, refilled by halves
+#define WAVEFORM_RMT_MEM_ITEMS          (SOC_RMT_MEM_WORDS_PER_CHANNEL * WAVEFORM_RMT_MEM_BLOCKS)
+
+#define WAVEFORM_NONE                   0
+#define WAVEFORM_PWM                    1
+#define WAVEFORM_PULSES                 2
+
+// Tables queued at most, playing one included
+#define WAVEFORM_QUEUE_SIZE             2
+
+///////////////////////////////////////////
+
+// level0 for duration0 ticks, then level1 for duration1 ticks. A zero duration ends the stream
+typedef rmt_item32_t esp32_pulse_t;
+
+// Called from the RMT interrupt, or from queuePulses(), when the table queued by queuePulses() has been copied into
+// the RMT RAM, and can be filled again
+typedef void (*esp32_pulse_callback)(const esp32_pulse_t* table);
+
+///////////////////////////////////////////
+
+class ESP32WaveformTimer;
+
+typedef ESP32WaveformTimer ESP32Waveform;
+
+///////////////////////////////////////////
+
+class ESP32WaveformTimer
+{
+  private:
+
+    typedef struct
+    {
+      const esp32_pulse_t*  items;
+      uint16_t              count;
+    } pulse_table_t;
+
+    uint8_t               _pin;
+    uint8_t               _channel;             // LEDC channel for setPWM(), RMT channel for queuePulses()
+    uint8_t               _mode;
+
+    // LEDC
+    uint8_t               _dutyBits;
+    float                 _pwmFrequency;        // requested PWM frequency
+    float                 _duty;
+    float                 _waveformFrequency;   // achieved PWM frequency
+    bool                  _apbCallbackAdded;
+
+    // RMT
+    uint32_t              _tickNs;
+    bool                  _rmtInstalled;
+    volatile bool         _streaming;
+    pulse_table_t         _queue[WAVEFORM_QUEUE_SIZE];
+    volatile uint8_t      _head;                // table being copied into the RMT RAM
+    volatile uint8_t      _queued;              // tables queued, being copied one included
+    uint16_t              _position;            // items of the head table already copied
+    uint16_t              _memOffset;           // half of the RMT RAM to refill next
+    bool                  _ending;              // end marker written, the stream stops there
+    volatile uint32_t     _underruns;           // streams ended as no table was queued in time
+    esp32_pulse_callback  _pulseDone;
+    portMUX_TYPE          _mux;
+
+    ///////////////////////////////////////////
+
+    // Waveform of each RMT channel, for the RMT interrupt, shared by all the channels
+    static ESP32WaveformTimer** rmtWaveforms()
+    {
+      static ESP32WaveformTimer* waveforms[RMT_CHANNEL_MAX] = { NULL };
+
+      return waveforms;
+    }
+
+    static rmt_isr_handle_t& rmtISRHandle()
+    {
+      static rmt_isr_handle_t handle = NULL;
+
+      return handle;
+    }
+
+    ///////////////////////////////////////////
+
+    // RMT interrupt: TX threshold, refill the half of the RMT RAM just sent, and TX end. Not in IRAM
+    static void rmtISR(void * arg)
+    {
+      (void) arg;
+
+      uint32_t thresholds = rmt_ll_get_tx_thres_interrupt_status(&RMT);
+      uint32_t ends       = rmt_ll_get_tx_end_interrupt_status(&RMT);
+
+      for (uint8_t channel = 0; channel < RMT_CHANNEL_MAX; channel++)
+      {
+        ESP32WaveformTimer * waveform = rmtWaveforms()[channel];
+
+        if (thresholds & (1UL << channel))
+        {
+          rmt_ll_clear_tx_thres_interrupt(&RMT, channel);
+
+          if (waveform)
+            waveform->refill();
+        }
+
+        if (ends & (1UL << channel))
+        {
+          rmt_ll_clear_tx_end_interrupt(&RMT, channel);
+
+          if (waveform)
+            waveform->streamEnded();
+        }
+      }
+    }
+
+    ///////////////////////////////////////////
+
+    // Copies up to 'wanted' items of the queued tables into the RMT RAM from 'offset', chaining the tables, then an end
+    // marker if they run out first. The tables fully copied are added to 'done'. With _mux taken
+    void fill(const uint16_t& offset, const uint16_t& wanted, const esp32_pulse_t** done, uint8_t& numDone)
+    {
+      uint16_t num = 0;
+
+      while ( (num < wanted) && (_queued > 0) )
+      {
+        const pulse_table_t& table = _queue[_head];
+
+        uint16_t count = table.count - _position;
+
+        if (count > wanted - num)
+          count = wanted - num;
+
+        rmt_ll_write_memory(&RMTMEM, _channel, table.items + _position, count, offset + num);
+
+        num       += count;
+        _position += count;
+
+        if (_position >= table.count)
+        {
+          done[numDone++] = table.items;
+
+          _head     = (_head + 1) % WAVEFORM_QUEUE_SIZE;
+          _queued--;
+          _position = 0;
+        }
+      }
+
+      if (num < wanted)
+      {
+        rmt_item32_t endMarker;
+
+        endMarker.val = 0;
+
+        rmt_ll_write_memory(&RMTMEM, _channel, &endMarker, 1, offset + num);
+
+        _ending = true;
+      }
+    }
+
+    ///////////////////////////////////////////
+
+    // Fills the whole RMT RAM for a new stream, sent from its first half. With _mux taken, then rmt_tx_start()
+    void startStream(const esp32_pulse_t** done, uint8_t& numDone)
+    {
+      _memOffset  = 0;
+      _ending     = false;
+      _streaming  = true;
+
+      fill(0, WAVEFORM_RMT_MEM_ITEMS, done, numDone);
+    }
+
+    ///////////////////////////////////////////
+
+    void tablesDone(const esp32_pulse_t** done, const uint8_t& numDone)
+    {
+      esp32_pulse_callback callback = _pulseDone;
+
+      for (uint8_t i = 0; callback && (i < numDone); i++)
+        callback(done[i]);
+    }
+
+    ///////////////////////////////////////////
+
+    // From the RMT interrupt: the RMT has sent a half of its RAM, and goes on with the other one
+    void refill()
+    {
+      const esp32_pulse_t*  done[WAVEFORM_QUEUE_SIZE];
+      uint8_t               numDone = 0;
+
+      portENTER_CRITICAL_ISR(&_mux);
+
+      if (_streaming && !_ending)
+      {
+        fill(_memOffset, WAVEFORM_RMT_MEM_ITEMS / 2, done, numDone);
+
+        _memOffset = (_memOffset == 0) ? WAVEFORM_RMT_MEM_ITEMS / 2 : 0;
+      }
+
+      portEXIT_CRITICAL_ISR(&_mux);
+
+      tablesDone(done, numDone);
+    }
+
+    ///////////////////////////////////////////
+
+    // From the RMT interrupt: end marker reached. A table queued meanwhile starts a new stream
+    void streamEnded()
+    {
+      const esp32_pulse_t*  done[WAVEFORM_QUEUE_SIZE];
+      uint8_t               numDone = 0;
+      bool                  restart;
+
+      portENTER_CRITICAL_ISR(&_mux);
+
+      // Not after stopWaveform()
+      if (_streaming)
+        _underruns++;
+
+      restart     = _streaming && (_queued > 0);
+      _streaming  = false;
+
+      if (restart)
+        startStream(done, numDone);
+
+      portEXIT_CRITICAL_ISR(&_mux);
+
+      if (restart)
+        rmt_tx_start( (rmt_channel_t) _channel, true);
+
+      tablesDone(done, numDone);
+    }
+
+    ///////////////////////////////////////////
+
+    // The LEDC and the RMT run on the APB clock, which setCpuFrequencyMhz() may change
+    static void apbChangeCallback(void * arg, apb_change_ev_t ev_type, uint32_t old_apb, uint32_t new_apb)
+    {
+      (void) old_apb;
+      (void) new_apb;
+
+      if (ev_type == APB_AFTER_CHANGE)
+        ((ESP32WaveformTimer *) arg)->clockChanged();
+    }
+
+    ///////////////////////////////////////////
+
+    void addApbCallback()
+    {
+      // To be notified of CPU / APB frequency changes, see clockChanged()
+      if (!_apbCallbackAdded)
+      {
+        _apbCallbackAdded = addApbChangeCallback(this, apbChangeCallback);
+      }
+    }
+
+    ///////////////////////////////////////////
+
+    // RMT clock divider of a tick of 'tickNs' ns, with the actual APB clock
+    static uint64_t rmtDivider(const uint32_t& tickNs)
+    {
+      return (uint64_t) getApbFrequency() * tickNs / 1000000000ULL;
+    }
+
+    ///////////////////////////////////////////
+
+    // LEDC timer of the channel for 'frequency', with the finest duty resolution the actual APB clock allows
+    bool setupLEDC(const float& frequency)
+    {
+      // Counter period = 2^bits APB cycles at most
+      uint8_t bits = (uint8_t) log2( (double) getApbFrequency() / frequency);
+
+      bits = (bits < 1) ? 1 : ( (bits > WAVEFORM_LEDC_MAX_BITS) ? WAVEFORM_LEDC_MAX_BITS : bits );
+
+      double achieved = ledcSetup(_channel, frequency, bits);
+
+      if (achieved == 0)
+      {
+        TISR_LOGERROR1(F("Error. LEDC can't make frequency ="), frequency);
+
+        return false;
+      }
+
+      _pwmFrequency       = frequency;
+      _dutyBits           = bits;
+      _waveformFrequency  = (float) achieved;
+
+      return true;
+    }
+
+    ///////////////////////////////////////////
+
+    bool installRMT()
+    {
+      if (_rmtInstalled)
+        return true;
+
+      rmt_config_t config = RMT_DEFAULT_CONFIG_TX( (gpio_num_t) _pin, (rmt_channel_t) _channel);
+
+      config.clk_div                  = (uint8_t) rmtDivider(_tickNs);
+      config.mem_block_num            = WAVEFORM_RMT_MEM_BLOCKS;
+      config.tx_config.idle_level     = RMT_IDLE_LEVEL_LOW;
+      config.tx_config.idle_output_en = true;
+
+      if (rmt_config(&config) != ESP_OK)
+      {
+        TISR_LOGERROR1(F("Error. Can't configure the RMT channel"), _channel);
+
+        return false;
+      }
+
+      // One interrupt for all the RMT channels, registered by the first waveform
+      if ( (rmtISRHandle() == NULL) && (rmt_isr_register(rmtISR, NULL, 0, &rmtISRHandle()) != ESP_OK) )
+      {
+        rmtISRHandle() = NULL;
+
+        TISR_LOGERROR(F("Error. Can't register the RMT interrupt, RMT driver installed ?"));
+
+        return false;
+      }
+
+      rmtWaveforms()[_channel] = this;
+
+      rmt_set_tx_thr_intr_en( (rmt_channel_t) _channel, true, WAVEFORM_RMT_MEM_ITEMS / 2);
+      rmt_set_tx_intr_en( (rmt_channel_t) _channel, true);
+
+      _rmtInstalled = true;
+
+      addApbCallback();
+
+      return true;
+    }
+
+  public:
+
+    ///////////////////////////////////////////
+
+    // channel: LEDC channel with setPWM() / setSquareWave(), RMT TX channel with queuePulses()
+    ESP32WaveformTimer(const uint8_t& pin, const uint8_t& channel)
+    {
+      _pin                = pin;
+      _channel            = channel;
+      _mode               = WAVEFORM_NONE;
+
+      _dutyBits           = 0;
+      _pwmFrequency       = 0;
+      _duty               = 0;
+      _waveformFrequency  = 0;
+      _apbCallbackAdded   = false;
+
+      _tickNs             = WAVEFORM_RMT_TICK_NS;
+      _rmtInstalled       = false;
+      _streaming          = false;
+      _head               = 0;
+      _queued             = 0;
+      _position           = 0;
+      _memOffset          = 0;
+      _ending             = false;
+      _underruns          = 0;
+      _pulseDone          = NULL;
+      _mux                = portMUX_INITIALIZER_UNLOCKED;
+    };
+
+    ///////////////////////////////////////////
+
+    ~ESP32WaveformTimer()
+    {
+      stopWaveform();
+
+      if (_apbCallbackAdded)
+        removeApbChangeCallback(this, apbChangeCallback);
+
+      if (_rmtInstalled)
+      {
+        rmt_set_tx_thr_intr_en( (rmt_channel_t) _channel, false, WAVEFORM_RMT_MEM_ITEMS / 2);
+        rmt_set_tx_intr_en( (rmt_channel_t) _channel, false);
+
+        rmtWaveforms()[_channel] = NULL;
+
+        // The last waveform on the RMT frees its interrupt
+        bool used = false;
+
+        for (uint8_t channel = 0; channel < RMT_CHANNEL_MAX; channel++)
+          used = used || (rmtWaveforms()[channel] != NULL);
+
+        if (!used)
+        {
+          rmt_isr_deregister(rmtISRHandle());
+          rmtISRHandle() = NULL;
+        }
+      }
+    }
+
+    ///////////////////////////////////////////
+
+    // LEDC PWM, duty in % (0.0 - 100.0), with the finest duty resolution the frequency allows
+    bool setPWM(const float& frequency, const float& duty)
+    {
+      if ( (frequency <= 0) || (frequency > getApbFrequency() / 2) || (_mode == WAVEFORM_PULSES) )
+      {
+        TISR_LOGERROR1(F("Error. setPWM: bad frequency or RMT in use, frequency ="), frequency);
+
+        return false;
+      }
+
+      if (!setupLEDC(frequency))
+        return false;
+
+      if (_mode != WAVEFORM_PWM)
+        ledcAttachPin(_pin, _channel);
+
+      _mode = WAVEFORM_PWM;
+
+      setPWMDuty(duty);
+
+      addApbCallback();
+
+      TISR_LOGWARN3(F("PWM: frequency ="), _waveformFrequency, F(", duty bits ="), _dutyBits);
+
+      return true;
+    }
+
+    ///////////////////////////////////////////
+
+    // interval (in microseconds)
+    bool setPWMInterval(const unsigned long& interval, const float& duty)
+    {
+      return setPWM( (float) ( 1000000.0f / interval), duty);
+    }
+
+    ///////////////////////////////////////////
+
+    bool setSquareWave(const float& frequency)
+    {
+      return setPWM(frequency, 50.0f);
+    }
+
+    ///////////////////////////////////////////
+
+    // New duty in % (0.0 - 100.0), from the next PWM period
+    void setPWMDuty(const float& duty)
+    {
+      if (_mode != WAVEFORM_PWM)
+        return;
+
+      uint32_t maxDuty = 1UL << _dutyBits;
+      float    level   = (duty <= 0) ? 0 : ( (duty >= 100.0f) ? 100.0f : duty );
+
+      _duty = level;
+
+      ledcWrite(_channel, (uint32_t) ( (level * maxDuty / 100.0f) + 0.5f ) );
+    }
+
+    ///////////////////////////////////////////
+
+    // RMT tick, in ns, from 13 (80 MHz APB / 1) to 3187 (/ 255). Before the first queuePulses()
+    bool setPulseResolution(const uint32_t& tickNs)
+    {
+      uint64_t divider = rmtDivider(tickNs);
+
+      if ( _rmtInstalled || (divider < 1) || (divider > 255) )
+      {
+        TISR_LOGERROR1(F("Error. setPulseResolution: RMT in use or bad tick (ns) ="), tickNs);
+
+        return false;
+      }
+
+      _tickNs = tickNs;
+
+      return true;
+    }
+
+    ///////////////////////////////////////////
+
+    // Queue 'count' pulses of 'table', sent straight after the tables already queued. 'table' must stay valid until
+    // the setPulseDone() callback. Returns false if WAVEFORM_QUEUE_SIZE tables are already queued. Not from an ISR
+    bool queuePulses(const esp32_pulse_t* table, const uint16_t& count)
+    {
+      if ( (table == NULL) || (count == 0) || (_mode == WAVEFORM_PWM) || !installRMT() )
+        return false;
+
+      const esp32_pulse_t*  done[WAVEFORM_QUEUE_SIZE];
+      uint8_t               numDone = 0;
+      bool                  start;
+
+      portENTER_CRITICAL(&_mux);
+
+      if (_queued >= WAVEFORM_QUEUE_SIZE)
+      {
+        portEXIT_CRITICAL(&_mux);
+
+        return false;
+      }
+
+      _queue[(_head + _queued) % WAVEFORM_QUEUE_SIZE] = { table, count };
+      _queued++;
+
+      _mode = WAVEFORM_PULSES;
+
+      // While streaming, the RMT interrupt takes the table after the previous one. After the end marker of a stream
+      // already written, streamEnded() starts a new one
+      start = !_streaming;
+
+      if (start)
+        startStream(done, numDone);
+
+      portEXIT_CRITICAL(&_mux);
+
+      if (start)
+        rmt_tx_start( (rmt_channel_t) _channel, true);
+
+      // A short table may be copied at once
+      tablesDone(done, numDone);
+
+      return true;
+    }
+
+    ///////////////////////////////////////////
+
+    // Called with each table copied into the RMT RAM, mostly from the RMT interrupt: short, no blocking call
+    void setPulseDone(esp32_pulse_callback callback)
+    {
+      _pulseDone = callback;
+    }
+
+    ///////////////////////////////////////////
+
+    // Tables which can be queued now
+    uint8_t getFreeBuffers() __attribute__((always_inline))
+    {
+      return WAVEFORM_QUEUE_SIZE - _queued;
+    }
+
+    ///////////////////////////////////////////
+
+    // true while the RMT sends a stream
+    bool isStreaming() __attribute__((always_inline))
+    {
+      return _streaming;
+    }
+
+    ///////////////////////////////////////////
+
+    // Streams ended as the queued tables ran out, i.e. the next table came too late
+    uint32_t getUnderruns() __attribute__((always_inline))
+    {
+      return _underruns;
+    }
+
+    ///////////////////////////////////////////
+
+    // Stops the PWM, or the pulse stream at once: the queued tables are dropped, without the setPulseDone() callback.
+    // The pin goes to the idle level, low
+    void stopWaveform()
+    {
+      if (_mode == WAVEFORM_PWM)
+      {
+        ledcWrite(_channel, 0);
+        ledcDetachPin(_pin);
+      }
+      else if (_mode == WAVEFORM_PULSES)
+      {
+        portENTER_CRITICAL(&_mux);
+
+        _queued     = 0;
+        _position   = 0;
+        _streaming  = false;
+
+        portEXIT_CRITICAL(&_mux);
+
+        rmt_tx_stop( (rmt_channel_t) _channel);
+      }
+
+      _mode = WAVEFORM_NONE;
+    }
+
+    ///////////////////////////////////////////
+
+    // Reload the LEDC timer, or the RMT divider, after a change of the APB clock, keeping the PWM frequency and duty,
+    // or the RMT tick. Called automatically by setCpuFrequencyMhz() through the APB change callback
+    // Returns false if they can't be kept with the new clock
+    bool clockChanged()
+    {
+      if (_mode == WAVEFORM_PWM)
+      {
+        if (!setupLEDC(_pwmFrequency))
+          return false;
+
+        setPWMDuty(_duty);
+      }
+
+      if (_rmtInstalled)
+      {
+        uint64_t divider = rmtDivider(_tickNs);
+
+        if ( (divider < 1) || (divider > 255) )
+        {
+          TISR_LOGERROR1(F("clockChanged: RMT tick out of range, APB clock ="), getApbFrequency());
+
+          return false;
+        }
+
+        rmt_set_clk_div( (rmt_channel_t) _channel, (uint8_t) divider);
+      }
+
+      return true;
+    }
+
+    ///////////////////////////////////////////
+
+    // PWM frequency as achieved by the LEDC
+    float getWaveformFrequency() __attribute__((always_inline))
+    {
+      return _waveformFrequency;
+    }
+
+    ///////////////////////////////////////////
+
+    uint8_t getWaveformMode() __attribute__((always_inline))
+    {
+      return _mode;
+    }
+
+    ///////////////////////////////////////////
+
+    uint32_t getPulseResolution() __attribute__((always_inline))
+    {
+      return _tickNs;
+    }
+};
+
+///////////////////////////////////////////
+
+#endif    // ESP32_WAVEFORM_GENERIC_H
@@ -159,13 +159,57 @@ class ESP8266TimerInterrupt
     float           _frequency;       // Timer frequency
     uint32_t        _timerCount;      // count to activate timer
 
+    uint32_t        _timerClock;      // clock after TIM_DIV, TIM_CLOCK_FREQ unless changed by clockChanged()
+    float           _periodErrorPPM;  // period error achieved by the last (re)configuration
+
+    ///////////////////////////////////////////
+
+    void updatePeriodError()
+    {
+      // achieved period = _timerCount / _timerClock, requested period = 1 / _frequency
+      _periodErrorPPM = (float) ( ( ( (double) _timerCount * _frequency / _timerClock ) - 1.0 ) * 1000000.0 );
+    }
+
+    ///////////////////////////////////////////
+
+    // Timer and full count to reload at the end of the period in progress during a clock change.
+    // Function-local statics, so that the header can be included by several files. Inlined in the IRAM reloadHandler()
+    static ESP8266TimerInterrupt*& reloadTimer() __attribute__((always_inline))
+    {
+      static ESP8266TimerInterrupt* _timer = NULL;
+
+      return _timer;
+    }
+
+    static volatile uint32_t& reloadCount() __attribute__((always_inline))
+    {
+      static volatile uint32_t _count = 0;
+
+      return _count;
+    }
+
+    ///////////////////////////////////////////
+
+    // Attached only after a clock change, to finish the rescaled period, then back to the full count and the callback
+    static void IRAM_ATTR reloadHandler()
+    {
+      ESP8266TimerInterrupt* timer = reloadTimer();
+
+      timer1_write(reloadCount());
+      timer1_attachInterrupt(timer->_callback);
+
+      timer->_callback();
+    }
+
   public:
 
     ESP8266TimerInterrupt()
     {
-      _frequency  = 0;
-      _timerCount = 0;
-      _callback   = NULL;
+      _frequency      = 0;
+      _timerCount     = 0;
+      _callback       = NULL;
+      _timerClock     = TIM_CLOCK_FREQ;
+      _periodErrorPPM = 0;
     };
 
     ///////////////////////////////////////////
@@ -174,7 +218,7 @@ class ESP8266TimerInterrupt
     bool setFrequency(const float& frequency, const timer_callback& callback)
     {
       bool isOKFlag = true;
-      float minFreq = (float) TIM_CLOCK_FREQ / MAX_ESP8266_COUNT;
+      float minFreq = (float) _timerClock / MAX_ESP8266_COUNT;
 
       // ESP8266 only has one usable timer1, max count is only 8,388,607. So to get longer time, we use max available 256 divider
       // Will use later if very low frequency is needed.
@@ -182,13 +226,13 @@ class ESP8266TimerInterrupt
       if (frequency < minFreq)
       {
         TISR_LOGERROR3(F("ESP8266TimerInterrupt: Too long Timer, smallest frequency ="), minFreq, F(" for TIM_CLOCK_FREQ ="),
-                       TIM_CLOCK_FREQ);
+                       _timerClock);
 
         return false;
       }
 
       _frequency  = frequency;
-      _timerCount = (uint32_t) (TIM_CLOCK_FREQ / frequency);
+      _timerCount = (uint32_t) (_timerClock / frequency);
       _callback   = callback;
 
       if ( _timerCount > MAX_ESP8266_COUNT)
@@ -198,6 +242,8 @@ class ESP8266TimerInterrupt
         isOKFlag = false;
       }
 
+      updatePeriodError();
+
       // count up
       TISR_LOGWARN3(F("ESP8266TimerInterrupt: Timer _fre ="), _frequency, F(", _count ="), _timerCount);
 
@@ -216,6 +262,66 @@ class ESP8266TimerInterrupt
 
     ///////////////////////////////////////////
 
+    // Recompute and reload the count after a change of the clock feeding Timer1, given here before TIM_DIV.
+    // The period in progress is rescaled, so the interrupts keep their phase
+    // Returns false if the timer is not running or the period can't be reached with the new clock
+    bool clockChanged(const uint32_t& newClock = TIM_DIV1_CLOCK)
+    {
+      if ( (_callback == NULL) || (_frequency <= 0) || (_timerCount == 0) )
+      {
+        return false;
+      }
+
+      uint32_t newTimerClock  = newClock / (TIM_DIV1_CLOCK / TIM_CLOCK_FREQ);
+
+      if (newTimerClock == _timerClock)
+      {
+        return true;
+      }
+
+      uint32_t newCount   = (uint32_t) ( ( (float) newTimerClock / _frequency ) + 0.5f );
+      bool     isOKFlag   = true;
+
+      if (newCount > MAX_ESP8266_COUNT)
+      {
+        newCount = MAX_ESP8266_COUNT;
+        // Flag error
+        isOKFlag = false;
+      }
+
+      noInterrupts();
+
+      // Timer1 counts down to 0 => rescale what is left of the current period
+      uint32_t remaining = (uint32_t) ( (uint64_t) timer1_read() * newCount / _timerCount );
+
+      _timerClock   = newTimerClock;
+      _timerCount   = newCount;
+      reloadTimer() = this;
+      reloadCount() = newCount;
+
+      timer1_attachInterrupt(reloadHandler);
+      timer1_write( (remaining > 0) ? remaining : 1 );
+
+      interrupts();
+
+      updatePeriodError();
+
+      TISR_LOGWARN3(F("clockChanged: Timer clock ="), _timerClock, F(", _count ="), _timerCount);
+      TISR_LOGWARN1(F("Period error (ppm) ="), _periodErrorPPM);
+
+      return isOKFlag;
+    }
+
+    ///////////////////////////////////////////
+
+    // Period error, in ppm, achieved by the last setFrequency() or clock change
+    float getPeriodErrorPPM()
+    {
+      return _periodErrorPPM;
+    }
+
+    ///////////////////////////////////////////
+
     // interval (in microseconds)
     bool setInterval(const unsigned long& interval, const timer_callback& callback)
     {
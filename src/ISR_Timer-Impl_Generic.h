@@ -51,13 +51,15 @@
 ///////////////////////////////////////////
 
 ISR_Timer::ISR_Timer()
-  : numTimers (-1)
+  : numTimers (-1), lastMillis (0), millisHigh (0), tickPeriod (0), admissionPolicy (ISR_TIMER_ADMIT_NONE), tickLoad (0), utilization (0),
+    shedBudget (0), shedMode (ISR_TIMER_SHED_STRETCH), shedNotify (NULL), shedLevel (0), tickTime (0),
+    maxTickTime (0), shedRuns (0), shedTicks (0)
 {
 }
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::init()
+void COLD_ATTR_PREFIX ISR_Timer::init()
 {
   unsigned long current_millis = millis();
 
@@ -69,6 +71,9 @@ void IRAM_ATTR_PREFIX ISR_Timer::init()
 
   numTimers = 0;
 
+  tickLoad    = 0;
+  utilization = 0;
+
 #if ( defined(ESP32) || ESP32 )
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   timerMux = portMUX_INITIALIZER_UNLOCKED;
@@ -81,6 +86,13 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
 {
   uint8_t i;
   unsigned long current_millis;
+  uint64_t      current_millis64;
+  unsigned long start_micros = 0;
+  bool          due;
+
+  // only measured when overload control is on
+  if (shedBudget != 0)
+    start_micros = micros();
 
   // get current time
   current_millis = millis();
@@ -90,6 +102,14 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
   portENTER_CRITICAL_ISR(&timerMux);
 #endif
 
+  // extend millis() to the 64-bit millis64() timebase
+  if (current_millis < lastMillis)
+    millisHigh++;
+
+  lastMillis = current_millis;
+
+  current_millis64 = ((uint64_t) millisHigh << 32) | current_millis;
+
   for (i = 0; i < MAX_NUMBER_TIMERS; i++)
   {
 
@@ -102,19 +122,45 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
       // is it time to process this timer ?
       // see http://arduino.cc/forum/index.php/topic,124048.msg932592.html#msg932592
 
-      if ((current_millis - timer[i].prev_millis) >= timer[i].delay)
+      if (timer[i].absolute)
+      {
+        due = (current_millis64 >= timer[i].deadline);
+
+        // re-arm on 'start' + k * period, skipping the missed periods
+        if (due && (timer[i].period != 0))
+        {
+          timer[i].deadline += timer[i].period;
+
+          if (timer[i].deadline <= current_millis64)
+            timer[i].deadline += (uint64_t) timer[i].period * ((current_millis64 - timer[i].deadline) / timer[i].period + 1);
+        }
+      }
+      else
       {
-        unsigned long skipTimes = (current_millis - timer[i].prev_millis) / timer[i].delay;
+        due = ((current_millis - timer[i].prev_millis) >= timer[i].delay);
+
+        if (due && (timer[i].steps != NULL))
+        {
+          // a sequence never skips a step, see runSequence()
+          timer[i].prev_millis += (unsigned long) timer[i].delay;
+        }
+        else if (due)
+        {
+          unsigned long skipTimes = (current_millis - timer[i].prev_millis) / timer[i].delay;
 
-        // update time
-        timer[i].prev_millis += timer[i].delay * skipTimes;
+          // update time, in integer arithmetic as a float can't hold a prev_millis close to the millis() wrap-around
+          timer[i].prev_millis += (unsigned long) (timer[i].delay * skipTimes);
+        }
+      }
 
-        // check if the timer callback has to be executed
-        if (timer[i].enabled)
+      if (due)
+      {
+        // check if the timer callback has to be executed. A shed run is not counted in numRuns
+        if (timer[i].enabled && !shedThisRun(i))
         {
 
-          // "run forever" timers must always be executed
-          if (timer[i].maxNumRuns == TIMER_RUN_FOREVER)
+          // "run forever" timers must always be executed, and sequences count their runs in runSequence()
+          if ( (timer[i].maxNumRuns == TIMER_RUN_FOREVER) || (timer[i].steps != NULL) )
           {
             timer[i].toBeCalled = TIMER_DEFCALL_RUNONLY;
           }
@@ -140,7 +186,9 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
     if (timer[i].toBeCalled == TIMER_DEFCALL_DONTRUN)
       continue;
 
-    if (timer[i].hasParam)
+    if (timer[i].steps != NULL)
+      runSequence(i, current_millis);
+    else if (timer[i].hasParam)
       (*(timerCallback_p)timer[i].callback)(timer[i].param);
     else
       (*(timerCallback)timer[i].callback)();
@@ -149,6 +197,9 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
       deleteTimer(i);
   }
 
+  if (shedBudget != 0)
+    updateShedding(micros() - start_micros);
+
 #if ( defined(ESP32) || ESP32 )
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portEXIT_CRITICAL_ISR(&timerMux);
@@ -157,9 +208,38 @@ void IRAM_ATTR_PREFIX ISR_Timer::run()
 
 ///////////////////////////////////////////
 
+bool COLD_ATTR_PREFIX ISR_Timer::iramSafe(const void* f, const void* data, const size_t& size)
+{
+#if ( ( defined(ESP32) || ESP32 ) && TIMER_INTERRUPT_IRAM_SAFE )
+
+  if ( (f != NULL) && !esp_ptr_in_iram(f) )
+  {
+    TISR_LOGERROR(F("Error. TIMER_INTERRUPT_IRAM_SAFE: the callback must be IRAM_ATTR"));
+
+    return false;
+  }
+
+  if ( (data != NULL) && ( !esp_ptr_in_dram(data) || !esp_ptr_in_dram( (const uint8_t *) data + size - 1) ) )
+  {
+    TISR_LOGERROR(F("Error. TIMER_INTERRUPT_IRAM_SAFE: the table must be in DRAM, not const"));
+
+    return false;
+  }
+
+#else
+  (void) f;
+  (void) data;
+  (void) size;
+#endif
+
+  return true;
+}
+
+///////////////////////////////////////////
+
 // find the first available slot
 // return -1 if none found
-int IRAM_ATTR_PREFIX ISR_Timer::findFirstFreeSlot()
+int COLD_ATTR_PREFIX ISR_Timer::findFirstFreeSlot()
 {
   // all slots are used
   if (numTimers >= MAX_NUMBER_TIMERS)
@@ -182,7 +262,108 @@ int IRAM_ATTR_PREFIX ISR_Timer::findFirstFreeSlot()
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setupTimer(const float& d, void* f, void* p, bool h, const uint32_t& n)
+void COLD_ATTR_PREFIX ISR_Timer::setTickPeriod(const uint32_t& tickPeriod, const uint8_t& policy)
+{
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  this->tickPeriod  = tickPeriod;
+  admissionPolicy   = policy;
+
+  // The utilization terms of the timers shorter than the tick depend on tickPeriod: add them again,
+  // so that removeLoad() takes away the very term added
+  tickLoad    = 0;
+  utilization = 0;
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if (timer[i].callback != NULL)
+      addLoad(i);
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  if (!isSchedulable())
+  {
+    TISR_LOGERROR3(F("ISR_Timer: unschedulable, tick load (us) ="), tickLoad, F(", tick period (us) ="), tickPeriod);
+  }
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::rearmAlarm(const uint8_t& numTimer, const uint64_t& now)
+{
+  uint32_t period = timer[numTimer].period;
+
+  // A one-shot alarm keeps its deadline: restarting it must not fire it now
+  if ( (period == 0) || (timer[numTimer].deadline > now) )
+    return;
+
+  timer[numTimer].deadline += (uint64_t) period * ((now - timer[numTimer].deadline) / period + 1);
+}
+
+///////////////////////////////////////////
+
+bool COLD_ATTR_PREFIX ISR_Timer::admitLoad(const uint32_t& wcet)
+{
+  if ( (wcet == 0) || (tickPeriod == 0) || (admissionPolicy == ISR_TIMER_ADMIT_NONE) || (tickLoad + wcet <= tickPeriod) )
+  {
+    return true;
+  }
+
+  TISR_LOGERROR3(F("ISR_Timer: unschedulable, tick load (us) ="), tickLoad + wcet, F(", tick period (us) ="), tickPeriod);
+
+  return (admissionPolicy != ISR_TIMER_ADMIT_REFUSE);
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::addLoad(const uint8_t& numTimer)
+{
+  uint32_t wcet = timer[numTimer].wcet;
+
+  // Nothing to do, and no float operation, without declared WCET
+  if (wcet == 0)
+    return;
+
+  // A timer shorter than the tick still runs at most once per tick
+  float period = max(timer[numTimer].delay * 1000.0f, (float) tickPeriod);
+
+  tickLoad += wcet;
+
+  if (period > 0)
+    utilization += wcet / period;
+}
+
+///////////////////////////////////////////
+
+void IRAM_ATTR_PREFIX ISR_Timer::removeLoad(const uint8_t& numTimer)
+{
+  uint32_t wcet = timer[numTimer].wcet;
+
+  if (wcet == 0)
+    return;
+
+  float period = max(timer[numTimer].delay * 1000.0f, (float) tickPeriod);
+
+  tickLoad -= wcet;
+
+  if (period > 0)
+    utilization -= wcet / period;
+
+  // No rounding residue once the last loaded timer is gone
+  if (tickLoad == 0)
+    utilization = 0;
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setupTimer(const float& d, void* f, void* p, bool h, const uint32_t& n,
+                                           const uint32_t& wcet)
 {
   int freeTimer;
 
@@ -198,7 +379,12 @@ int IRAM_ATTR_PREFIX ISR_Timer::setupTimer(const float& d, void* f, void* p, boo
     return -1;
   }
 
-  if (f == NULL)
+  if ( (f == NULL) || !iramSafe(f) )
+  {
+    return -1;
+  }
+
+  if (!admitLoad(wcet))
   {
     return -1;
   }
@@ -210,6 +396,9 @@ int IRAM_ATTR_PREFIX ISR_Timer::setupTimer(const float& d, void* f, void* p, boo
   timer[freeTimer].maxNumRuns  = n;
   timer[freeTimer].enabled     = true;
   timer[freeTimer].prev_millis = millis();
+  timer[freeTimer].wcet        = wcet;
+
+  addLoad(freeTimer);
 
   numTimers++;
 
@@ -218,55 +407,64 @@ int IRAM_ATTR_PREFIX ISR_Timer::setupTimer(const float& d, void* f, void* p, boo
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setTimer(const float& d, timerCallback f, const uint32_t& n)
+int COLD_ATTR_PREFIX ISR_Timer::setTimer(const float& d, timerCallback f, const uint32_t& n, const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, NULL, false, n);
+  return setupTimer(d, (void *)f, NULL, false, n, wcet);
 }
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setTimer(const float& d, timerCallback_p f, void* p, const uint32_t& n)
+int COLD_ATTR_PREFIX ISR_Timer::setTimer(const float& d, timerCallback_p f, void* p, const uint32_t& n,
+                                      const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, p, true, n);
+  return setupTimer(d, (void *)f, p, true, n, wcet);
 }
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setInterval(const float& d, timerCallback f)
+int COLD_ATTR_PREFIX ISR_Timer::setInterval(const float& d, timerCallback f, const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_FOREVER);
+  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_FOREVER, wcet);
 }
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setInterval(const float& d, timerCallback_p f, void* p)
+int COLD_ATTR_PREFIX ISR_Timer::setInterval(const float& d, timerCallback_p f, void* p, const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, p, true, TIMER_RUN_FOREVER);
+  return setupTimer(d, (void *)f, p, true, TIMER_RUN_FOREVER, wcet);
 }
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setTimeout(const float& d, timerCallback f)
+int COLD_ATTR_PREFIX ISR_Timer::setTimeout(const float& d, timerCallback f, const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_ONCE);
+  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_ONCE, wcet);
 }
 
 ///////////////////////////////////////////
 
-int IRAM_ATTR_PREFIX ISR_Timer::setTimeout(const float& d, timerCallback_p f, void* p)
+int COLD_ATTR_PREFIX ISR_Timer::setTimeout(const float& d, timerCallback_p f, void* p, const uint32_t& wcet)
 {
-  return setupTimer(d, (void *)f, p, true, TIMER_RUN_ONCE);
+  return setupTimer(d, (void *)f, p, true, TIMER_RUN_ONCE, wcet);
 }
 
 ///////////////////////////////////////////
 
-bool IRAM_ATTR_PREFIX ISR_Timer::changeInterval(const uint8_t& numTimer, const float& d)
+bool COLD_ATTR_PREFIX ISR_Timer::changeInterval(const uint8_t& numTimer, const float& d)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
     return false;
   }
 
+  // A period of 0 would make an absolute alarm due at every run()
+  if (timer[numTimer].absolute && ((uint32_t) d == 0))
+  {
+    TISR_LOGERROR(F("ISR_Timer: the period of an absolute alarm can't be 0"));
+
+    return false;
+  }
+
   // Updates interval of existing specified timer
   if (timer[numTimer].callback != NULL)
   {
@@ -275,9 +473,17 @@ bool IRAM_ATTR_PREFIX ISR_Timer::changeInterval(const uint8_t& numTimer, const f
     portENTER_CRITICAL(&timerMux);
 #endif
 
+    removeLoad(numTimer);
+
     timer[numTimer].delay = d;
     timer[numTimer].prev_millis = millis();
 
+    // an absolute alarm keeps its next deadline, and uses the new period from there
+    if (timer[numTimer].absolute)
+      timer[numTimer].period = (uint32_t) d;
+
+    addLoad(numTimer);
+
 #if ( defined(ESP32) || ESP32 )
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
     portEXIT_CRITICAL_ISR(&timerMux);
@@ -313,6 +519,8 @@ void IRAM_ATTR_PREFIX ISR_Timer::deleteTimer(const uint8_t& timerId)
     portENTER_CRITICAL(&timerMux);
 #endif
 
+    removeLoad(timerId);
+
     memset((void*) &timer[timerId], 0, sizeof (timer_t));
     timer[timerId].prev_millis = millis();
 
@@ -329,7 +537,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::deleteTimer(const uint8_t& timerId)
 ///////////////////////////////////////////
 
 // function contributed by code@rowansimms.com
-void IRAM_ATTR_PREFIX ISR_Timer::restartTimer(const uint8_t& numTimer)
+void COLD_ATTR_PREFIX ISR_Timer::restartTimer(const uint8_t& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -343,6 +551,9 @@ void IRAM_ATTR_PREFIX ISR_Timer::restartTimer(const uint8_t& numTimer)
 
   timer[numTimer].prev_millis = millis();
 
+  if (timer[numTimer].absolute)
+    rearmAlarm(numTimer, millis64());
+
 #if ( defined(ESP32) || ESP32 )
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portEXIT_CRITICAL(&timerMux);
@@ -351,7 +562,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::restartTimer(const uint8_t& numTimer)
 
 ///////////////////////////////////////////
 
-bool IRAM_ATTR_PREFIX ISR_Timer::isEnabled(const uint8_t& numTimer)
+bool COLD_ATTR_PREFIX ISR_Timer::isEnabled(const uint8_t& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -363,7 +574,7 @@ bool IRAM_ATTR_PREFIX ISR_Timer::isEnabled(const uint8_t& numTimer)
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::enable(const uint8_t& numTimer)
+void COLD_ATTR_PREFIX ISR_Timer::enable(const uint8_t& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -375,7 +586,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::enable(const uint8_t& numTimer)
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::disable(const uint8_t& numTimer)
+void COLD_ATTR_PREFIX ISR_Timer::disable(const uint8_t& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -387,7 +598,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::disable(const uint8_t& numTimer)
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::enableAll()
+void COLD_ATTR_PREFIX ISR_Timer::enableAll()
 {
   // Enable all timers with a callback assigned (used)
 
@@ -412,7 +623,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::enableAll()
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::disableAll()
+void COLD_ATTR_PREFIX ISR_Timer::disableAll()
 {
   // Disable all timers with a callback assigned (used)
 
@@ -437,7 +648,7 @@ void IRAM_ATTR_PREFIX ISR_Timer::disableAll()
 
 ///////////////////////////////////////////
 
-void IRAM_ATTR_PREFIX ISR_Timer::toggle(const uint8_t& numTimer)
+void COLD_ATTR_PREFIX ISR_Timer::toggle(const uint8_t& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -449,11 +660,765 @@ void IRAM_ATTR_PREFIX ISR_Timer::toggle(const uint8_t& numTimer)
 
 ///////////////////////////////////////////
 
-uint8_t IRAM_ATTR_PREFIX ISR_Timer::getNumTimers()
+uint8_t COLD_ATTR_PREFIX ISR_Timer::getNumTimers()
 {
   return numTimers;
 }
 
 ///////////////////////////////////////////
 
+uint32_t COLD_ATTR_PREFIX ISR_Timer::setTimers(const timer_spec_t* specs, const uint8_t& count, int* numTimer)
+{
+  uint32_t      mask = 0;
+  uint8_t       freeTimer = 0;
+  uint32_t      wcet = 0;
+  unsigned long current_millis;
+
+  if ( (specs == NULL) || (count == 0) || (count > MAX_NUMBER_TIMERS) )
+  {
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if ( (specs[i].callback == NULL) || !iramSafe(specs[i].callback) )
+    {
+      return 0;
+    }
+
+    wcet += specs[i].wcet;
+  }
+
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  if (!admitLoad(wcet))
+  {
+    return 0;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  if (numTimers + count <= MAX_NUMBER_TIMERS)
+  {
+    // Same start for the whole batch => phase-aligned timers
+    current_millis = millis();
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+      // Enough free slots checked above, so this scan always stops on a free one
+      while (timer[freeTimer].callback != NULL)
+      {
+        freeTimer++;
+      }
+
+      timer[freeTimer].delay       = specs[i].delay;
+      timer[freeTimer].callback    = specs[i].callback;
+      timer[freeTimer].param       = specs[i].param;
+      timer[freeTimer].hasParam    = specs[i].hasParam;
+      timer[freeTimer].maxNumRuns  = specs[i].numRuns;
+      timer[freeTimer].enabled     = true;
+      timer[freeTimer].prev_millis = current_millis;
+      timer[freeTimer].wcet        = specs[i].wcet;
+
+      addLoad(freeTimer);
+
+      if (numTimer != NULL)
+      {
+        numTimer[i] = freeTimer;
+      }
+
+      mask |= TIMER_MASK(freeTimer);
+      freeTimer++;
+    }
+
+    numTimers += count;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  return mask;
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::enableTimers(const uint32_t& mask)
+{
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (mask & TIMER_MASK(i)) && (timer[i].callback != NULL) )
+    {
+      timer[i].enabled = true;
+    }
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::disableTimers(const uint32_t& mask)
+{
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (mask & TIMER_MASK(i)) && (timer[i].callback != NULL) )
+    {
+      timer[i].enabled = false;
+    }
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::restartTimers(const uint32_t& mask)
+{
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  unsigned long current_millis   = millis();
+  uint64_t      current_millis64 = millis64();
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (mask & TIMER_MASK(i)) && (timer[i].callback != NULL) )
+    {
+      timer[i].prev_millis = current_millis;
+
+      if (timer[i].absolute)
+        rearmAlarm(i, current_millis64);
+    }
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::deleteTimers(const uint32_t& mask)
+{
+  // nothing to delete if no timers are in use
+  if (numTimers <= 0)
+  {
+    return;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  unsigned long current_millis = millis();
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (mask & TIMER_MASK(i)) && (timer[i].callback != NULL) )
+    {
+      removeLoad(i);
+
+      memset((void*) &timer[i], 0, sizeof (timer_t));
+      timer[i].prev_millis = current_millis;
+
+      // update number of timers
+      numTimers--;
+    }
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+}
+
+///////////////////////////////////////////
+
+uint32_t COLD_ATTR_PREFIX ISR_Timer::getTimersMask()
+{
+  uint32_t mask = 0;
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if (timer[i].callback != NULL)
+    {
+      mask |= TIMER_MASK(i);
+    }
+  }
+
+  return mask;
+}
+
+///////////////////////////////////////////
+
+// Function pointers are only meaningful for the firmware which saved them => mix the build time into the magic
+uint32_t COLD_ATTR_PREFIX ISR_Timer::stateMagic()
+{
+  const char*   build = __DATE__ " " __TIME__;
+  uint32_t      magic = ISR_TIMER_STATE_MAGIC;
+
+  while (*build)
+  {
+    magic = (magic * 31) + (uint8_t) *build++;
+  }
+
+  return magic;
+}
+
+///////////////////////////////////////////
+
+// Fletcher-16 over the timers' image
+uint16_t COLD_ATTR_PREFIX ISR_Timer::stateChecksum(const state_t& state)
+{
+  const uint8_t*  data = (const uint8_t*) state.timer;
+  uint16_t        sum1 = 0;
+  uint16_t        sum2 = 0;
+
+  for (size_t i = 0; i < sizeof(state.timer); i++)
+  {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+
+  return (sum2 << 8) | sum1;
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::saveState(state_t& state, const uint32_t& now)
+{
+  unsigned long current_millis;
+  uint64_t      current_millis64;
+  unsigned long elapsed;
+
+  memset((void*) &state, 0, sizeof(state_t));
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  current_millis   = millis();
+  current_millis64 = millis64();
+
+  for (uint8_t i = 0; (numTimers > 0) && (i < MAX_NUMBER_TIMERS); i++)
+  {
+    // a sequence, whose callback is its steps table, is not saved
+    if ( (timer[i].callback == NULL) || (timer[i].steps != NULL) )
+      continue;
+
+    elapsed = current_millis - timer[i].prev_millis;
+
+    state.timer[i].callback   = timer[i].callback;
+    state.timer[i].param      = timer[i].param;
+    state.timer[i].delay      = timer[i].delay;
+    state.timer[i].remaining  = (elapsed < timer[i].delay) ? (uint32_t) (timer[i].delay - elapsed) : 0;
+    state.timer[i].maxNumRuns = timer[i].maxNumRuns;
+    state.timer[i].numRuns    = timer[i].numRuns;
+    state.timer[i].wcet       = timer[i].wcet;
+    state.timer[i].period     = timer[i].period;
+    state.timer[i].flags      = ISR_TIMER_STATE_USED;
+
+    // an absolute alarm is saved relative to now too, and restored on the millis64() timebase of the wake-up
+    if (timer[i].absolute)
+    {
+      if (timer[i].deadline <= current_millis64)
+        state.timer[i].remaining = 0;
+      else if (timer[i].deadline - current_millis64 < 0xFFFFFFFFUL)
+        state.timer[i].remaining = (uint32_t) (timer[i].deadline - current_millis64);
+      else
+        state.timer[i].remaining = 0xFFFFFFFFUL;
+
+      state.timer[i].flags |= ISR_TIMER_STATE_ABSOLUTE;
+    }
+
+    if (timer[i].enabled)
+      state.timer[i].flags |= ISR_TIMER_STATE_ENABLED;
+
+    if (timer[i].hasParam)
+      state.timer[i].flags |= ISR_TIMER_STATE_HAS_PARAM;
+
+    if (timer[i].sheddable)
+      state.timer[i].flags |= ISR_TIMER_STATE_SHEDDABLE;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  state.savedAt   = now;
+  state.checksum  = stateChecksum(state);
+  state.magic     = stateMagic();
+}
+
+///////////////////////////////////////////
+
+bool COLD_ATTR_PREFIX ISR_Timer::restoreState(const state_t& state, const uint32_t& now)
+{
+  unsigned long current_millis;
+  uint64_t      current_millis64;
+  uint32_t      slept = now - state.savedAt;
+
+  if ( (state.magic != stateMagic()) || (state.checksum != stateChecksum(state)) )
+  {
+    return false;
+  }
+
+  init();
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  current_millis   = millis();
+  current_millis64 = millis64();
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( !(state.timer[i].flags & ISR_TIMER_STATE_USED) || (state.timer[i].callback == NULL) )
+      continue;
+
+    timer[i].callback   = state.timer[i].callback;
+    timer[i].param      = state.timer[i].param;
+    timer[i].hasParam   = (state.timer[i].flags & ISR_TIMER_STATE_HAS_PARAM);
+    timer[i].enabled    = (state.timer[i].flags & ISR_TIMER_STATE_ENABLED);
+    timer[i].sheddable  = (state.timer[i].flags & ISR_TIMER_STATE_SHEDDABLE);
+    timer[i].delay      = state.timer[i].delay;
+    timer[i].maxNumRuns = state.timer[i].maxNumRuns;
+    timer[i].numRuns    = state.timer[i].numRuns;
+    timer[i].wcet       = state.timer[i].wcet;
+
+    // Next deadline = current_millis + remaining - slept. Wraps around like millis(), and a deadline
+    // already passed during sleep makes run() fire at once and re-align on the original phase
+    timer[i].prev_millis = current_millis + state.timer[i].remaining - slept - (unsigned long) timer[i].delay;
+
+    if (state.timer[i].flags & ISR_TIMER_STATE_ABSOLUTE)
+    {
+      timer[i].absolute = true;
+      timer[i].period   = state.timer[i].period;
+
+      if (state.timer[i].remaining > slept)
+      {
+        timer[i].deadline = current_millis64 + (state.timer[i].remaining - slept);
+      }
+      else
+      {
+        // fire at once, keeping the phase of the next deadlines if possible
+        uint32_t passed = slept - state.timer[i].remaining;
+
+        if (timer[i].period != 0)
+          passed %= timer[i].period;
+
+        timer[i].deadline = (current_millis64 > passed) ? current_millis64 - passed : 0;
+      }
+    }
+
+    addLoad(i);
+
+    numTimers++;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  return true;
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::setShedding(const uint32_t& budget, const uint8_t& mode, shedCallback f)
+{
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  shedBudget  = budget;
+  shedMode    = mode;
+  shedNotify  = f;
+  shedLevel   = 0;
+  tickTime    = 0;
+  maxTickTime = 0;
+  shedRuns    = 0;
+  shedTicks   = 0;
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+}
+
+///////////////////////////////////////////
+
+void COLD_ATTR_PREFIX ISR_Timer::setSheddable(const uint8_t& numTimer, const bool& sheddable)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return;
+  }
+
+  timer[numTimer].sheddable = sheddable;
+  timer[numTimer].shedCount = 0;
+}
+
+///////////////////////////////////////////
+
+bool COLD_ATTR_PREFIX ISR_Timer::isSheddable(const uint8_t& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return false;
+  }
+
+  return timer[numTimer].sheddable;
+}
+
+///////////////////////////////////////////
+
+bool IRAM_ATTR_PREFIX ISR_Timer::shedThisRun(const uint8_t& numTimer)
+{
+  if ( (shedLevel == 0) || !timer[numTimer].sheddable )
+  {
+    return false;
+  }
+
+  // keep the first due time out of every 2^level, on the original phase
+  if ( (shedMode == ISR_TIMER_SHED_STRETCH) && ((timer[numTimer].shedCount++ & ((1U << shedLevel) - 1)) == 0) )
+  {
+    return false;
+  }
+
+  shedRuns++;
+
+  return true;
+}
+
+///////////////////////////////////////////
+
+void IRAM_ATTR_PREFIX ISR_Timer::updateShedding(const uint32_t& elapsed)
+{
+  uint8_t maxLevel = (shedMode == ISR_TIMER_SHED_SKIP) ? 1 : ISR_TIMER_SHED_MAX_LEVEL;
+
+  if (elapsed > maxTickTime)
+    maxTickTime = elapsed;
+
+  // moving average over about 8 ticks, so that a single long tick doesn't shed anything
+  if (elapsed > tickTime)
+    tickTime += (elapsed - tickTime) / 8;
+  else
+    tickTime -= (tickTime - elapsed + 7) / 8;
+
+  if (shedTicks < 0xFFFF)
+    shedTicks++;
+
+  // give each level some ticks to show its effect before the next step, and restore more slowly than shed
+  if ( (tickTime > shedBudget) && (shedLevel < maxLevel) && (shedTicks >= ISR_TIMER_SHED_HOLD_TICKS) )
+  {
+    shedLevel++;
+  }
+  else if ( (tickTime < shedBudget - shedBudget / 4) && (shedLevel > 0) && (shedTicks >= ISR_TIMER_SHED_RESTORE_TICKS) )
+  {
+    shedLevel--;
+  }
+  else
+  {
+    return;
+  }
+
+  shedTicks = 0;
+
+  if (shedNotify != NULL)
+    (*shedNotify)(shedLevel, tickTime);
+}
+
+///////////////////////////////////////////
+
+uint64_t COLD_ATTR_PREFIX ISR_Timer::millis64()
+{
+  uint32_t      high;
+  unsigned long last;
+  unsigned long current_millis;
+
+  // Lock-free read of the timebase updated by run(): retry if run() has changed it in the meantime
+  do
+  {
+    high           = millisHigh;
+    last           = lastMillis;
+    current_millis = millis();
+  } while ( (high != millisHigh) || (last != lastMillis) );
+
+  // millis() has wrapped around since the last run()
+  if (current_millis < last)
+    high++;
+
+  return ((uint64_t) high << 32) | current_millis;
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setupAlarm(const uint64_t& at, const uint32_t& period, void* f, void* p, bool h,
+                                           const uint32_t& n, const uint32_t& wcet)
+{
+  int freeTimer;
+
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  freeTimer = findFirstFreeSlot();
+
+  if (freeTimer < 0)
+  {
+    return -1;
+  }
+
+  if ( (f == NULL) || !iramSafe(f) )
+  {
+    return -1;
+  }
+
+  if (!admitLoad(wcet))
+  {
+    return -1;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  // the callback last, as it makes the timer visible to run()
+  timer[freeTimer].absolute    = true;
+  timer[freeTimer].deadline    = at;
+  timer[freeTimer].period      = period;
+  timer[freeTimer].delay       = period;
+  timer[freeTimer].param       = p;
+  timer[freeTimer].hasParam    = h;
+  timer[freeTimer].maxNumRuns  = n;
+  timer[freeTimer].enabled     = true;
+  timer[freeTimer].prev_millis = millis();
+  timer[freeTimer].wcet        = wcet;
+  timer[freeTimer].callback    = f;
+
+  addLoad(freeTimer);
+
+  numTimers++;
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  return freeTimer;
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setAlarmAt(const uint64_t& at, timerCallback f, const uint32_t& wcet)
+{
+  return setupAlarm(at, 0, (void *)f, NULL, false, TIMER_RUN_ONCE, wcet);
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setAlarmAt(const uint64_t& at, timerCallback_p f, void* p, const uint32_t& wcet)
+{
+  return setupAlarm(at, 0, (void *)f, p, true, TIMER_RUN_ONCE, wcet);
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setAlarmEvery(const uint64_t& start, const uint32_t& period, timerCallback f,
+                                              const uint32_t& wcet)
+{
+  if (period == 0)
+  {
+    return -1;
+  }
+
+  return setupAlarm(start, period, (void *)f, NULL, false, TIMER_RUN_FOREVER, wcet);
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setAlarmEvery(const uint64_t& start, const uint32_t& period, timerCallback_p f,
+                                              void* p, const uint32_t& wcet)
+{
+  if (period == 0)
+  {
+    return -1;
+  }
+
+  return setupAlarm(start, period, (void *)f, p, true, TIMER_RUN_FOREVER, wcet);
+}
+
+///////////////////////////////////////////
+
+uint64_t COLD_ATTR_PREFIX ISR_Timer::getDeadline(const uint8_t& numTimer)
+{
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (timer[numTimer].callback == NULL) )
+  {
+    return 0;
+  }
+
+  if (timer[numTimer].absolute)
+    return timer[numTimer].deadline;
+
+  // a relative timer, projected onto the millis64() timebase
+  uint64_t      current_millis64 = millis64();
+  unsigned long elapsed          = (unsigned long) current_millis64 - timer[numTimer].prev_millis;
+
+  return (elapsed < timer[numTimer].delay) ? current_millis64 + (unsigned long) (timer[numTimer].delay - elapsed) :
+         current_millis64;
+}
+
+///////////////////////////////////////////
+
+int COLD_ATTR_PREFIX ISR_Timer::setSequence(const timer_step_t* steps, const uint8_t& numSteps, const uint32_t& n,
+                                            const uint32_t& wcet)
+{
+  int freeTimer;
+
+  if ( (steps == NULL) || (numSteps == 0) || !iramSafe(NULL, steps, numSteps * sizeof(timer_step_t)) )
+  {
+    return -1;
+  }
+
+  for (uint8_t i = 0; i < numSteps; i++)
+  {
+    if (!iramSafe( (const void *) steps[i].action))
+    {
+      return -1;
+    }
+  }
+
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  freeTimer = findFirstFreeSlot();
+
+  if (freeTimer < 0)
+  {
+    return -1;
+  }
+
+  if (!admitLoad(wcet))
+  {
+    return -1;
+  }
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portENTER_CRITICAL(&timerMux);
+#endif
+
+  // the callback last, as it makes the timer visible to run(). The first step is due at once
+  timer[freeTimer].steps       = steps;
+  timer[freeTimer].numSteps    = numSteps;
+  timer[freeTimer].step        = 0;
+  timer[freeTimer].delay       = 0;
+  timer[freeTimer].param       = NULL;
+  timer[freeTimer].hasParam    = false;
+  timer[freeTimer].maxNumRuns  = n;
+  timer[freeTimer].enabled     = true;
+  timer[freeTimer].prev_millis = millis();
+  timer[freeTimer].wcet        = wcet;
+  timer[freeTimer].callback    = (void*) steps;
+
+  addLoad(freeTimer);
+
+  numTimers++;
+
+#if ( defined(ESP32) || ESP32 )
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
+  portEXIT_CRITICAL(&timerMux);
+#endif
+
+  return freeTimer;
+}
+
+///////////////////////////////////////////
+
+uint8_t COLD_ATTR_PREFIX ISR_Timer::getSequenceStep(const uint8_t& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return 0;
+  }
+
+  return timer[numTimer].step;
+}
+
+///////////////////////////////////////////
+
+void IRAM_ATTR_PREFIX ISR_Timer::runSequence(const uint8_t& numTimer, const unsigned long& current_millis)
+{
+  // at most one pass per run(), so that a sequence of zero delays can't lock run() up
+  for (uint8_t count = 0; count < timer[numTimer].numSteps; count++)
+  {
+    const timer_step_t* step = &timer[numTimer].steps[timer[numTimer].step];
+
+    if (step->action != NULL)
+      (*step->action)(step->param);
+
+    // wait for the delay of this step before the next one
+    timer[numTimer].delay = step->delay;
+
+    if (++timer[numTimer].step >= timer[numTimer].numSteps)
+    {
+      timer[numTimer].step = 0;
+
+      if ( (timer[numTimer].maxNumRuns != TIMER_RUN_FOREVER) && (++timer[numTimer].numRuns >= timer[numTimer].maxNumRuns) )
+      {
+        deleteTimer(numTimer);
+
+        return;
+      }
+    }
+
+    // Next step deadline is the previous one + delay, so a late run() catches up here without any drift
+    if ((current_millis - timer[numTimer].prev_millis) < step->delay)
+      return;
+
+    timer[numTimer].prev_millis += step->delay;
+  }
+}
+
+///////////////////////////////////////////
+
 #endif    // ISR_TIMER_IMPL_GENERIC_H
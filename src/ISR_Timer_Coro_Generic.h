@@ -0,0 +1,396 @@
+/********************************************************************************************************************************
+  ISR_Timer_Coro_Generic.h
+  For Generic boards
+  Written by Khoi Hoang
+
+  C++20 coroutine layer on top of ISR_Timer. A foreground coroutine can wait with
+
+    co_await coro.sleep_for(ms);       // resumed 'ms' milliseconds later
+    co_await coro.sleep_until(at);     // resumed at millis64() time 'at'
+    co_await coro.next_tick();         // resumed at the next tick
+
+  The waiting coroutines are kept in an intrusive list sorted by wake-up time, whose nodes live in the coroutine
+  frames, so any number of waits use only one ISR_Timer slot. That slot just counts the ticks, in ISR context,
+  and the coroutines are resumed by dispatch(), called from loop().
+  Coroutine frames come from a static pool of ISR_TIMER_CORO_FRAMES blocks of ISR_TIMER_CORO_FRAME_SIZE bytes.
+
+  Needs a compiler with C++20 coroutines, e.g. GCC 10+ with -std=gnu++20 (and -fcoroutines for GCC 10),
+  as in the RP2040, Teensy 4.x and ESP32 (core v3.0+) cores.
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Version: 1.13.0
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ISR_TIMER_CORO_GENERIC_H
+#define ISR_TIMER_CORO_GENERIC_H
+
+#if !defined(__cpp_impl_coroutine)
+  #error ISR_Timer_Coro_Generic.h needs C++20 coroutines. Please build with -std=gnu++20 (and -fcoroutines for GCC 10)
+#endif
+
+#include <coroutine>
+
+#include "ISR_Timer_Generic.h"
+
+///////////////////////////////////////////
+
+// size of a coroutine frame block. A frame larger than this fails to start, see ISR_Timer_Task
+#ifndef ISR_TIMER_CORO_FRAME_SIZE
+  #define ISR_TIMER_CORO_FRAME_SIZE     128
+#endif
+
+// number of coroutine frame blocks, i.e. max number of coroutines alive at the same time
+#ifndef ISR_TIMER_CORO_FRAMES
+  #define ISR_TIMER_CORO_FRAMES         8
+#endif
+
+///////////////////////////////////////////
+
+// Static pool of coroutine frames, used by ISR_Timer_Task instead of the heap
+class ISR_Timer_Coro_Pool
+{
+  public:
+
+    static void* alloc(const size_t& size)
+    {
+      if (size > ISR_TIMER_CORO_FRAME_SIZE)
+      {
+        TISR_LOGERROR3(F("ISR_Timer_Coro: frame size ="), size, F(" > ISR_TIMER_CORO_FRAME_SIZE ="), ISR_TIMER_CORO_FRAME_SIZE);
+
+        return NULL;
+      }
+
+      for (uint16_t i = 0; i < ISR_TIMER_CORO_FRAMES; i++)
+      {
+        if (!used[i])
+        {
+          used[i] = true;
+
+          return frame[i].data;
+        }
+      }
+
+      TISR_LOGERROR1(F("ISR_Timer_Coro: no free frame, ISR_TIMER_CORO_FRAMES ="), ISR_TIMER_CORO_FRAMES);
+
+      return NULL;
+    }
+
+    static void free(void* p)
+    {
+      for (uint16_t i = 0; i < ISR_TIMER_CORO_FRAMES; i++)
+      {
+        if (frame[i].data == p)
+        {
+          used[i] = false;
+
+          return;
+        }
+      }
+    }
+
+    // returns the number of free frames
+    static uint16_t getFreeFrames()
+    {
+      uint16_t count = 0;
+
+      for (uint16_t i = 0; i < ISR_TIMER_CORO_FRAMES; i++)
+      {
+        if (!used[i])
+          count++;
+      }
+
+      return count;
+    }
+
+  private:
+
+    typedef struct
+    {
+      alignas(max_align_t) uint8_t data[ISR_TIMER_CORO_FRAME_SIZE];
+    } frame_t;
+
+    inline static frame_t frame[ISR_TIMER_CORO_FRAMES];
+    inline static bool    used[ISR_TIMER_CORO_FRAMES];
+};
+
+///////////////////////////////////////////
+
+// Return type of a coroutine run by ISR_Timer_Coro. The coroutine starts at once, runs until its first co_await,
+// and its frame goes back to the pool when it returns. Evaluates to false if it couldn't start (no free frame)
+class ISR_Timer_Task
+{
+  public:
+
+    struct promise_type
+    {
+      ISR_Timer_Task get_return_object()
+      {
+        return ISR_Timer_Task(true);
+      }
+
+      static ISR_Timer_Task get_return_object_on_allocation_failure()
+      {
+        return ISR_Timer_Task(false);
+      }
+
+      std::suspend_never initial_suspend() noexcept
+      {
+        return {};
+      }
+
+      std::suspend_never final_suspend() noexcept
+      {
+        return {};
+      }
+
+      void return_void()
+      {
+      }
+
+      void unhandled_exception()
+      {
+      }
+
+      static void* operator new(size_t size) noexcept
+      {
+        return ISR_Timer_Coro_Pool::alloc(size);
+      }
+
+      static void operator delete(void* p) noexcept
+      {
+        ISR_Timer_Coro_Pool::free(p);
+      }
+    };
+
+    explicit operator bool() const
+    {
+      return started;
+    }
+
+  private:
+
+    explicit ISR_Timer_Task(const bool& started) : started(started)
+    {
+    }
+
+    bool started;
+};
+
+///////////////////////////////////////////
+
+class ISR_Timer_Coro
+{
+  private:
+
+    // a waiting coroutine, living in its own frame as part of the awaiter
+    struct waiter_t
+    {
+      waiter_t*               next;
+      uint64_t                wakeAt;
+      std::coroutine_handle<> handle;
+    };
+
+  public:
+
+    // awaiter of sleep_for(), sleep_until() and next_tick()
+    class Awaiter
+    {
+      public:
+
+        bool await_ready() const noexcept
+        {
+          return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+          node.handle = handle;
+          coro->wait(&node, tick);
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+      private:
+
+        friend class ISR_Timer_Coro;
+
+        Awaiter(ISR_Timer_Coro* coro, const uint64_t& wakeAt, const bool& tick) : coro(coro), tick(tick)
+        {
+          node.next   = NULL;
+          node.wakeAt = wakeAt;
+        }
+
+        ISR_Timer_Coro* coro;
+        bool            tick;
+        waiter_t        node;
+    };
+
+    ///////////////////////////////////////////
+
+    ISR_Timer_Coro(ISR_Timer& timer) : timer(timer), numTimer(-1), ticks(0), lastTicks(0), sleepList(NULL),
+      tickList(NULL), numWaiting(0)
+    {
+    }
+
+    // Take one ISR_Timer slot ticking every 'tickPeriod' ms, the resolution of sleep_for() / sleep_until()
+    // Returns false if no ISR_Timer slot is available
+    bool begin(const float& tickPeriod = 1)
+    {
+      if (numTimer < 0)
+        numTimer = timer.setInterval(tickPeriod, (timerCallback_p) tickHandler, this);
+
+      return (numTimer >= 0);
+    }
+
+    // Free the ISR_Timer slot. The waiting coroutines stay suspended until the next begin()
+    void end()
+    {
+      if (numTimer >= 0)
+        timer.deleteTimer(numTimer);
+
+      numTimer = -1;
+    }
+
+    // To be called from loop(). Resumes the coroutines waiting for next_tick(), then the ones due since the last call,
+    // in wake-up order. Returns the number of resumed coroutines
+    uint16_t dispatch()
+    {
+      uint32_t  currentTicks = ticks;
+      uint64_t  now;
+      waiter_t* dueList;
+      waiter_t* last = NULL;
+      waiter_t* tickDue;
+      uint16_t  count;
+
+      if (currentTicks == lastTicks)
+        return 0;
+
+      lastTicks = currentTicks;
+      now       = timer.millis64();
+
+      // Detach all the due waiters before resuming any, so that a coroutine waiting again is never resumed twice
+      // by the same dispatch()
+      tickDue  = tickList;
+      tickList = NULL;
+
+      dueList = sleepList;
+
+      while ( (sleepList != NULL) && (sleepList->wakeAt <= now) )
+      {
+        last      = sleepList;
+        sleepList = sleepList->next;
+      }
+
+      if (last != NULL)
+        last->next = NULL;
+      else
+        dueList = NULL;
+
+      count  = resume(tickDue);
+      count += resume(dueList);
+
+      return count;
+    }
+
+    ///////////////////////////////////////////
+
+    // co_await coro.sleep_for(ms) resumes the coroutine 'ms' milliseconds later
+    Awaiter sleep_for(const uint32_t& ms)
+    {
+      return Awaiter(this, timer.millis64() + ms, false);
+    }
+
+    // co_await coro.sleep_until(at) resumes the coroutine at millis64() time 'at'. Returns at the next tick if already passed
+    Awaiter sleep_until(const uint64_t& at)
+    {
+      return Awaiter(this, at, false);
+    }
+
+    // co_await coro.next_tick() resumes the coroutine at the next tick
+    Awaiter next_tick()
+    {
+      return Awaiter(this, 0, true);
+    }
+
+    ///////////////////////////////////////////
+
+    // returns the number of waiting coroutines
+    uint16_t getNumWaiting()
+    {
+      return numWaiting;
+    }
+
+    // returns the number of ticks not dispatched yet
+    uint32_t getPendingTicks()
+    {
+      return ticks - lastTicks;
+    }
+
+    // returns the ISR_Timer slot taken by begin(), -1 if none
+    int getTimerNumber()
+    {
+      return numTimer;
+    }
+
+  private:
+
+    static void IRAM_ATTR_PREFIX tickHandler(void* p)
+    {
+      ISR_Timer_Coro* coro = (ISR_Timer_Coro*) p;
+
+      coro->ticks = coro->ticks + 1;
+    }
+
+    // enqueue 'node', sorted by wake-up time after the nodes due at the same time, or at the end of the tick list
+    void wait(waiter_t* node, const bool& tick)
+    {
+      waiter_t** pos = tick ? &tickList : &sleepList;
+
+      while ( (*pos != NULL) && (tick || ((*pos)->wakeAt <= node->wakeAt)) )
+        pos = &(*pos)->next;
+
+      node->next = *pos;
+      *pos       = node;
+
+      numWaiting++;
+    }
+
+    // resume all the waiters of 'list'. A node is gone as soon as its coroutine is resumed
+    uint16_t resume(waiter_t* list)
+    {
+      uint16_t count = 0;
+
+      while (list != NULL)
+      {
+        std::coroutine_handle<> handle = list->handle;
+
+        list = list->next;
+        numWaiting--;
+        count++;
+
+        handle.resume();
+      }
+
+      return count;
+    }
+
+    ISR_Timer&          timer;
+    int                 numTimer;
+
+    volatile uint32_t   ticks;            // only written by tickHandler(), in ISR context
+    uint32_t            lastTicks;
+
+    waiter_t*           sleepList;
+    waiter_t*           tickList;
+    uint16_t            numWaiting;
+};
+
+///////////////////////////////////////////
+
+#endif    // ISR_TIMER_CORO_GENERIC_H
@@ -64,12 +64,36 @@
 
 ///////////////////////////////////////////
 
+// Hot path, run() and what it calls, in IRAM on ESP32 and ESP8266
 #if ( defined(ESP8266) || ESP8266 ) || ( defined(ESP32) || ESP32 )
   #define IRAM_ATTR_PREFIX      IRAM_ATTR
 #else
   #define IRAM_ATTR_PREFIX
 #endif
 
+// ESP32: true => run() is called from a timer interrupt kept running while the flash cache is disabled, see
+// ESP32TimerInterrupt_Generic.h. A callback out of IRAM, or a sequence table out of DRAM, is then refused
+#ifndef TIMER_INTERRUPT_IRAM_SAFE
+  #define TIMER_INTERRUPT_IRAM_SAFE     false
+#endif
+
+// Cold path, configuration and queries, in flash unless ISR_TIMER_CONFIG_IN_IRAM: true is only needed if callbacks
+// call them with the flash cache disabled, hence the TIMER_INTERRUPT_IRAM_SAFE default.
+// utils/iram_report.sh gives the IRAM taken by ISR_Timer in a build, to compare both
+#ifndef ISR_TIMER_CONFIG_IN_IRAM
+  #define ISR_TIMER_CONFIG_IN_IRAM      TIMER_INTERRUPT_IRAM_SAFE
+#endif
+
+#if ISR_TIMER_CONFIG_IN_IRAM
+  #define COLD_ATTR_PREFIX      IRAM_ATTR_PREFIX
+#else
+  #define COLD_ATTR_PREFIX
+#endif
+
+#if ( ( defined(ESP32) || ESP32 ) && TIMER_INTERRUPT_IRAM_SAFE )
+  #include <soc/soc_memory_layout.h>
+#endif
+
 #if !( ARDUINO_ESP32S2_DEV || ARDUINO_FEATHERS2 || ARDUINO_ESP32S2_THING_PLUS || ARDUINO_MICROS2 || \
       ARDUINO_METRO_ESP32S2 || ARDUINO_MAGTAG29_ESP32S2 || ARDUINO_FUNHOUSE_ESP32S2 || \
       ARDUINO_ADAFRUIT_FEATHER_ESP32S2_NOPSRAM || ARDUINO_ADAFRUIT_QTPY_ESP32S2)
@@ -114,78 +138,300 @@ class ISR_Timer
 #define TIMER_RUN_FOREVER         0
 #define TIMER_RUN_ONCE            1
 
+    // bit n of a timer mask selects timer number n
+#define TIMER_MASK(n)             (1UL << (n))
+#define TIMER_MASK_ALL            ((1UL << MAX_NUMBER_TIMERS) - 1)
+
+    // one entry of a batch registration, see setTimers()
+    typedef struct
+    {
+      float         delay;              // delay value
+      void*         callback;           // pointer to the callback function (timerCallback or timerCallback_p)
+      void*         param;              // function parameter
+      bool          hasParam;           // true if callback takes a parameter
+      uint32_t      numRuns;            // TIMER_RUN_FOREVER, TIMER_RUN_ONCE or number of runs
+      uint32_t      wcet;               // declared worst-case execution time of the callback (us), 0 if unknown
+    } timer_spec_t;
+
+    // one step of a sequence, see setSequence()
+    typedef struct
+    {
+      uint32_t        delay;            // ms to wait after the action, before the next step
+      timerCallback_p action;           // function called with 'param' at the start of the step, or NULL
+      void*           param;            // function parameter
+    } timer_step_t;
+
+    // what to do with a timer making the tick unschedulable, see setTickPeriod()
+#define ISR_TIMER_ADMIT_NONE        0       // no check
+#define ISR_TIMER_ADMIT_WARN        1       // accept the timer, but log an error
+#define ISR_TIMER_ADMIT_REFUSE      2       // refuse the timer
+
+    // what to do with the sheddable timers during an overload, see setShedding()
+#define ISR_TIMER_SHED_STRETCH      0       // run one due time out of 2^level, i.e. stretch the period
+#define ISR_TIMER_SHED_SKIP         1       // don't run at all until the overload is over
+
+#ifndef ISR_TIMER_SHED_MAX_LEVEL
+  #define ISR_TIMER_SHED_MAX_LEVEL      4       // up to 1 run out of 16
+#endif
+
+#ifndef ISR_TIMER_SHED_HOLD_TICKS
+  #define ISR_TIMER_SHED_HOLD_TICKS     32      // min ticks between two shed steps
+#endif
+
+#ifndef ISR_TIMER_SHED_RESTORE_TICKS
+  #define ISR_TIMER_SHED_RESTORE_TICKS  256     // min ticks between two restore steps
+#endif
+
+    // called from run(), i.e. in ISR context, when the shed level changes. 'tickTime' is the averaged tick time (us)
+    typedef void (*shedCallback)(uint8_t level, uint32_t tickTime);
+
+    // Compact image of the scheduler to keep in RTC / retention memory across deep sleep, see saveState()
+#define ISR_TIMER_STATE_MAGIC       0x49535254UL    // "ISRT"
+
+#define ISR_TIMER_STATE_USED        0x01
+#define ISR_TIMER_STATE_ENABLED     0x02
+#define ISR_TIMER_STATE_HAS_PARAM   0x04
+#define ISR_TIMER_STATE_SHEDDABLE   0x08
+#define ISR_TIMER_STATE_ABSOLUTE    0x10
+
+    typedef struct
+    {
+      void*         callback;           // pointer to the callback function
+      void*         param;              // function parameter
+      float         delay;              // delay value
+      uint32_t      remaining;          // ms left to the next deadline when saved
+      uint32_t      maxNumRuns;         // number of runs to be executed
+      uint32_t      numRuns;            // number of executed runs
+      uint32_t      wcet;               // declared worst-case execution time (us)
+      uint32_t      period;             // period of an absolute-time alarm (ms)
+      uint8_t       flags;              // ISR_TIMER_STATE_xxx bits
+    } timer_state_t;
+
+    typedef struct
+    {
+      uint32_t      magic;              // ISR_TIMER_STATE_MAGIC mixed with the firmware build
+      uint32_t      savedAt;            // persistent clock (ms) when saved
+      uint16_t      checksum;           // over timer[]
+      timer_state_t timer[MAX_NUMBER_TIMERS];
+    } state_t;
+
     // constructor
     ISR_Timer();
 
-    void IRAM_ATTR_PREFIX init();
+    void COLD_ATTR_PREFIX init();
 
     // this function must be called inside loop()
     void IRAM_ATTR_PREFIX run();
 
+    // The optional 'wcet' is the worst-case execution time of the callback, in microseconds, used by the
+    // schedulability check (see setTickPeriod()). A timer refused by the check also returns -1
+
     // Timer will call function 'f' every 'd' milliseconds forever
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setInterval(const float& d, timerCallback f);
+    int COLD_ATTR_PREFIX setInterval(const float& d, timerCallback f, const uint32_t& wcet = 0);
 
     // Timer will call function 'f' with parameter 'p' every 'd' milliseconds forever
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setInterval(const float& d, timerCallback_p f, void* p);
+    int COLD_ATTR_PREFIX setInterval(const float& d, timerCallback_p f, void* p, const uint32_t& wcet = 0);
 
     // Timer will call function 'f' after 'd' milliseconds one time
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setTimeout(const float& d, timerCallback f);
+    int COLD_ATTR_PREFIX setTimeout(const float& d, timerCallback f, const uint32_t& wcet = 0);
 
     // Timer will call function 'f' with parameter 'p' after 'd' milliseconds one time
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setTimeout(const float& d, timerCallback_p f, void* p);
+    int COLD_ATTR_PREFIX setTimeout(const float& d, timerCallback_p f, void* p, const uint32_t& wcet = 0);
 
     // Timer will call function 'f' every 'd' milliseconds 'n' times
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setTimer(const float& d, timerCallback f, const uint32_t& n);
+    int COLD_ATTR_PREFIX setTimer(const float& d, timerCallback f, const uint32_t& n, const uint32_t& wcet = 0);
 
     // Timer will call function 'f' with parameter 'p' every 'd' milliseconds 'n' times
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setTimer(const float& d, timerCallback_p f, void* p, const uint32_t& n);
+    int COLD_ATTR_PREFIX setTimer(const float& d, timerCallback_p f, void* p, const uint32_t& n,
+                                  const uint32_t& wcet = 0);
 
-    // updates interval of the specified timer
-    bool IRAM_ATTR_PREFIX changeInterval(const uint8_t& numTimer, const float& d);
+    // updates interval of the specified timer. The period of an absolute-time alarm can't be changed to 0
+    bool COLD_ATTR_PREFIX changeInterval(const uint8_t& numTimer, const float& d);
 
     // destroy the specified timer
     void IRAM_ATTR_PREFIX deleteTimer(const uint8_t& numTimer);
 
-    // restart the specified timer
-    void IRAM_ATTR_PREFIX restartTimer(const uint8_t& numTimer);
+    // restart the specified timer. An absolute-time alarm keeps its deadlines, a periodic one skipping those passed
+    void COLD_ATTR_PREFIX restartTimer(const uint8_t& numTimer);
 
     // returns true if the specified timer is enabled
-    bool IRAM_ATTR_PREFIX isEnabled(const uint8_t& numTimer);
+    bool COLD_ATTR_PREFIX isEnabled(const uint8_t& numTimer);
 
     // enables the specified timer
-    void IRAM_ATTR_PREFIX enable(const uint8_t& numTimer);
+    void COLD_ATTR_PREFIX enable(const uint8_t& numTimer);
 
     // disables the specified timer
-    void IRAM_ATTR_PREFIX disable(const uint8_t& numTimer);
+    void COLD_ATTR_PREFIX disable(const uint8_t& numTimer);
 
     // enables all timers
-    void IRAM_ATTR_PREFIX enableAll();
+    void COLD_ATTR_PREFIX enableAll();
 
     // disables all timers
-    void IRAM_ATTR_PREFIX disableAll();
+    void COLD_ATTR_PREFIX disableAll();
 
     // enables the specified timer if it's currently disabled, and vice-versa
-    void IRAM_ATTR_PREFIX toggle(const uint8_t& numTimer);
+    void COLD_ATTR_PREFIX toggle(const uint8_t& numTimer);
 
     // returns the number of used timers
-    uint8_t IRAM_ATTR_PREFIX getNumTimers();
+    uint8_t COLD_ATTR_PREFIX getNumTimers();
+
+    ///////////////////////////////////////////
+
+    // Timer will run the sequence of the 'numSteps' steps of 'steps' 'n' times (TIMER_RUN_FOREVER for ever): at each
+    // step, call steps[i].action(steps[i].param), then wait steps[i].delay ms, from a single timer. The first step runs
+    // at the next run(). Every step deadline is the previous deadline + delay, so there's no cumulative drift, and a late
+    // run() catches up. The timer is deleted after the last action of the last pass.
+    // 'steps' is not copied, and must stay valid (static or global table). A sequence is not saved by saveState()
+    // returns the timer number (numTimer) on success or -1 on failure (steps == NULL, numSteps == 0) or no free timers
+    int COLD_ATTR_PREFIX setSequence(const timer_step_t* steps, const uint8_t& numSteps,
+                                     const uint32_t& n = TIMER_RUN_ONCE, const uint32_t& wcet = 0);
+
+    // returns the index of the next step of the specified sequence
+    uint8_t COLD_ATTR_PREFIX getSequenceStep(const uint8_t& numTimer);
+
+    ///////////////////////////////////////////
+
+    // Absolute-time alarms, on the 64-bit millis64() timebase, which never wraps around.
+    // The deadlines of a periodic alarm are always 'start' + k * 'period', so no registration or ISR latency
+    // is accumulated, and periods missed (disabled timer, late run(), etc.) are skipped.
+    // An alarm already in the past fires at the next run(). Return the timer number or -1, as setTimer()
+
+    // returns the current time (ms) on a 64-bit timebase. run() must be called at least every 49 days
+    uint64_t COLD_ATTR_PREFIX millis64();
+
+    // Timer will call function 'f' once, at millis64() time 'at'
+    int COLD_ATTR_PREFIX setAlarmAt(const uint64_t& at, timerCallback f, const uint32_t& wcet = 0);
+
+    // Timer will call function 'f' with parameter 'p' once, at millis64() time 'at'
+    int COLD_ATTR_PREFIX setAlarmAt(const uint64_t& at, timerCallback_p f, void* p, const uint32_t& wcet = 0);
+
+    // Timer will call function 'f' at millis64() time 'start', then every 'period' milliseconds forever
+    int COLD_ATTR_PREFIX setAlarmEvery(const uint64_t& start, const uint32_t& period, timerCallback f,
+                                       const uint32_t& wcet = 0);
+
+    // Timer will call function 'f' with parameter 'p' at millis64() time 'start', then every 'period' milliseconds forever
+    int COLD_ATTR_PREFIX setAlarmEvery(const uint64_t& start, const uint32_t& period, timerCallback_p f, void* p,
+                                       const uint32_t& wcet = 0);
+
+    // returns the next deadline of the specified timer on the millis64() timebase, 0 if not used
+    uint64_t COLD_ATTR_PREFIX getDeadline(const uint8_t& numTimer);
+
+    ///////////////////////////////////////////
+
+    // Register 'count' timers described by 'specs' in one go, with a single millis() read and a single
+    // critical section, so that all timers of the batch start phase-aligned.
+    // All or nothing: returns the mask of the allocated timers, or 0 on failure (any callback == NULL
+    // or not enough free timers). If 'numTimer' is not NULL, numTimer[i] receives the timer number of specs[i]
+    uint32_t COLD_ATTR_PREFIX setTimers(const timer_spec_t* specs, const uint8_t& count, int* numTimer = NULL);
+
+    // enables the timers selected by 'mask'
+    void COLD_ATTR_PREFIX enableTimers(const uint32_t& mask);
+
+    // disables the timers selected by 'mask'
+    void COLD_ATTR_PREFIX disableTimers(const uint32_t& mask);
+
+    // restarts the timers selected by 'mask', all from the same millis(), absolute-time alarms as restartTimer()
+    void COLD_ATTR_PREFIX restartTimers(const uint32_t& mask);
+
+    // destroys the timers selected by 'mask'
+    void COLD_ATTR_PREFIX deleteTimers(const uint32_t& mask);
+
+    // returns the mask of the used timers
+    uint32_t COLD_ATTR_PREFIX getTimersMask();
+
+    ///////////////////////////////////////////
+
+    // Declare the period (us) at which run() is called, i.e. the hardware timer interval, and the policy
+    // (ISR_TIMER_ADMIT_NONE, ISR_TIMER_ADMIT_WARN or ISR_TIMER_ADMIT_REFUSE) for a timer whose declared WCET
+    // makes the worst-aligned tick, where all the timers fall due together, longer than this period
+    void COLD_ATTR_PREFIX setTickPeriod(const uint32_t& tickPeriod, const uint8_t& policy = ISR_TIMER_ADMIT_WARN);
+
+    // returns the sum of the declared WCETs (us), i.e. the load of a tick where all the timers fall due
+    uint32_t COLD_ATTR_PREFIX getTickLoad()
+    {
+      return tickLoad;
+    };
+
+    // returns the CPU utilisation of the declared WCETs (0.0 - 1.0), each timer running at most once per tick
+    float COLD_ATTR_PREFIX getUtilization()
+    {
+      return utilization;
+    };
+
+    // returns true if the worst-aligned tick fits in the tick period
+    bool COLD_ATTR_PREFIX isSchedulable()
+    {
+      return (tickPeriod == 0) || (tickLoad <= tickPeriod);
+    };
+
+    ///////////////////////////////////////////
+
+    // Overload control. With a non-zero 'budget' (us), run() measures its own execution time. When the averaged
+    // tick time stays over budget, the timers marked by setSheddable() are shed one level more (mode
+    // ISR_TIMER_SHED_STRETCH: period x 2, up to ISR_TIMER_SHED_MAX_LEVEL; mode ISR_TIMER_SHED_SKIP: not run at all),
+    // and restored one level at a time once it stays under 3/4 of the budget. The other timers are never touched.
+    // 'f', if not NULL, is called on every level change. budget = 0 (default) disables the measurement
+    void COLD_ATTR_PREFIX setShedding(const uint32_t& budget, const uint8_t& mode = ISR_TIMER_SHED_STRETCH,
+                                      shedCallback f = NULL);
+
+    // marks the specified timer as sheddable (or not) during an overload
+    void COLD_ATTR_PREFIX setSheddable(const uint8_t& numTimer, const bool& sheddable = true);
+
+    // returns true if the specified timer is sheddable
+    bool COLD_ATTR_PREFIX isSheddable(const uint8_t& numTimer);
+
+    // returns the current shed level, 0 if not shedding
+    uint8_t COLD_ATTR_PREFIX getShedLevel()
+    {
+      return shedLevel;
+    };
+
+    // returns the averaged execution time of run() (us)
+    uint32_t COLD_ATTR_PREFIX getTickTime()
+    {
+      return tickTime;
+    };
+
+    // returns the longest execution time of run() (us) since setShedding()
+    uint32_t COLD_ATTR_PREFIX getMaxTickTime()
+    {
+      return maxTickTime;
+    };
+
+    // returns the number of callback runs shed since setShedding()
+    uint32_t COLD_ATTR_PREFIX getShedRuns()
+    {
+      return shedRuns;
+    };
+
+    ///////////////////////////////////////////
+
+    // Save the schedule into 'state', normally placed in RTC / retention memory (RTC_DATA_ATTR, etc.) before deep sleep.
+    // 'now' is a persistent clock in ms that keeps running during sleep (RTC time, etc.)
+    void COLD_ATTR_PREFIX saveState(state_t& state, const uint32_t& now);
+
+    // Restore the schedule saved by saveState(), keeping every timer number and schedule phase.
+    // 'now' must come from the same persistent clock. Deadlines passed during sleep fire at the next run().
+    // Returns false, leaving the timers untouched, if 'state' is not valid (cold boot, other firmware build)
+    // Callbacks and params are restored as saved, so they must still be valid after wake-up
+    bool COLD_ATTR_PREFIX restoreState(const state_t& state, const uint32_t& now);
 
     ///////////////////////////////////////////
 
     // returns the number of available timers
-    uint8_t IRAM_ATTR_PREFIX getNumAvailableTimers()
+    uint8_t COLD_ATTR_PREFIX getNumAvailableTimers()
     {
       return MAX_NUMBER_TIMERS - numTimers;
     };
@@ -202,10 +448,41 @@ class ISR_Timer
     // low level function to initialize and enable a new timer
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int IRAM_ATTR_PREFIX setupTimer(const float& d, void* f, void* p, bool h, const uint32_t& n);
+    int COLD_ATTR_PREFIX setupTimer(const float& d, void* f, void* p, bool h, const uint32_t& n,
+                                    const uint32_t& wcet = 0);
+
+    // low level function to initialize and enable a new absolute-time alarm, see setAlarmEvery()
+    int COLD_ATTR_PREFIX setupAlarm(const uint64_t& at, const uint32_t& period, void* f, void* p, bool h,
+                                    const uint32_t& n, const uint32_t& wcet);
+
+    // moves a periodic absolute-time alarm to its first deadline after 'now', on its 'start' + k * period grid
+    void COLD_ATTR_PREFIX rearmAlarm(const uint8_t& numTimer, const uint64_t& now);
+
+    // schedulability check of 'wcet' more us per tick, according to admissionPolicy
+    bool COLD_ATTR_PREFIX admitLoad(const uint32_t& wcet);
+
+    // add / remove the load of timer 'numTimer' to / from tickLoad and utilization
+    void COLD_ATTR_PREFIX addLoad(const uint8_t& numTimer);
+    void IRAM_ATTR_PREFIX removeLoad(const uint8_t& numTimer);
 
     // find the first available slot
-    int IRAM_ATTR_PREFIX findFirstFreeSlot();
+    int COLD_ATTR_PREFIX findFirstFreeSlot();
+
+    // false if TIMER_INTERRUPT_IRAM_SAFE and callback 'f' is not in IRAM, or the 'size' bytes of 'data' not in DRAM
+    bool COLD_ATTR_PREFIX iramSafe(const void* f, const void* data = NULL, const size_t& size = 0);
+
+    // run the due steps of sequence 'numTimer'
+    void IRAM_ATTR_PREFIX runSequence(const uint8_t& numTimer, const unsigned long& current_millis);
+
+    // returns true if this due run of timer 'numTimer' is to be shed
+    bool IRAM_ATTR_PREFIX shedThisRun(const uint8_t& numTimer);
+
+    // update tickTime and shedLevel with the execution time 'elapsed' (us) of the last run()
+    void IRAM_ATTR_PREFIX updateShedding(const uint32_t& elapsed);
+
+    // magic and checksum of a saved state
+    uint32_t COLD_ATTR_PREFIX stateMagic();
+    uint16_t COLD_ATTR_PREFIX stateChecksum(const state_t& state);
 
     ///////////////////////////////////////////
 
@@ -220,6 +497,15 @@ class ISR_Timer
       uint32_t      numRuns;            // number of executed runs
       bool          enabled;            // true if enabled
       unsigned      toBeCalled;         // deferred function call (sort of) - N.B.: only used in run()
+      uint32_t      wcet;               // declared worst-case execution time (us)
+      bool          sheddable;          // true if it can be stretched / skipped during an overload
+      uint8_t       shedCount;          // due runs counted while shedding
+      bool          absolute;           // true for an alarm on the millis64() timebase
+      uint32_t      period;             // period (ms) of an absolute alarm, 0 if run once
+      uint64_t      deadline;           // next millis64() deadline of an absolute alarm
+      const timer_step_t* steps;        // steps of a sequence, NULL for any other timer
+      uint8_t       numSteps;           // number of steps of a sequence
+      uint8_t       step;               // next step of a sequence
     } timer_t;
 
     ///////////////////////////////////////////
@@ -228,6 +514,26 @@ class ISR_Timer
 
     // actual number of timers in use (-1 means uninitialized)
     volatile int numTimers;
+
+    // millis64() timebase: millis() at the last run() and number of millis() wrap-arounds, only updated by run()
+    volatile unsigned long lastMillis;
+    volatile uint32_t      millisHigh;
+
+    // schedulability figures, see setTickPeriod()
+    uint32_t        tickPeriod;
+    uint8_t         admissionPolicy;
+    uint32_t        tickLoad;
+    float           utilization;
+
+    // overload control, see setShedding()
+    uint32_t        shedBudget;
+    uint8_t         shedMode;
+    shedCallback    shedNotify;
+    volatile uint8_t  shedLevel;
+    volatile uint32_t tickTime;
+    volatile uint32_t maxTickTime;
+    volatile uint32_t shedRuns;
+    uint16_t        shedTicks;          // ticks since the last level change
 };
 
 #if ( defined(ESP32) || ESP32 )
@@ -85,6 +85,25 @@ class STM32TimerInterrupt
     float           _frequency;       // Timer frequency
     uint32_t        _timerCount;      // count to activate timer
 
+    float           _periodErrorPPM;  // period error achieved by the last (re)configuration
+
+    // All the timer objects, to be notified of clock changes
+    STM32TimerInterrupt*  _next;
+
+    static STM32TimerInterrupt*& timerList()
+    {
+      static STM32TimerInterrupt* _head = NULL;
+
+      return _head;
+    }
+
+    void updatePeriodError()
+    {
+      // achieved period = overflow ticks * prescaler / timer clock, requested period = 1 / _frequency
+      _periodErrorPPM = (float) ( ( ( (double) _hwTimer->getOverflow(TICK_FORMAT) * _hwTimer->getPrescaleFactor() *
+                                      _frequency / _hwTimer->getTimerClkFreq() ) - 1.0 ) * 1000000.0 );
+    }
+
   public:
 
     STM32TimerInterrupt(TIM_TypeDef* timer)
@@ -93,11 +112,26 @@ class STM32TimerInterrupt
 
       _hwTimer = new HardwareTimer(_timer);
 
-      _callback = NULL;
+      _callback       = NULL;
+      _frequency      = 0;
+      _timerCount     = 0;
+      _periodErrorPPM = 0;
+
+      _next         = timerList();
+      timerList()   = this;
     };
 
     ~STM32TimerInterrupt()
     {
+      for (STM32TimerInterrupt** pTimer = &timerList(); *pTimer != NULL; pTimer = &(*pTimer)->_next)
+      {
+        if (*pTimer == this)
+        {
+          *pTimer = _next;
+          break;
+        }
+      }
+
       if (_hwTimer)
         delete _hwTimer;
     }
@@ -122,12 +156,62 @@ class STM32TimerInterrupt
       _hwTimer->setCount(0, MICROSEC_FORMAT);
       _hwTimer->setOverflow(_timerCount, MICROSEC_FORMAT);
 
+      _callback = callback;
+
       _hwTimer->attachInterrupt(callback);
       _hwTimer->resume();
 
+      updatePeriodError();
+
       return true;
     }
 
+    // To call after a change of the system / bus clocks (SystemClock_Config(), etc.)
+    // Prescaler and overflow are recomputed from the new timer clock, keeping the position in the current period
+    // Returns false if the timer is not running
+    bool clockChanged()
+    {
+      if ( (_callback == NULL) || (_timerCount == 0) )
+      {
+        return false;
+      }
+
+      // Counter and overflow, in ticks, are still those of the old clock
+      uint32_t oldOverflow  = _hwTimer->getOverflow(TICK_FORMAT);
+      uint32_t oldCount     = _hwTimer->getCount(TICK_FORMAT);
+
+      // MICROSEC_FORMAT makes HardwareTimer read the timer clock again
+      _hwTimer->setOverflow(_timerCount, MICROSEC_FORMAT);
+
+      // PSC is buffered until the next update event: load it now, so that the count below is in new prescaler units.
+      // HardwareTimer sets URS, so this update event doesn't call the callback
+      _hwTimer->refresh();
+
+      _hwTimer->setCount( (uint32_t) ( (uint64_t) oldCount * _hwTimer->getOverflow(TICK_FORMAT) / oldOverflow ), TICK_FORMAT);
+
+      updatePeriodError();
+
+      TISR_LOGWARN3(F("clockChanged: Timer Input Freq (Hz) ="), _hwTimer->getTimerClkFreq(), F(", period error (ppm) ="),
+                    _periodErrorPPM);
+
+      return true;
+    }
+
+    // Notify all the timer objects of a clock change
+    static void notifyClockChange()
+    {
+      for (STM32TimerInterrupt* pTimer = timerList(); pTimer != NULL; pTimer = pTimer->_next)
+      {
+        pTimer->clockChanged();
+      }
+    }
+
+    // Period error, in ppm, achieved by the last setFrequency() or clock change
+    float getPeriodErrorPPM()
+    {
+      return _periodErrorPPM;
+    }
+
     // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
     // No params and duration now. To be addes in the future by adding similar functions here or to STM32-hal-timer.c
     bool setInterval(unsigned long interval, timerCallback callback)
@@ -220,8 +220,54 @@ TCB_t* TimerTCB[ NUM_HW_TIMERS ] = { &TCB0, &TCB1, &TCB2 };
 
 #define CLK_TCB_FREQ          ( F_CPU / CLOCK_PRESCALER )
 
+// TCB clock selected by setFrequency() for each timer: the fastest of CLK_PER, CLK_PER / 2 and CLK_TCA
+// taking the period in one CCMP (16 bits), else CLK_TCA with several CCMP chunks.
+// USING_16MHZ, USING_8MHZ or USING_250KHZ true => all the TCBs use that clock, as before
+#define TCB_CLOCK_AUTO        0xFF
+
+// Capture modes of beginCapture(). The TCB counts the edges of a pin routed through EVSYS, in hardware
+#define TCB_CAPTURE_TIMESTAMP       TCB_CNTMODE_CAPT_gc     // CCMP = CNT at each edge, counter runs free
+#define TCB_CAPTURE_FREQUENCY       TCB_CNTMODE_FRQ_gc      // CCMP = period, between two edges
+#define TCB_CAPTURE_PULSE_WIDTH     TCB_CNTMODE_PW_gc       // CCMP = pulse width, from an edge to the opposite one
+#define TCB_CAPTURE_FREQ_PW         TCB_CNTMODE_FRQPW_gc    // CCMP = pulse width, CNT = period
+
+// Event channels able to take the pins of a port: channels 0-1 => PORTA / PORTB, 2-3 => PORTC / PORTD, 4-5 => PORTE / PORTF
+#define TCB_CAPTURE_CHANNELS        6
+
+#if (USING_16MHZ || USING_8MHZ || USING_250KHZ)
+  #define TCB_CLOCK_DEFAULT     TCB_CLKSEL_VALUE
+#else
+  #define TCB_CLOCK_DEFAULT     TCB_CLOCK_AUTO
+#endif
+
+// returns the frequency of CLK_TCA, the clock of TCA0 after its prescaler, as set by the core (CLK_PER / 64) or TimerTCA
+inline uint32_t getTCAClockFrequency()
+{
+  static const uint16_t TCAPrescaler[] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+  return F_CPU / TCAPrescaler[ (TCA0.SINGLE.CTRLA & TCA_SINGLE_CLKSEL_gm) >> TCA_SINGLE_CLKSEL_gp ];
+}
+
+// returns the frequency of the TCB clock 'clockSelect'
+inline uint32_t getTCBClockFrequency(const uint8_t& clockSelect)
+{
+  if (clockSelect == TCB_CLKSEL_CLKDIV1_gc)
+    return F_CPU;
+  else if (clockSelect == TCB_CLKSEL_CLKDIV2_gc)
+    return F_CPU / 2;
+  else
+    return getTCAClockFrequency();
+}
+
 ///////////////////////////////////////////
 
+// An ISR runs with the LVL0EX flag of CPUINT set, blocking the other level 0 interrupts even after sei(), until reti.
+// Calling this returns with reti, clearing LVL0EX and setting the I-flag
+static void __attribute__((naked, noinline, unused)) TimerInterrupt_clearLevel0Ex()
+{
+  asm volatile ("reti");
+}
+
 class TimerInterrupt
 {
   private:
@@ -237,6 +283,18 @@ class TimerInterrupt
     void*           _callback;        // pointer to the callback function
     void*           _params;          // function parameter
 
+    uint8_t         _clockSource;     // TCB_CLKSEL_xxx_gc or TCB_CLOCK_AUTO
+    uint8_t         _clockSelect;     // TCB_CLKSEL_xxx_gc in use
+
+    bool              _captureMode;     // TCB in one of the TCB_CAPTURE_xxx modes, see beginCapture()
+    uint8_t           _captureChannel;  // EVSYS channel of the capture pin
+    volatile bool     _captureNew;
+    volatile uint16_t _captureValue;    // CCMP of the last capture
+    volatile uint16_t _capturePeriod;   // CNT of the last capture, the period in TCB_CAPTURE_FREQ_PW mode
+
+    bool            _nestedCallback;    // callback run with the interrupts enabled, see setNestedCallback()
+    volatile bool   _inNestedCallback;
+    volatile bool   _nestedDetached;    // detachInterrupt() called by the nested callback
 
     ///////////////////////////////////////////
 
@@ -251,7 +309,8 @@ class TimerInterrupt
       _CCMPValueToUse = min(MAX_COUNT_16BIT, _CCMPValueRemaining);
       _CCMPValueRemaining -= _CCMPValueToUse;
 
-      TimerTCB[_timer]->CCMP     = _CCMPValueToUse;    // Value to compare with.
+      // Periodic Interrupt mode: a period is CCMP + 1 ticks
+      TimerTCB[_timer]->CCMP     = _CCMPValueToUse - 1;    // Value to compare with.
 
       TimerTCB[_timer]->INTCTRL = TCB_CAPT_bm; // Enable the interrupt
 
@@ -271,6 +330,47 @@ class TimerInterrupt
 
     ///////////////////////////////////////////
 
+    // The fastest TCB clock taking the period in one CCMP, else the slowest one
+    uint8_t selectClock(const float& frequency)
+    {
+      if (_clockSource != TCB_CLOCK_AUTO)
+        return _clockSource;
+
+      if ( (F_CPU / frequency) <= MAX_COUNT_16BIT )
+        return TCB_CLKSEL_CLKDIV1_gc;
+
+      uint32_t TCAFreq = getTCAClockFrequency();
+
+      // CLK_TCA is faster than CLK_PER / 2 only if TCA0 is not prescaled
+      if ( ( ( (F_CPU / 2) / frequency) <= MAX_COUNT_16BIT ) &&
+           ( ( (F_CPU / 2) >= TCAFreq ) || ( (TCAFreq / frequency) > MAX_COUNT_16BIT ) ) )
+        return TCB_CLKSEL_CLKDIV2_gc;
+
+      return TCB_CLKSEL_CLKTCA_gc;
+    }
+
+    ///////////////////////////////////////////
+
+    // Read CNT first: in TCB_CAPTURE_FREQ_PW mode, reading CCMP clears the CAPT flag and starts the next measurement
+    void latchCapture() __attribute__((always_inline))
+    {
+      _capturePeriod  = TimerTCB[_timer]->CNT;
+      _captureValue   = TimerTCB[_timer]->CCMP;
+      _captureNew     = true;
+    }
+
+    ///////////////////////////////////////////
+
+    void callUser() __attribute__((always_inline))
+    {
+      if (_params != NULL)
+        (*(timer_callback_p)_callback)(_params);
+      else
+        (*(timer_callback)_callback)();
+    }
+
+    ///////////////////////////////////////////
+
   public:
 
     TimerInterrupt()
@@ -283,6 +383,16 @@ class TimerInterrupt
       _CCMPValue           = 0;
       _CCMPValueRemaining  = 0;
       _toggle_count       = -1;
+      _clockSource        = TCB_CLOCK_DEFAULT;
+      _clockSelect        = TCB_CLKSEL_VALUE;
+      _captureMode        = false;
+      _captureChannel     = 0;
+      _captureNew         = false;
+      _captureValue       = 0;
+      _capturePeriod      = 0;
+      _nestedCallback     = false;
+      _inNestedCallback   = false;
+      _nestedDetached     = false;
     };
 
     ///////////////////////////////////////////
@@ -297,6 +407,16 @@ class TimerInterrupt
       _CCMPValue           = 0;
       _CCMPValueRemaining  = 0;
       _toggle_count       = -1;
+      _clockSource        = TCB_CLOCK_DEFAULT;
+      _clockSelect        = TCB_CLKSEL_VALUE;
+      _captureMode        = false;
+      _captureChannel     = 0;
+      _captureNew         = false;
+      _captureValue       = 0;
+      _capturePeriod      = 0;
+      _nestedCallback     = false;
+      _inNestedCallback   = false;
+      _nestedDetached     = false;
     };
 
     ///////////////////////////////////////////
@@ -305,15 +425,237 @@ class TimerInterrupt
     {
       if (_callback != NULL)
       {
-        if (_params != NULL)
-          (*(timer_callback_p)_callback)(_params);
+        if (_nestedCallback)
+        {
+          // Re-entered, after the callback unmasked its own interrupt, e.g. with reattachInterrupt() => skip
+          if (_inNestedCallback)
+            return;
+
+          _inNestedCallback = true;
+          _nestedDetached   = false;
+
+          // The CAPT flag is already cleared by the ISR.
+          // Mask only the interrupt of this TCB, then let the other ones preempt the callback
+          TimerTCB[_timer]->INTCTRL &= ~TCB_CAPT_bm;
+          TimerInterrupt_clearLevel0Ex();
+
+          callUser();
+
+          noInterrupts();
+
+          // A compare during the callback is still pending, and runs the ISR again at once
+          if (!_nestedDetached)
+            TimerTCB[_timer]->INTCTRL |= TCB_CAPT_bm;
+
+          _inNestedCallback = false;
+        }
         else
-          (*(timer_callback)_callback)();
+          callUser();
       }
     }
 
     ///////////////////////////////////////////
 
+    // true => the callback runs with the interrupts enabled, and only the interrupt of this TCB masked.
+    // millis(), Serial and the other timers are no longer blocked by a long callback.
+    // The callback must be reentrant with respect to the other ISRs, and take less than one interrupt interval: the
+    // period, or one chunk, MAX_COUNT_16BIT ticks of getClockFrequency(), when the period takes several CCMP.
+    // Only one compare stays pending while it runs, so a longer callback loses chunk compares, and the period silently
+    // gets longer
+    void setNestedCallback(const bool& nestedCallback)
+    {
+      _nestedCallback = nestedCallback;
+    }
+
+    bool isNestedCallback()
+    {
+      return _nestedCallback;
+    }
+
+    ///////////////////////////////////////////
+
+    // TCB clock of the next setFrequency(): TCB_CLKSEL_CLKDIV1_gc, TCB_CLKSEL_CLKDIV2_gc, TCB_CLKSEL_CLKTCA_gc,
+    // or TCB_CLOCK_AUTO to select it from the frequency
+    void setClockSource(const uint8_t& clockSource = TCB_CLOCK_AUTO)
+    {
+      _clockSource = clockSource;
+    }
+
+    uint8_t getClockSource()
+    {
+      return _clockSource;
+    }
+
+    // returns the TCB clock in use, TCB_CLKSEL_xxx_gc
+    uint8_t getClockSelect()
+    {
+      return _clockSelect;
+    }
+
+    // returns the frequency (Hz) of the TCB clock in use
+    uint32_t getClockFrequency()
+    {
+      return getTCBClockFrequency(_clockSelect);
+    }
+
+    ///////////////////////////////////////////
+
+    // Input capture of 'pin', routed to the TCB by an EVSYS channel: mode TCB_CAPTURE_xxx.
+    // The TCB clock is the one of setClockSource(), CLK_TCA by default. The measured time must be less than
+    // 65536 ticks of the TCB clock (262ms with the 250kHz CLK_TCA), the TCB having no overflow flag.
+    // callback != NULL => called by the ISR at each capture, once per measurement, to read with readCapture().
+    // callback == NULL => no interrupt, poll with captureAvailable() / readCapture().
+    // fallingEdge: the edge starting the measurement. Returns false if no EVSYS channel is free for the port of 'pin'
+    bool beginCapture(const uint8_t& pin, const uint8_t& mode, timer_callback_p callback, const uint32_t& params,
+                      const bool& fallingEdge = false, const bool& noiseFilter = false)
+    {
+      uint8_t port = digitalPinToPort(pin);
+
+      if ( (_timer < 0) || (port == NOT_A_PIN) )
+      {
+        TISR_LOGERROR1(F("beginCapture: bad pin ="), pin);
+
+        return false;
+      }
+
+      if (_captureMode)
+        endCapture();
+
+      // The first free EVSYS channel of the pair taking the port of 'pin'
+      uint8_t channel = (port / 2) * 2;
+
+      if ( (channel < TCB_CAPTURE_CHANNELS) && ((&EVSYS.CHANNEL0)[channel] != 0) )
+        channel++;
+
+      if ( (channel >= TCB_CAPTURE_CHANNELS) || ((&EVSYS.CHANNEL0)[channel] != 0) )
+      {
+        TISR_LOGERROR1(F("beginCapture: no free event channel for pin ="), pin);
+
+        return false;
+      }
+
+      pinMode(pin, INPUT);
+
+      noInterrupts();
+
+      _callback       = (void*) callback;
+      _params         = reinterpret_cast<void*>(params);
+      _captureChannel = channel;
+      _captureNew     = false;
+      _captureMode    = true;
+      _clockSelect    = (_clockSource == TCB_CLOCK_AUTO) ? TCB_CLKSEL_CLKTCA_gc : _clockSource;
+
+      // Generator: pin 0-7 of the first (0x40) or the second (0x48) port of the channel
+      (&EVSYS.CHANNEL0)[channel]  = 0x40 + ( (port & 0x01) << 3 ) + digitalPinToBitPosition(pin);
+
+      // USERTCB0-3 follow each other. User = channel + 1
+      (&EVSYS.USERTCB0)[_timer]   = channel + 1;
+
+      TCB_t* tcb = TimerTCB[_timer];
+
+      tcb->CTRLA    = 0;
+      tcb->CTRLB    = mode;
+      tcb->EVCTRL   = TCB_CAPTEI_bm | (fallingEdge ? TCB_EDGE_bm : 0) | (noiseFilter ? TCB_FILTER_bm : 0);
+      tcb->CNT      = 0;
+      tcb->INTFLAGS = TCB_CAPT_bm;
+      tcb->INTCTRL  = (callback != NULL) ? TCB_CAPT_bm : 0;
+      tcb->CTRLA    = _clockSelect | TCB_ENABLE_bm;
+
+      interrupts();
+
+      TISR_LOGWARN3(F("TCB"), _timer, F(" capture, event channel ="), channel);
+
+      return true;
+    }
+
+    bool beginCapture(const uint8_t& pin, const uint8_t& mode, timer_callback callback = NULL,
+                      const bool& fallingEdge = false, const bool& noiseFilter = false)
+    {
+      return beginCapture(pin, mode, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0, fallingEdge, noiseFilter);
+    }
+
+    ///////////////////////////////////////////
+
+    // Stop the capture, and free its EVSYS channel. setFrequency() can then be used again
+    void endCapture()
+    {
+      if (!_captureMode)
+        return;
+
+      noInterrupts();
+
+      TCB_t* tcb = TimerTCB[_timer];
+
+      tcb->CTRLA    &= ~TCB_ENABLE_bm;
+      tcb->INTCTRL  = 0;
+      tcb->EVCTRL   = 0;
+      tcb->CTRLB    = TCB_CNTMODE_INT_gc;
+      tcb->INTFLAGS = TCB_CAPT_bm;
+
+      (&EVSYS.USERTCB0)[_timer]           = 0;
+      (&EVSYS.CHANNEL0)[_captureChannel]  = 0;
+
+      _captureMode  = false;
+      _callback     = NULL;
+
+      interrupts();
+    }
+
+    ///////////////////////////////////////////
+
+    bool isCapture() __attribute__((always_inline))
+    {
+      return _captureMode;
+    }
+
+    // true => a new capture is ready for readCapture()
+    bool captureAvailable()
+    {
+      if (TimerTCB[_timer]->INTCTRL & TCB_CAPT_bm)
+        return _captureNew;
+
+      return (TimerTCB[_timer]->INTFLAGS & TCB_CAPT_bm);
+    }
+
+    // returns the CCMP of the last capture, in ticks of getClockFrequency(): the timestamp, period or pulse width
+    // of the capture mode
+    uint16_t readCapture()
+    {
+      uint16_t value;
+
+      noInterrupts();
+
+      // Polling => read the TCB, which clears the CAPT flag
+      if ( !(TimerTCB[_timer]->INTCTRL & TCB_CAPT_bm) && (TimerTCB[_timer]->INTFLAGS & TCB_CAPT_bm) )
+        latchCapture();
+
+      value       = _captureValue;
+      _captureNew = false;
+
+      interrupts();
+
+      return value;
+    }
+
+    // returns the period (ticks) of the last readCapture() in TCB_CAPTURE_FREQ_PW mode
+    uint16_t getCapturePeriod()
+    {
+      return _capturePeriod;
+    }
+
+    ///////////////////////////////////////////
+
+    // To be called from ISR(TCBn_INT_vect) only
+    void handleCapture() __attribute__((always_inline))
+    {
+      latchCapture();
+
+      if (_callback != NULL)
+        callUser();
+    }
+
+    ///////////////////////////////////////////
+
     void init(const int8_t& timer)
     {
       // Set timer specific stuff
@@ -327,7 +669,7 @@ class TimerInterrupt
       TimerTCB[timer]->CTRLB    = TCB_CNTMODE_INT_gc;                         // Use timer compare mode
       TimerTCB[timer]->CCMP     = MAX_COUNT_16BIT;                            // Value to compare with.
       TimerTCB[timer]->INTCTRL  &= ~TCB_CAPT_bm;                              // Disable the interrupt
-      TimerTCB[timer]->CTRLA    = TCB_CLKSEL_VALUE | TCB_ENABLE_bm;       // Use Timer A as clock, enable timer
+      TimerTCB[timer]->CTRLA    = _clockSelect | TCB_ENABLE_bm;           // Use the clock of the last setFrequency(), enable timer
 
       TISR_LOGWARN1(F("TCB"), timer);
 
@@ -393,7 +735,28 @@ class TimerInterrupt
           _toggle_count = -1;
         }
 
+        // Back to the periodic interrupt mode
+        if (_captureMode)
+          endCapture();
+
         //Timer0-3 are 16 bit timers, meaning it can store a maximum counter value of 65535.
+        uint8_t   clockSelect = selectClock(frequency);
+        float     clockFreq   = getTCBClockFrequency(clockSelect);
+
+        if ( (clockFreq / frequency) > 4294967295.0f )
+        {
+          TISR_LOGDEBUG(F("setFrequency: period too long for the TCB clock"));
+
+          return false;
+        }
+
+        // CCMP = ticks - 1, and at least 2 ticks (F_CPU / 2) per interrupt
+        if ( (clockFreq / frequency + 0.5f) < 2.0f )
+        {
+          TISR_LOGDEBUG(F("setFrequency: period too short for the TCB clock"));
+
+          return false;
+        }
 
         noInterrupts();
 
@@ -403,9 +766,15 @@ class TimerInterrupt
 
         _timerDone = false;
 
-        _CCMPValue = _CCMPValueRemaining = (uint32_t) (CLK_TCB_FREQ / frequency);
+        _CCMPValue = _CCMPValueRemaining = (uint32_t) (clockFreq / frequency + 0.5f);
 
-        TISR_LOGINFO3(F("Frequency ="), frequency, F(", CLK_TCB_FREQ ="), CLK_TCB_FREQ);
+        // Restart the count, enabling the TCB again after endCapture() or detachInterrupt()
+        _clockSelect = clockSelect;
+
+        TimerTCB[_timer]->CTRLA = _clockSelect | TCB_ENABLE_bm;
+        TimerTCB[_timer]->CNT   = 0;
+
+        TISR_LOGINFO3(F("Frequency ="), frequency, F(", TCB clock ="), clockFreq);
         TISR_LOGINFO1(F("setFrequency: _CCMPValueRemaining = "), _CCMPValueRemaining);
 
         // Set the CCMP for the given timer,
@@ -491,6 +860,10 @@ class TimerInterrupt
     {
       noInterrupts();
 
+      // Called by a nested callback => don't unmask at its end
+      if (_inNestedCallback)
+        _nestedDetached = true;
+
       // Clear interrupt flag
       TimerTCB[_timer]->INTFLAGS = TCB_CAPT_bm;
       TimerTCB[_timer]->INTCTRL  &= ~TCB_CAPT_bm;    // Disable the interrupt
@@ -663,6 +1036,244 @@ class TimerInterrupt
 
 //////////////////////////////////////////////
 
+// TCA0 as a 16-bit timer with three compare channels, each with its own period and callback.
+// TCA0 runs free in normal mode, and each compare interrupt moves its CMPn forward by the period, so the channels
+// never drift. A period longer than 65535 ticks takes several compares.
+// begin() takes TCA0 from the core: analogWrite() on the TCA0 pins no longer works. The TCA0 prescaler is kept by
+// default, as the core clocks millis() from CLK_TCA through a TCB, as do the TCBs with TCB_CLKSEL_CLKTCA_gc
+
+#define TCA_NUM_CHANNELS          3
+
+// begin() keeps the TCA0 prescaler set by the core
+#define TCA_CLOCK_KEEP            0xFF
+
+// Min period (ticks) of a channel, so that the next compare is always ahead of the counter when the ISR ends
+#ifndef TIMER_TCA_MIN_TICKS
+  #define TIMER_TCA_MIN_TICKS     64
+#endif
+
+class TimerTCA
+{
+  private:
+
+    typedef struct
+    {
+      void*     callback;         // pointer to the callback function, NULL => channel off
+      void*     params;           // function parameter
+      uint32_t  period;           // ticks
+      uint32_t  remaining;        // ticks until the end of the period, after the current compare
+    } channel_t;
+
+    channel_t   _channel[TCA_NUM_CHANNELS];
+
+    ///////////////////////////////////////////
+
+    static register16_t& CMP(const uint8_t& channel) __attribute__((always_inline))
+    {
+      // CMP0, CMP1 and CMP2 follow each other
+      return (&TCA0.SINGLE.CMP0)[channel];
+    }
+
+    // Load the next compare of 'channel', at most 65535 ticks ahead. Run with noInterrupt()
+    void nextCompare(const uint8_t& channel, const uint16_t from) __attribute__((always_inline))
+    {
+      uint32_t remaining = _channel[channel].remaining;
+      uint16_t step;
+
+      if (remaining <= MAX_COUNT_16BIT)
+        step = remaining;
+      else if ( (remaining - MAX_COUNT_16BIT) < TIMER_TCA_MIN_TICKS )
+        step = remaining / 2;           // Keep the last chunk long enough
+      else
+        step = MAX_COUNT_16BIT;
+
+      CMP(channel) = from + step;
+      _channel[channel].remaining -= step;
+    }
+
+    ///////////////////////////////////////////
+
+  public:
+
+    TimerTCA()
+    {
+      for (uint8_t i = 0; i < TCA_NUM_CHANNELS; i++)
+      {
+        _channel[i].callback  = NULL;
+        _channel[i].params    = NULL;
+        _channel[i].period    = 0;
+        _channel[i].remaining = 0;
+      }
+    };
+
+    ///////////////////////////////////////////
+
+    // clockSelect: TCA_SINGLE_CLKSEL_DIVxxx_gc, or TCA_CLOCK_KEEP to keep the prescaler set by the core
+    void begin(const uint8_t& clockSelect = TCA_CLOCK_KEEP)
+    {
+      uint8_t clock = (clockSelect == TCA_CLOCK_KEEP) ? (TCA0.SINGLE.CTRLA & TCA_SINGLE_CLKSEL_gm) : clockSelect;
+
+      noInterrupts();
+
+      // The core runs TCA0 in split mode, for 6 PWM outputs. The timer must be stopped before the reset command
+      TCA0.SINGLE.CTRLA = 0;
+
+      if (TCA0.SPLIT.CTRLD & TCA_SPLIT_SPLITM_bm)
+        TCA0.SPLIT.CTRLESET = TCA_SPLIT_CMD_RESET_gc;
+      else
+        TCA0.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESET_gc;
+
+      TCA0.SINGLE.CTRLD     = 0;                            // Single mode
+      TCA0.SINGLE.CTRLB     = TCA_SINGLE_WGMODE_NORMAL_gc;  // Normal mode, no compare output
+      TCA0.SINGLE.PER       = MAX_COUNT_16BIT;              // Counter runs free, 0 - 65535
+      TCA0.SINGLE.INTCTRL   = 0;
+      TCA0.SINGLE.INTFLAGS  = TCA_SINGLE_CMP0_bm | TCA_SINGLE_CMP1_bm | TCA_SINGLE_CMP2_bm | TCA_SINGLE_OVF_bm;
+      TCA0.SINGLE.CTRLA     = clock | TCA_SINGLE_ENABLE_bm;
+
+      TISR_LOGWARN1(F("TCA0, CTRLA ="), TCA0.SINGLE.CTRLA);
+
+      interrupts();
+    }
+
+    ///////////////////////////////////////////
+
+    // Stop TCA0. The core PWM is not restored
+    void end()
+    {
+      noInterrupts();
+
+      TCA0.SINGLE.INTCTRL = 0;
+      TCA0.SINGLE.CTRLA   &= ~TCA_SINGLE_ENABLE_bm;
+
+      for (uint8_t i = 0; i < TCA_NUM_CHANNELS; i++)
+        _channel[i].callback = NULL;
+
+      interrupts();
+    }
+
+    ///////////////////////////////////////////
+
+    // returns the frequency (Hz) of the TCA0 clock
+    uint32_t getClockFrequency()
+    {
+      return getTCAClockFrequency();
+    }
+
+    ///////////////////////////////////////////
+
+    // channel 0-2, frequency (in hertz)
+    // Return false if the period is less than TIMER_TCA_MIN_TICKS ticks of the TCA0 clock
+    bool setFrequency(const uint8_t& channel, const float& frequency, timer_callback_p callback, const uint32_t& params)
+    {
+      if ( (channel >= TCA_NUM_CHANNELS) || (callback == NULL) || (frequency <= 0) )
+      {
+        TISR_LOGERROR(F("TCA setFrequency error"));
+
+        return false;
+      }
+
+      float ticks = (float) getTCAClockFrequency() / frequency;
+
+      if ( (ticks < TIMER_TCA_MIN_TICKS) || (ticks > 4294967295.0f) )
+      {
+        TISR_LOGERROR1(F("TCA setFrequency: out of range, ticks ="), ticks);
+
+        return false;
+      }
+
+      noInterrupts();
+
+      _channel[channel].callback  = (void*) callback;
+      _channel[channel].params    = reinterpret_cast<void*>(params);
+      _channel[channel].period    = (uint32_t) (ticks + 0.5f);
+      _channel[channel].remaining = _channel[channel].period;
+
+      nextCompare(channel, TCA0.SINGLE.CNT);
+
+      TCA0.SINGLE.INTFLAGS = TCA_SINGLE_CMP0_bm << channel;
+      TCA0.SINGLE.INTCTRL |= TCA_SINGLE_CMP0_bm << channel;
+
+      interrupts();
+
+      TISR_LOGWARN3(F("TCA channel ="), channel, F(", period ticks ="), _channel[channel].period);
+
+      return true;
+    }
+
+    bool setFrequency(const uint8_t& channel, const float& frequency, timer_callback callback)
+    {
+      return setFrequency(channel, frequency, reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0);
+    }
+
+    ///////////////////////////////////////////
+
+    // channel 0-2, interval (in ms)
+    bool setInterval(const uint8_t& channel, const unsigned long& interval, timer_callback_p callback,
+                     const uint32_t& params)
+    {
+      return setFrequency(channel, (float) (1000.0f / interval), callback, params);
+    }
+
+    bool setInterval(const uint8_t& channel, const unsigned long& interval, timer_callback callback)
+    {
+      return setFrequency(channel, (float) (1000.0f / interval), reinterpret_cast<timer_callback_p>(callback), /*NULL*/ 0);
+    }
+
+    ///////////////////////////////////////////
+
+    void detachInterrupt(const uint8_t& channel)
+    {
+      if (channel >= TCA_NUM_CHANNELS)
+        return;
+
+      noInterrupts();
+
+      TCA0.SINGLE.INTCTRL &= ~(TCA_SINGLE_CMP0_bm << channel);
+      _channel[channel].callback = NULL;
+
+      interrupts();
+    }
+
+    ///////////////////////////////////////////
+
+    // returns the period (ticks of the TCA0 clock) of a channel
+    uint32_t getPeriod(const uint8_t& channel)
+    {
+      return (channel < TCA_NUM_CHANNELS) ? _channel[channel].period : 0;
+    }
+
+    ///////////////////////////////////////////
+
+    // To be called from ISR(TCA0_CMPn_vect) only
+    void handleCompare(const uint8_t& channel) __attribute__((always_inline))
+    {
+      channel_t& ch = _channel[channel];
+
+      TCA0.SINGLE.INTFLAGS = TCA_SINGLE_CMP0_bm << channel;
+
+      if (ch.callback == NULL)
+        return;
+
+      // End of the period => next period, from this compare
+      bool done = (ch.remaining == 0);
+
+      if (done)
+        ch.remaining = ch.period;
+
+      nextCompare(channel, CMP(channel));
+
+      if (done)
+      {
+        if (ch.params != NULL)
+          (*(timer_callback_p) ch.callback)(ch.params);
+        else
+          (*(timer_callback) ch.callback)();
+      }
+    }
+}; // class TimerTCA
+
+//////////////////////////////////////////////
+
 // To be sure not used Timers are disabled
 
 // TCB0
@@ -685,6 +1296,11 @@ class TimerInterrupt
   #define USE_TIMER_3     false
 #endif
 
+// TCA0, see TimerTCA
+#if !defined(USE_TIMER_TCA)
+  #define USE_TIMER_TCA   false
+#endif
+
 
 //////////////////////////////////////////////
 
@@ -696,6 +1312,16 @@ TimerInterrupt ITimer0(HW_TIMER_0);
 
 ISR(TCB0_INT_vect)
 {
+  if (ITimer0.isCapture())
+  {
+    ITimer0.handleCapture();
+
+    return;
+  }
+
+  // Clear interrupt flag first, so that a compare during the callback stays pending
+  TCB0.INTFLAGS = TCB_CAPT_bm;
+
   long countLocal = ITimer0.getCount();
 
   if (ITimer0.getTimer() == 0)
@@ -706,9 +1332,8 @@ ISR(TCB0_INT_vect)
       {
         TISR_LOGDEBUG3(("T0 callback, _CCMPValueRemaining ="), ITimer0.get_CCMPValueRemaining(), (", millis ="), millis());
 
-        ITimer0.callback();
-
         // To reload _CCMPValueRemaining as well as _CCMP register to MAX_COUNT_16BIT
+        // Before the callback, so that a long callback does not delay the reload
         if (ITimer0.get_CCMPValue() > MAX_COUNT_16BIT)
         {
           // To reload _CCMPValueRemaining as well as _CCMP register to MAX_COUNT_16BIT
@@ -717,6 +1342,8 @@ ISR(TCB0_INT_vect)
 
         if (countLocal > 0)
           ITimer0.setCount(countLocal - 1);
+
+        ITimer0.callback();
       }
       else
       {
@@ -733,9 +1360,6 @@ ISR(TCB0_INT_vect)
       ITimer0.detachInterrupt();
     }
   }
-
-  // Clear interrupt flag
-  TCB0.INTFLAGS = TCB_CAPT_bm;
 }
 #endif  //#ifndef TIMER0_INSTANTIATED
 #endif    //#if USE_TIMER_0
@@ -753,6 +1377,16 @@ TimerInterrupt ITimer1(HW_TIMER_1);
 
 ISR(TCB1_INT_vect)
 {
+  if (ITimer1.isCapture())
+  {
+    ITimer1.handleCapture();
+
+    return;
+  }
+
+  // Clear interrupt flag first, so that a compare during the callback stays pending
+  TCB1.INTFLAGS = TCB_CAPT_bm;
+
   long countLocal = ITimer1.getCount();
 
   if (ITimer1.getTimer() == 1)
@@ -763,9 +1397,8 @@ ISR(TCB1_INT_vect)
       {
         TISR_LOGDEBUG3(("T1 callback, _CCMPValueRemaining ="), ITimer1.get_CCMPValueRemaining(), (", millis ="), millis());
 
-        ITimer1.callback();
-
         // To reload _CCMPValueRemaining as well as _CCMP register to MAX_COUNT_16BIT if _CCMPValueRemaining > MAX_COUNT_16BIT
+        // Before the callback, so that a long callback does not delay the reload
         if (ITimer1.get_CCMPValue() > MAX_COUNT_16BIT)
         {
           ITimer1.reload_CCMPValue();
@@ -773,6 +1406,8 @@ ISR(TCB1_INT_vect)
 
         if (countLocal > 0)
           ITimer1.setCount(countLocal - 1);
+
+        ITimer1.callback();
       }
       else
       {
@@ -789,9 +1424,6 @@ ISR(TCB1_INT_vect)
       ITimer1.detachInterrupt();
     }
   }
-
-  // Clear interrupt flag
-  TCB1.INTFLAGS = TCB_CAPT_bm;
 }
 
 #endif  //#ifndef TIMER1_INSTANTIATED
@@ -806,6 +1438,16 @@ TimerInterrupt ITimer2(HW_TIMER_2);
 
 ISR(TCB2_INT_vect)
 {
+  if (ITimer2.isCapture())
+  {
+    ITimer2.handleCapture();
+
+    return;
+  }
+
+  // Clear interrupt flag first, so that a compare during the callback stays pending
+  TCB2.INTFLAGS = TCB_CAPT_bm;
+
   long countLocal = ITimer2.getCount();
 
   if (ITimer2.getTimer() == 2)
@@ -816,9 +1458,8 @@ ISR(TCB2_INT_vect)
       {
         TISR_LOGDEBUG3(("T2 callback, _CCMPValueRemaining ="), ITimer2.get_CCMPValueRemaining(), (", millis ="), millis());
 
-        ITimer2.callback();
-
         // To reload _CCMPValueRemaining as well as _CCMP register to MAX_COUNT_16BIT if _CCMPValueRemaining > MAX_COUNT_16BIT
+        // Before the callback, so that a long callback does not delay the reload
         if (ITimer2.get_CCMPValue() > MAX_COUNT_16BIT)
         {
           ITimer2.reload_CCMPValue();
@@ -827,6 +1468,7 @@ ISR(TCB2_INT_vect)
         if (countLocal > 0)
           ITimer2.setCount(countLocal - 1);
 
+        ITimer2.callback();
       }
       else
       {
@@ -842,9 +1484,6 @@ ISR(TCB2_INT_vect)
       ITimer2.detachInterrupt();
     }
   }
-
-  // Clear interrupt flag
-  TCB2.INTFLAGS = TCB_CAPT_bm;
 }
 #endif  //#ifndef TIMER2_INSTANTIATED
 #endif    //#if USE_TIMER_2
@@ -860,6 +1499,16 @@ TimerInterrupt ITimer3(HW_TIMER_3);
 
 ISR(TCB3_INT_vect)
 {
+  if (ITimer3.isCapture())
+  {
+    ITimer3.handleCapture();
+
+    return;
+  }
+
+  // Clear interrupt flag first, so that a compare during the callback stays pending
+  TCB3.INTFLAGS = TCB_CAPT_bm;
+
   long countLocal = ITimer3.getCount();
 
   if (ITimer3.getTimer() == 3)
@@ -870,9 +1519,8 @@ ISR(TCB3_INT_vect)
       {
         TISR_LOGDEBUG3(("T3 callback, _CCMPValueRemaining ="), ITimer3.get_CCMPValueRemaining(), (", millis ="), millis());
 
-        ITimer3.callback();
-
         // To reload _CCMPValueRemaining as well as _CCMP register to MAX_COUNT_16BIT if _CCMPValueRemaining > MAX_COUNT_16BIT
+        // Before the callback, so that a long callback does not delay the reload
         if (ITimer3.get_CCMPValue() > MAX_COUNT_16BIT)
         {
           ITimer3.reload_CCMPValue();
@@ -880,6 +1528,8 @@ ISR(TCB3_INT_vect)
 
         if (countLocal > 0)
           ITimer3.setCount(countLocal - 1);
+
+        ITimer3.callback();
       }
       else
       {
@@ -896,12 +1546,34 @@ ISR(TCB3_INT_vect)
       ITimer3.detachInterrupt();
     }
   }
-
-  // Clear interrupt flag
-  TCB3.INTFLAGS = TCB_CAPT_bm;
 }
 
 #endif  //#ifndef TIMER3_INSTANTIATED
 #endif    //#if USE_TIMER_3
 
+///////////////////////////////////////////
+
+#if USE_TIMER_TCA
+#ifndef TIMER_TCA_INSTANTIATED
+#define TIMER_TCA_INSTANTIATED
+TimerTCA ITimerTCA;
+
+ISR(TCA0_CMP0_vect)
+{
+  ITimerTCA.handleCompare(0);
+}
+
+ISR(TCA0_CMP1_vect)
+{
+  ITimerTCA.handleCompare(1);
+}
+
+ISR(TCA0_CMP2_vect)
+{
+  ITimerTCA.handleCompare(2);
+}
+
+#endif  //#ifndef TIMER_TCA_INSTANTIATED
+#endif    //#if USE_TIMER_TCA
+
 #endif      //#ifndef MEGA_AVR_TIMERINTERRUPT_H
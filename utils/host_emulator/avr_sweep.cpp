@@ -0,0 +1,228 @@
+/****************************************************************************************************************************
+  avr_sweep.cpp
+  Frequency sweep of AVRTimerInterrupt_Generic.h (Mega2560 Timer1-5) on the host-side emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  For each timer and requested frequency: the plan of setFrequency() (prescaler, ticks, interrupts per period, error),
+  then the callbacks counted on the emulated registers: achieved frequency, error, interrupts per period, and the host
+  time taken by setFrequency(). A period differing from the plan, or interrupts per period differing from
+  getInterruptsPerPeriod(), or an error over --max-ppm, is a FAIL, and the exit code is 1.
+
+  Usage: avr_sweep [--timer n]... [--freq f]... [--periods n] [--isr-cycles n] [--async] [--max-ppm x] [--trace] [--serial]
+*****************************************************************************************************************************/
+
+#include <chrono>
+
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#define USE_TIMER_1     true
+#define USE_TIMER_2     true
+#define USE_TIMER_3     true
+#define USE_TIMER_4     true
+#define USE_TIMER_5     true
+
+#include "TimerInterrupt_Generic.h"
+
+#include "emu.h"
+
+///////////////////////////////////////////
+
+#define SWEEP_MAX_ITEMS           32
+#define SWEEP_SETFREQ_RUNS        200
+#define SWEEP_MAX_SECONDS         1000.0
+
+static TimerInterrupt* const sweepTimers[] = { NULL, &ITimer1, &ITimer2, &ITimer3, &ITimer4, &ITimer5 };
+
+static const float defaultFrequencies[] =
+{ 0.01f, 0.1f, 0.5f, 1.0f, 3.3f, 10.0f, 60.0f, 100.0f, 333.3f, 1000.0f, 4000.0f, 10000.0f, 33333.0f, 100000.0f };
+
+static const char*  isrName;
+static uint32_t     callbacks;
+static uint64_t     firstCycle, lastCycle;
+static uint32_t     firstISRs, lastISRs;
+
+static void sweepCallback()
+{
+  if (callbacks == 0)
+  {
+    firstCycle  = emu_cycle;
+    firstISRs   = emu_isrCount(isrName);
+  }
+
+  lastCycle = emu_cycle;
+  lastISRs  = emu_isrCount(isrName);
+
+  callbacks++;
+
+  if (emu_trace)
+    printf("%12llu   callback %u\n", (unsigned long long) emu_cycle, callbacks);
+}
+
+///////////////////////////////////////////
+
+// Returns true if OK
+static bool sweep(const uint8_t& timerNo, const float& frequency, const uint32_t& periods, const bool& async,
+                  const double& maxPPM)
+{
+  static char       name[16];
+  TimerInterrupt&   timer = *sweepTimers[timerNo];
+
+  snprintf(name, sizeof(name), "TIMER%u_COMPA", timerNo);
+  isrName = name;
+
+  // Host time of setFrequency()
+  emu_reset();
+  timer.init();
+
+  if (async)
+    timer.setAsyncClock();
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint16_t i = 0; i < SWEEP_SETFREQ_RUNS; i++)
+    timer.setFrequency(frequency, sweepCallback);
+
+  auto    stop          = std::chrono::steady_clock::now();
+  double  setFreqNanos  = std::chrono::duration<double, std::nano>(stop - start).count() / SWEEP_SETFREQ_RUNS;
+
+  // Emulated run
+  emu_reset();
+  timer.init();
+
+  if (async)
+    timer.setAsyncClock();
+
+  callbacks = 0;
+
+  if (!timer.setFrequency(frequency, sweepCallback))
+  {
+    // Over half the timer clock (async Timer2: 16384 Hz), refusing is right
+    bool outOfRange = (2 * frequency > timer.getClockFrequency());
+
+    printf("Timer%u %12.4f  setFrequency() refused  %s\n", timerNo, frequency, outOfRange ? "OK, out of range" : "FAIL");
+
+    return outOfRange;
+  }
+
+  double    cyclesPerTick   = emu_timerCyclesPerTick(timerNo);
+  uint32_t  plannedTicks    = timer.get_OCRValue() + timer.getInterruptsPerPeriod();
+  double    plannedCycles   = plannedTicks * cyclesPerTick;
+  uint64_t  step            = (uint64_t) plannedCycles + 1;
+
+  while ( (callbacks < periods + 1) && (emu_cycle < SWEEP_MAX_SECONDS * F_CPU) )
+    emu_run(step);
+
+  timer.detachInterrupt();
+
+  if (callbacks < 2)
+  {
+    printf("Timer%u %12.4f  %u callback(s) in %.0f s  FAIL\n", timerNo, frequency, callbacks, (double) emu_cycle / F_CPU);
+
+    return false;
+  }
+
+  double  period        = (double) (lastCycle - firstCycle) / (callbacks - 1);
+  double  achieved      = F_CPU / period;
+  double  errorPPM      = (achieved - frequency) * 1000000.0 / frequency;
+  double  isrsPerPeriod = (double) (lastISRs - firstISRs) / (callbacks - 1);
+
+  // Async Timer2: the ticks fall on the nearest CPU cycle
+  bool  periodOK  = fabs(period - plannedCycles) <= (async ? 1.0 : 0.0);
+  bool  isrsOK    = (isrsPerPeriod == timer.getInterruptsPerPeriod());
+  bool  ppmOK     = (maxPPM <= 0) || (fabs(errorPPM) <= maxPPM);
+  bool  ok        = periodOK && isrsOK && ppmOK;
+
+  printf("Timer%u %12.4f %6.0f %10u %5u %6.2f %14.6f %10.1f %9.1f %5u %9.0f  %s%s%s%s\n", timerNo, frequency,
+         cyclesPerTick, plannedTicks, timer.getInterruptsPerPeriod(), isrsPerPeriod, achieved, errorPPM,
+         timer.getErrorPPM(), callbacks, setFreqNanos, ok ? "OK" : "FAIL", periodOK ? "" : " period", isrsOK ? "" : " isrs",
+         ppmOK ? "" : " ppm");
+
+  return ok;
+}
+
+///////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+  uint8_t   timerList[SWEEP_MAX_ITEMS];
+  float     freqList[SWEEP_MAX_ITEMS];
+  uint8_t   numTimers = 0;
+  uint8_t   numFreqs  = 0;
+  uint32_t  periods   = 5;
+  bool      async     = false;
+  double    maxPPM    = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool hasValue = (i + 1 < argc);
+
+    if (!strcmp(argv[i], "--timer") && hasValue && (numTimers < SWEEP_MAX_ITEMS))
+      timerList[numTimers++] = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--freq") && hasValue && (numFreqs < SWEEP_MAX_ITEMS))
+      freqList[numFreqs++] = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--periods") && hasValue)
+      periods = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--isr-cycles") && hasValue)
+      emu_isrCycles = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--max-ppm") && hasValue)
+      maxPPM = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--async"))
+      async = true;
+    else if (!strcmp(argv[i], "--trace"))
+      emu_trace = true;
+    else if (!strcmp(argv[i], "--serial"))
+      emu_serialOutput = true;
+    else
+    {
+      fprintf(stderr, "Usage: %s [--timer n]... [--freq f]... [--periods n] [--isr-cycles n] [--async] [--max-ppm x] "
+              "[--trace] [--serial]\n", argv[0]);
+
+      return 2;
+    }
+  }
+
+  if (numTimers == 0)
+  {
+    for (uint8_t timerNo = 1; timerNo <= 5; timerNo++)
+      timerList[numTimers++] = timerNo;
+  }
+
+  if (numFreqs == 0)
+  {
+    for (uint8_t i = 0; i < sizeof(defaultFrequencies) / sizeof(defaultFrequencies[0]); i++)
+      freqList[numFreqs++] = defaultFrequencies[i];
+  }
+
+  if (periods < 1)
+    periods = 1;
+
+  printf("%s, F_CPU = %lu, ISR = %u cycles%s\n", TIMER_INTERRUPT_VERSION, (unsigned long) F_CPU,
+         emu_isrCycles, async ? ", Timer2 async" : "");
+  printf("Timer    Requested(Hz)  Cyc/T      Ticks  Int/P  Meas    Achieved(Hz) Error(ppm) Plan(ppm) Calls  SetF(ns)  Check\n");
+
+  uint32_t failures = 0;
+
+  for (uint8_t t = 0; t < numTimers; t++)
+  {
+    if ( (timerList[t] < 1) || (timerList[t] > 5) )
+    {
+      fprintf(stderr, "Timer%u not emulated\n", timerList[t]);
+
+      return 2;
+    }
+
+    for (uint8_t f = 0; f < numFreqs; f++)
+    {
+      if (!sweep(timerList[t], freqList[f], periods, async && (timerList[t] == 2), maxPPM))
+        failures++;
+    }
+  }
+
+  printf("%u FAIL\n", failures);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+/****************************************************************************************************************************
+  emu.h
+  Host-side register-level emulator of the AVR (ATmega2560) and megaAVR (ATmega4809) timers
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  The mock headers of mock/ declare the timer registers as plain variables, so that AVRTimerInterrupt_Generic.h and
+  megaAVR_TimerInterrupt_Generic.h compile unmodified with the host g++. The emulator steps the timer counters from
+  those registers, cycle-exact but jumping from one timer event to the next, sets the interrupt flags, and runs
+  the ISR(...) of the headers as the interrupt controller would.
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_H
+#define EMU_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////
+
+// CPU cycles since emu_reset()
+extern uint64_t emu_cycle;
+
+// CPU cycles taken by each ISR, during which the timers keep counting. 0 by default
+extern uint32_t emu_isrCycles;
+
+// true => print each ISR call: cycle, vector, counter and compare registers
+extern bool     emu_trace;
+
+// true => Serial output of the sketch / library goes to stdout
+extern bool     emu_serialOutput;
+
+///////////////////////////////////////////
+
+// Reset the timers and the interrupt controller, as after a reset and the init() of the Arduino core
+void      emu_reset();
+
+// Run 'cycles' CPU cycles, the ISRs being called when their flags are set
+void      emu_run(const uint64_t& cycles);
+
+// Run until the next ISR, as sleep_cpu(). Returns false if no timer can wake the CPU up
+bool      emu_sleep();
+
+// Run the pending ISRs, if the interrupts are enabled
+void      emu_dispatch();
+
+// Called by the 'reti' of TimerInterrupt_clearLevel0Ex() (megaAVR): clear LVL0EX and enable the interrupts
+extern "C" void emu_reti();
+
+///////////////////////////////////////////
+
+// Number of ISR calls of vector 'name', since emu_reset()
+uint32_t  emu_isrCount(const char* name);
+
+// Total number of ISR calls since emu_reset()
+uint32_t  emu_isrTotal();
+
+// Timer clock of the timer, in CPU cycles per timer tick (0 => stopped). AVR: 1-5. megaAVR: TCB 0-3, 4 = TCA0
+double    emu_timerCyclesPerTick(const uint8_t& timer);
+
+///////////////////////////////////////////
+
+// Interface of the MCU models, emu_avr.cpp and emu_megaavr.cpp
+
+void        emu_modelReset();
+uint64_t    emu_modelNextEvent();                       // CPU cycle of the next timer event, UINT64_MAX if none
+void        emu_modelAdvanceTo(const uint64_t& cycle);  // count up to 'cycle', setting the flags
+int         emu_modelPendingVector();                   // highest priority pending and enabled vector, -1 if none
+void        emu_modelAcknowledge(const int& vector);    // AVR: clear the flag of the vector being entered
+void        emu_modelCall(const int& vector);
+const char* emu_modelVectorName(const int& vector);
+int         emu_modelNumVectors();
+void        emu_modelTrace(const int& vector);        // print the registers of the timer of the vector
+bool        emu_modelHasLevel0Ex();                     // megaAVR: CPUINT blocks level 0 nesting until reti
+
+#endif    // EMU_H
@@ -0,0 +1,756 @@
+/****************************************************************************************************************************
+  emu_avr.cpp
+  Host-side register-level model of the ATmega2560 Timer1-5, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Each timer counts from its TCCRnA / TCCRnB / TCNTn / OCRnx / ICRn as the datasheet describes it:
+  - clock from the free running prescaler of the CPU clock, or for Timer2 from the 32.768 kHz crystal (ASSR AS2)
+  - Normal, CTC, Fast PWM, Phase Correct and Phase and Frequency Correct modes, TOP = MAX, OCRnA or ICRn
+  - OCRnx double buffered in the PWM modes
+  - TOVn, OCFnA / B / C and ICFn (ICRn as TOP) set in TIFRn, cleared by the vector entry or by writing 1
+  - asynchronous Timer2: a new OCR2x latched two TOSC1 ticks after the write. TCNT2 and TCCR2x take it at once
+  The input capture itself, from the ICPn pin, and the OCnx outputs are not emulated.
+  The model jumps from one event (compare match, TOP, BOTTOM, MAX) to the next, so that a long period costs no more
+  than a short one, but each event falls on its exact CPU cycle.
+*****************************************************************************************************************************/
+
+#include "Arduino.h"
+#include "emu.h"
+
+///////////////////////////////////////////
+
+// Register file
+
+volatile uint8_t  emu_TCCR1A, emu_TCCR1B, emu_TCCR1C, emu_TIMSK1;
+volatile uint8_t  emu_TCCR3A, emu_TCCR3B, emu_TCCR3C, emu_TIMSK3;
+volatile uint8_t  emu_TCCR4A, emu_TCCR4B, emu_TCCR4C, emu_TIMSK4;
+volatile uint8_t  emu_TCCR5A, emu_TCCR5B, emu_TCCR5C, emu_TIMSK5;
+
+volatile uint16_t emu_TCNT1, emu_OCR1A, emu_OCR1B, emu_OCR1C, emu_ICR1;
+volatile uint16_t emu_TCNT3, emu_OCR3A, emu_OCR3B, emu_OCR3C, emu_ICR3;
+volatile uint16_t emu_TCNT4, emu_OCR4A, emu_OCR4B, emu_OCR4C, emu_ICR4;
+volatile uint16_t emu_TCNT5, emu_OCR5A, emu_OCR5B, emu_OCR5C, emu_ICR5;
+
+volatile uint8_t  emu_TCCR2A, emu_TCCR2B, emu_TIMSK2, emu_ASSR;
+volatile uint8_t  emu_TCNT2, emu_OCR2A, emu_OCR2B;
+
+emu_flags_t       emu_TIFR1, emu_TIFR2, emu_TIFR3, emu_TIFR4, emu_TIFR5;
+
+///////////////////////////////////////////
+
+// Vectors not defined by the sketch / library. Entering one clears its flag, as the real CPU does
+#define EMU_DEFAULT_VECTOR(vector)    extern "C" void __attribute__((weak)) vector(void) {}
+
+#define EMU_DEFAULT_TIMER_VECTORS(n)                                                  \
+  EMU_DEFAULT_VECTOR(TIMER##n##_CAPT_vect)  EMU_DEFAULT_VECTOR(TIMER##n##_COMPA_vect) \
+  EMU_DEFAULT_VECTOR(TIMER##n##_COMPB_vect) EMU_DEFAULT_VECTOR(TIMER##n##_COMPC_vect) \
+  EMU_DEFAULT_VECTOR(TIMER##n##_OVF_vect)
+
+EMU_DEFAULT_VECTOR(TIMER2_COMPA_vect)
+EMU_DEFAULT_VECTOR(TIMER2_COMPB_vect)
+EMU_DEFAULT_VECTOR(TIMER2_OVF_vect)
+
+EMU_DEFAULT_TIMER_VECTORS(1)
+EMU_DEFAULT_TIMER_VECTORS(3)
+EMU_DEFAULT_TIMER_VECTORS(4)
+EMU_DEFAULT_TIMER_VECTORS(5)
+
+///////////////////////////////////////////
+
+#define EMU_TOSC_FREQ     32768UL
+
+enum
+{
+  EMU_TOV   = 0,
+  EMU_OCFA  = 1,
+  EMU_OCFB  = 2,
+  EMU_OCFC  = 3,
+  EMU_ICF   = 5
+};
+
+class EmuTimer
+{
+  public:
+
+    typedef enum
+    {
+      NORMAL,
+      CTC,
+      FAST_PWM,
+      PHASE_CORRECT,
+      PHASE_FREQ_CORRECT
+    } type_t;
+
+    typedef enum
+    {
+      TOP_MAX,
+      TOP_FIXED,
+      TOP_OCRA,
+      TOP_ICR
+    } top_t;
+
+    const char*         name;
+    volatile uint8_t&   TCCRA;
+    volatile uint8_t&   TCCRB;
+    volatile uint8_t&   TIMSK;
+    emu_flags_t&        TIFR;
+
+    // 16-bit timers
+    volatile uint16_t*  TCNT16;
+    volatile uint16_t*  OCR16[3];
+    volatile uint16_t*  ICR16;
+
+    // Timer2
+    volatile uint8_t*   TCNT8;
+    volatile uint8_t*   OCR8[2];
+
+    EmuTimer(const char* name, volatile uint8_t& TCCRA, volatile uint8_t& TCCRB, volatile uint8_t& TIMSK, emu_flags_t& TIFR,
+             volatile uint16_t* TCNT, volatile uint16_t* OCRA, volatile uint16_t* OCRB, volatile uint16_t* OCRC,
+             volatile uint16_t* ICR)
+      : name(name), TCCRA(TCCRA), TCCRB(TCCRB), TIMSK(TIMSK), TIFR(TIFR), TCNT16(TCNT), ICR16(ICR), TCNT8(NULL)
+    {
+      OCR16[0] = OCRA;
+      OCR16[1] = OCRB;
+      OCR16[2] = OCRC;
+      OCR8[0]  = OCR8[1] = NULL;
+    }
+
+    EmuTimer(const char* name, volatile uint8_t& TCCRA, volatile uint8_t& TCCRB, volatile uint8_t& TIMSK, emu_flags_t& TIFR,
+             volatile uint8_t* TCNT, volatile uint8_t* OCRA, volatile uint8_t* OCRB)
+      : name(name), TCCRA(TCCRA), TCCRB(TCCRB), TIMSK(TIMSK), TIFR(TIFR), TCNT16(NULL), ICR16(NULL), TCNT8(TCNT)
+    {
+      OCR16[0] = OCR16[1] = OCR16[2] = NULL;
+      OCR8[0]  = OCRA;
+      OCR8[1]  = OCRB;
+    }
+
+    void reset()
+    {
+      prescaler = 0;
+      async     = false;
+      ticks     = 0;
+      wgm       = 0xFF;
+      down      = false;
+
+      latchPending[0] = latchPending[1] = false;
+    }
+
+    // Timer clock in CPU cycles per tick, 0 => stopped
+    double cyclesPerTick()
+    {
+      sync();
+
+      if (prescaler == 0)
+        return 0;
+
+      return async ? ( (double) F_CPU * prescaler / EMU_TOSC_FREQ ) : prescaler;
+    }
+
+    // CPU cycle of the next event, UINT64_MAX if stopped
+    uint64_t nextEvent()
+    {
+      sync();
+
+      if (prescaler == 0)
+        return UINT64_MAX;
+
+      return cycleOfTick(ticks + ticksToEvent());
+    }
+
+    void advanceTo(const uint64_t& cycle)
+    {
+      sync();
+
+      if (prescaler == 0)
+        return;
+
+      uint64_t target = tickIndexAt(cycle);
+
+      while (ticks < target)
+      {
+        latch();
+
+        uint32_t distance = ticksToEvent();
+
+        if (ticks + distance > target)
+        {
+          count( (uint32_t) (target - ticks) );
+          ticks = target;
+        }
+        else
+        {
+          count(distance - 1);
+          tick();
+          ticks += distance;
+        }
+      }
+    }
+
+    void trace()
+    {
+      printf(" TCNT=%-5u OCRA=%-5u", getCount(), ocrLive(0));
+
+      if (ICR16)
+        printf(" ICR=%-5u", *ICR16);
+
+      printf(" TCCRA=0x%02X TCCRB=0x%02X", TCCRA, TCCRB);
+    }
+
+  private:
+
+    uint16_t  prescaler;    // CPU cycles (or TOSC cycles if async) per tick, 0 => stopped
+    bool      async;
+    uint64_t  ticks;        // index of the last timer tick, counted from cycle 0 of the clock source
+    uint8_t   wgm;
+    bool      down;         // Phase Correct: counting down
+    uint16_t  buffer[3];    // OCRnx in use, double buffered in the PWM modes
+
+    // Asynchronous Timer2: OCR2x in the TOSC1 clock domain, and the tick taking the value written by the CPU
+    uint16_t  latched[2];
+    bool      latchPending[2];
+    uint64_t  latchTick[2];
+
+    bool is8bit()
+    {
+      return (TCNT8 != NULL);
+    }
+
+    uint16_t getCount()
+    {
+      return is8bit() ? *TCNT8 : *TCNT16;
+    }
+
+    void setCount(const uint16_t& value)
+    {
+      if (is8bit())
+        *TCNT8  = (uint8_t) value;
+      else
+        *TCNT16 = value;
+    }
+
+    uint8_t numCompares()
+    {
+      return is8bit() ? 2 : 3;
+    }
+
+    uint16_t ocrLive(const uint8_t& index)
+    {
+      return is8bit() ? *OCR8[index] : *OCR16[index];
+    }
+
+    uint16_t maxValue()
+    {
+      return is8bit() ? 0xFF : 0xFFFF;
+    }
+
+    ///////////////////////////////////////////
+
+    uint8_t currentWGM()
+    {
+      if (is8bit())
+        return (TCCRA & 0x03) | ( (TCCRB & bit(WGM22)) ? 0x04 : 0 );
+
+      return (TCCRA & 0x03) | ( (TCCRB >> 1) & 0x0C );
+    }
+
+    type_t type()
+    {
+      if (is8bit())
+      {
+        static const type_t type8[8]    = { NORMAL, PHASE_CORRECT, CTC, FAST_PWM, NORMAL, PHASE_CORRECT, NORMAL, FAST_PWM };
+
+        return type8[wgm];
+      }
+
+      static const type_t type16[16]  = { NORMAL, PHASE_CORRECT, PHASE_CORRECT, PHASE_CORRECT, CTC, FAST_PWM, FAST_PWM, FAST_PWM,
+                                          PHASE_FREQ_CORRECT, PHASE_FREQ_CORRECT, PHASE_CORRECT, PHASE_CORRECT, CTC, NORMAL,
+                                          FAST_PWM, FAST_PWM
+                                        };
+
+      return type16[wgm];
+    }
+
+    top_t topSource()
+    {
+      if (is8bit())
+      {
+        switch (wgm)
+        {
+          case 1: case 3:
+            return TOP_FIXED;
+
+          case 2: case 5: case 7:
+            return TOP_OCRA;
+
+          default:
+            return TOP_MAX;
+        }
+      }
+
+      switch (wgm)
+      {
+        case 1: case 2: case 3: case 5: case 6: case 7:
+          return TOP_FIXED;
+
+        case 4: case 9: case 11: case 15:
+          return TOP_OCRA;
+
+        case 8: case 10: case 12: case 14:
+          return TOP_ICR;
+
+        default:
+          return TOP_MAX;
+      }
+    }
+
+    bool buffered()
+    {
+      type_t t = type();
+
+      return (t != NORMAL) && (t != CTC);
+    }
+
+    uint16_t ocrWritten(const uint8_t& index)
+    {
+      return async ? latched[index] : ocrLive(index);
+    }
+
+    uint16_t ocr(const uint8_t& index)
+    {
+      return buffered() ? buffer[index] : ocrWritten(index);
+    }
+
+    uint16_t top()
+    {
+      switch (topSource())
+      {
+        case TOP_FIXED:
+          // 8, 9 or 10-bit PWM
+          return is8bit() ? 0xFF : ( (0x100 << ( (wgm & 0x03) - 1 )) - 1 );
+
+        case TOP_OCRA:
+          return ocr(0);
+
+        case TOP_ICR:
+          return *ICR16;
+
+        default:
+          return maxValue();
+      }
+    }
+
+    void loadBuffers()
+    {
+      for (uint8_t i = 0; i < numCompares(); i++)
+        buffer[i] = ocrWritten(i);
+    }
+
+    ///////////////////////////////////////////
+
+    uint16_t currentPrescaler()
+    {
+      static const uint16_t prescaler16[8]  = { 0, 1, 8, 64, 256, 1024, 0, 0 };     // 6, 7 => external clock, not emulated
+      static const uint16_t prescaler2[8]   = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+      return is8bit() ? prescaler2[TCCRB & 0x07] : prescaler16[TCCRB & 0x07];
+    }
+
+    bool currentAsync()
+    {
+      return is8bit() && (ASSR & bit(AS2));
+    }
+
+    // Picks up the changes of clock and mode since the last call
+    void sync()
+    {
+      uint16_t  newPrescaler  = currentPrescaler();
+      bool      newAsync      = currentAsync();
+
+      if ( (newPrescaler != prescaler) || (newAsync != async) )
+      {
+        if (newAsync && !async)
+        {
+          for (uint8_t i = 0; i < 2; i++)
+          {
+            latched[i]      = ocrLive(i);
+            latchPending[i] = false;
+          }
+        }
+
+        prescaler = newPrescaler;
+        async     = newAsync;
+
+        if (prescaler != 0)
+          ticks = tickIndexAt(emu_cycle);
+      }
+
+      // A write to OCR2x since the last call: the next tick still uses the old value
+      if (async)
+      {
+        for (uint8_t i = 0; i < 2; i++)
+        {
+          if (!latchPending[i] && (ocrLive(i) != latched[i]))
+          {
+            latchPending[i] = true;
+            latchTick[i]    = ticks + 1;
+          }
+        }
+
+        latch();
+      }
+
+      uint8_t newWGM = currentWGM();
+
+      if (newWGM != wgm)
+      {
+        wgm   = newWGM;
+        down  = false;
+
+        loadBuffers();
+      }
+    }
+
+    // Number of timer ticks from cycle 0 up to 'cycle'. The prescaler runs free, so that the ticks fall on its multiples
+    uint64_t tickIndexAt(const uint64_t& cycle)
+    {
+      if (async)
+        return (cycle * EMU_TOSC_FREQ) / ( (uint64_t) F_CPU * prescaler );
+
+      return cycle / prescaler;
+    }
+
+    // First CPU cycle of tick 'index'
+    uint64_t cycleOfTick(const uint64_t& index)
+    {
+      if (async)
+      {
+        uint64_t scaled = index * F_CPU * prescaler;
+
+        return (scaled + EMU_TOSC_FREQ - 1) / EMU_TOSC_FREQ;
+      }
+
+      return index * prescaler;
+    }
+
+    void latch()
+    {
+      for (uint8_t i = 0; i < 2; i++)
+      {
+        if (latchPending[i] && (ticks >= latchTick[i]))
+        {
+          latched[i]      = ocrLive(i);
+          latchPending[i] = false;
+        }
+      }
+    }
+
+    ///////////////////////////////////////////
+
+    // Ticks up to the next one changing more than TCNT: a compare match, TOP, BOTTOM, MAX, or an OCR2x latch. At least 1
+    uint32_t ticksToEvent()
+    {
+      uint32_t  distance  = eventDistance();
+
+      for (uint8_t i = 0; i < 2; i++)
+      {
+        if (latchPending[i] && (latchTick[i] > ticks) && (latchTick[i] - ticks < distance))
+          distance = (uint32_t) (latchTick[i] - ticks);
+      }
+
+      return distance;
+    }
+
+    uint32_t eventDistance()
+    {
+      uint32_t  value     = getCount();
+      uint32_t  topValue  = top();
+      type_t    t         = type();
+      uint32_t  distance;
+
+      if (t == PHASE_CORRECT || t == PHASE_FREQ_CORRECT)
+      {
+        if (down)
+        {
+          distance = value;
+
+          for (uint8_t i = 0; i < numCompares(); i++)
+          {
+            if ( (ocr(i) < value) && (value - ocr(i) < distance) )
+              distance = value - ocr(i);
+          }
+
+          return (distance > 0) ? distance : 1;
+        }
+
+        if (value >= topValue)
+          return 1;
+      }
+      else if ( (value == topValue) || (value == maxValue()) )
+      {
+        return 1;
+      }
+
+      distance = maxValue() - value;
+
+      if ( (topValue > value) && (topValue - value < distance) )
+        distance = topValue - value;
+
+      for (uint8_t i = 0; i < numCompares(); i++)
+      {
+        if ( (ocr(i) > value) && (ocr(i) - value < distance) )
+          distance = ocr(i) - value;
+      }
+
+      return distance;
+    }
+
+    // 'ticks' ticks with no event
+    void count(const uint32_t& ticks)
+    {
+      if (ticks == 0)
+        return;
+
+      if (down)
+        setCount(getCount() - ticks);
+      else
+        setCount(getCount() + ticks);
+    }
+
+    // One tick, with its flags
+    void tick()
+    {
+      uint16_t  value     = getCount();
+      uint16_t  topValue  = top();
+      type_t    t         = type();
+      uint8_t   flags     = 0;
+
+      switch (t)
+      {
+        case NORMAL:
+        case CTC:
+        case FAST_PWM:
+
+          if ( (t != NORMAL) && (value == topValue) )
+          {
+            value = 0;
+
+            if (t == FAST_PWM)
+              loadBuffers();
+          }
+          else if (value == maxValue())
+          {
+            value = 0;
+            flags |= bit(EMU_TOV);
+          }
+          else
+            value++;
+
+          if ( (t == FAST_PWM) && (value == top()) )
+            flags |= bit(EMU_TOV);
+
+          break;
+
+        default:
+
+          if (!down)
+          {
+            if (value >= topValue)
+            {
+              down = true;
+
+              if (t == PHASE_CORRECT)
+                loadBuffers();
+
+              value = (value > 0) ? value - 1 : 0;
+            }
+            else
+              value++;
+          }
+          else
+          {
+            value--;
+
+            if (value == 0)
+            {
+              down = false;
+              flags |= bit(EMU_TOV);
+
+              if (t == PHASE_FREQ_CORRECT)
+                loadBuffers();
+            }
+          }
+
+          break;
+      }
+
+      setCount(value);
+
+      for (uint8_t i = 0; i < numCompares(); i++)
+      {
+        if (value == ocr(i))
+          flags |= bit(EMU_OCFA + i);
+      }
+
+      // ICRn as TOP sets ICFn at TOP
+      if ( (topSource() == TOP_ICR) && (value == top()) )
+        flags |= bit(EMU_ICF);
+
+      TIFR.value |= flags;
+    }
+};
+
+///////////////////////////////////////////
+
+static EmuTimer timer1("Timer1", TCCR1A, TCCR1B, TIMSK1, TIFR1, &TCNT1, &OCR1A, &OCR1B, &OCR1C, &ICR1);
+static EmuTimer timer2("Timer2", TCCR2A, TCCR2B, TIMSK2, TIFR2, &TCNT2, &OCR2A, &OCR2B);
+static EmuTimer timer3("Timer3", TCCR3A, TCCR3B, TIMSK3, TIFR3, &TCNT3, &OCR3A, &OCR3B, &OCR3C, &ICR3);
+static EmuTimer timer4("Timer4", TCCR4A, TCCR4B, TIMSK4, TIFR4, &TCNT4, &OCR4A, &OCR4B, &OCR4C, &ICR4);
+static EmuTimer timer5("Timer5", TCCR5A, TCCR5B, TIMSK5, TIFR5, &TCNT5, &OCR5A, &OCR5B, &OCR5C, &ICR5);
+
+static EmuTimer* const timers[] = { &timer1, &timer2, &timer3, &timer4, &timer5 };
+
+#define EMU_NUM_TIMERS    ( sizeof(timers) / sizeof(timers[0]) )
+
+typedef struct
+{
+  const char* name;
+  EmuTimer*   timer;
+  uint8_t     flag;
+  void        (*handler)(void);
+} emu_vector_t;
+
+#define EMU_TIMER_VECTORS(n)                                            \
+  { "TIMER" #n "_CAPT",  &timer##n, EMU_ICF,  TIMER##n##_CAPT_vect  },  \
+  { "TIMER" #n "_COMPA", &timer##n, EMU_OCFA, TIMER##n##_COMPA_vect },  \
+  { "TIMER" #n "_COMPB", &timer##n, EMU_OCFB, TIMER##n##_COMPB_vect },  \
+  { "TIMER" #n "_COMPC", &timer##n, EMU_OCFC, TIMER##n##_COMPC_vect },  \
+  { "TIMER" #n "_OVF",   &timer##n, EMU_TOV,  TIMER##n##_OVF_vect   }
+
+// In priority order, as in the vector table
+static const emu_vector_t vectors[] =
+{
+  { "TIMER2_COMPA", &timer2, EMU_OCFA, TIMER2_COMPA_vect },
+  { "TIMER2_COMPB", &timer2, EMU_OCFB, TIMER2_COMPB_vect },
+  { "TIMER2_OVF",   &timer2, EMU_TOV,  TIMER2_OVF_vect   },
+  EMU_TIMER_VECTORS(1),
+  EMU_TIMER_VECTORS(3),
+  EMU_TIMER_VECTORS(4),
+  EMU_TIMER_VECTORS(5)
+};
+
+#define EMU_NUM_VECTORS   ( sizeof(vectors) / sizeof(vectors[0]) )
+
+///////////////////////////////////////////
+
+void emu_modelReset()
+{
+  // init() of the Arduino core: Timer1-5 in 8-bit Phase Correct PWM, prescaler 64 (Timer2: 64 too)
+  TCCR1A = bit(WGM10);
+  TCCR1B = bit(CS11) | bit(CS10);
+  TCCR1C = TIMSK1 = 0;
+  TCNT1  = OCR1A = OCR1B = OCR1C = ICR1 = 0;
+
+  TCCR3A = bit(WGM30);
+  TCCR3B = bit(CS31) | bit(CS30);
+  TCCR3C = TIMSK3 = 0;
+  TCNT3  = OCR3A = OCR3B = OCR3C = ICR3 = 0;
+
+  TCCR4A = bit(WGM40);
+  TCCR4B = bit(CS41) | bit(CS40);
+  TCCR4C = TIMSK4 = 0;
+  TCNT4  = OCR4A = OCR4B = OCR4C = ICR4 = 0;
+
+  TCCR5A = bit(WGM50);
+  TCCR5B = bit(CS51) | bit(CS50);
+  TCCR5C = TIMSK5 = 0;
+  TCNT5  = OCR5A = OCR5B = OCR5C = ICR5 = 0;
+
+  TCCR2A = bit(WGM20);
+  TCCR2B = bit(CS22);
+  TIMSK2 = ASSR = 0;
+  TCNT2  = OCR2A = OCR2B = 0;
+
+  TIFR1.value = TIFR2.value = TIFR3.value = TIFR4.value = TIFR5.value = 0;
+
+  for (uint8_t i = 0; i < EMU_NUM_TIMERS; i++)
+    timers[i]->reset();
+}
+
+uint64_t emu_modelNextEvent()
+{
+  uint64_t next = UINT64_MAX;
+
+  for (uint8_t i = 0; i < EMU_NUM_TIMERS; i++)
+  {
+    uint64_t event = timers[i]->nextEvent();
+
+    if (event < next)
+      next = event;
+  }
+
+  return next;
+}
+
+void emu_modelAdvanceTo(const uint64_t& cycle)
+{
+  for (uint8_t i = 0; i < EMU_NUM_TIMERS; i++)
+    timers[i]->advanceTo(cycle);
+}
+
+int emu_modelPendingVector()
+{
+  for (uint8_t i = 0; i < EMU_NUM_VECTORS; i++)
+  {
+    const emu_vector_t& v = vectors[i];
+
+    if (v.timer->TIFR & v.timer->TIMSK & bit(v.flag))
+      return i;
+  }
+
+  return -1;
+}
+
+void emu_modelAcknowledge(const int& vector)
+{
+  const emu_vector_t& v = vectors[vector];
+
+  v.timer->TIFR.value &= ~bit(v.flag);
+}
+
+void emu_modelCall(const int& vector)
+{
+  vectors[vector].handler();
+}
+
+const char* emu_modelVectorName(const int& vector)
+{
+  return vectors[vector].name;
+}
+
+int emu_modelNumVectors()
+{
+  return EMU_NUM_VECTORS;
+}
+
+void emu_modelTrace(const int& vector)
+{
+  vectors[vector].timer->trace();
+}
+
+bool emu_modelHasLevel0Ex()
+{
+  return false;
+}
+
+///////////////////////////////////////////
+
+double emu_timerCyclesPerTick(const uint8_t& timer)
+{
+  if ( (timer < 1) || (timer > EMU_NUM_TIMERS) )
+    return 0;
+
+  return timers[timer - 1]->cyclesPerTick();
+}
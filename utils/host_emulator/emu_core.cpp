@@ -0,0 +1,253 @@
+/****************************************************************************************************************************
+  emu_core.cpp
+  Host-side register-level emulator of the AVR and megaAVR timers: time, interrupt controller, Arduino runtime
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+*****************************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Arduino.h"
+#include "emu.h"
+
+///////////////////////////////////////////
+
+uint64_t  emu_cycle         = 0;
+uint32_t  emu_isrCycles     = 0;
+bool      emu_trace         = false;
+bool      emu_serialOutput  = false;
+
+volatile uint8_t  emu_SREG;
+HardwareSerial    Serial;
+
+static bool     level0Ex;         // megaAVR CPUINT.STATUS LVL0EX
+static uint32_t isrDepth;
+static uint32_t isrCount[64];
+static uint64_t runEnd = UINT64_MAX;   // end of emu_run()
+
+// ISR calls at the same cycle before reporting an interrupt storm, i.e. a flag never cleared
+#define EMU_MAX_ISR_SAME_CYCLE      100000
+#define EMU_MAX_ISR_DEPTH           32
+
+///////////////////////////////////////////
+
+void emu_reset()
+{
+  emu_cycle = 0;
+  SREG      = 0;
+  level0Ex  = false;
+  isrDepth  = 0;
+
+  memset(isrCount, 0, sizeof(isrCount));
+
+  emu_modelReset();
+
+  // init() of the core enables the interrupts
+  SREG      = bit(SREG_I);
+}
+
+///////////////////////////////////////////
+
+static void advanceTo(const uint64_t& cycle)
+{
+  emu_modelAdvanceTo(cycle);
+  emu_cycle = cycle;
+}
+
+///////////////////////////////////////////
+
+void emu_dispatch()
+{
+  static uint64_t lastCycle = UINT64_MAX;
+  static uint32_t sameCycle = 0;
+
+  bool topLevel = (isrDepth == 0);
+
+  while ( (SREG & bit(SREG_I)) && !level0Ex )
+  {
+    int vector = emu_modelPendingVector();
+
+    if (vector < 0)
+      break;
+
+    // ISRs longer than their period (emu_isrCycles) would never let emu_run() return
+    if (topLevel && (emu_cycle >= runEnd))
+      break;
+
+    if (emu_cycle == lastCycle)
+    {
+      if (++sameCycle > EMU_MAX_ISR_SAME_CYCLE)
+      {
+        fprintf(stderr, "emu: interrupt storm on %s at cycle %llu, flag never cleared\n", emu_modelVectorName(vector),
+                (unsigned long long) emu_cycle);
+        exit(2);
+      }
+    }
+    else
+    {
+      lastCycle = emu_cycle;
+      sameCycle = 0;
+    }
+
+    if (++isrDepth > EMU_MAX_ISR_DEPTH)
+    {
+      fprintf(stderr, "emu: %u nested ISRs at cycle %llu, stack overflow\n", isrDepth, (unsigned long long) emu_cycle);
+      exit(2);
+    }
+
+    emu_modelAcknowledge(vector);
+    isrCount[vector]++;
+
+    if (emu_trace)
+    {
+      printf("%12llu %*s%-16s", (unsigned long long) emu_cycle, 2 * (isrDepth - 1), "", emu_modelVectorName(vector));
+      emu_modelTrace(vector);
+      printf("\n");
+    }
+
+    // Vector entry: AVR clears the I-flag, megaAVR sets LVL0EX
+    if (emu_modelHasLevel0Ex())
+      level0Ex = true;
+    else
+      SREG &= ~bit(SREG_I);
+
+    emu_modelCall(vector);
+
+    // The timers keep counting during the ISR. No ISR can run meanwhile, the time moving on without emu_dispatch()
+    if (emu_isrCycles > 0)
+      advanceTo(emu_cycle + emu_isrCycles);
+
+    // reti
+    level0Ex  = false;
+    SREG     |= bit(SREG_I);
+
+    isrDepth--;
+  }
+}
+
+///////////////////////////////////////////
+
+extern "C" void emu_reti()
+{
+  level0Ex  = false;
+  SREG     |= bit(SREG_I);
+}
+
+///////////////////////////////////////////
+
+void emu_run(const uint64_t& cycles)
+{
+  uint64_t end       = emu_cycle + cycles;
+  uint64_t outerEnd  = runEnd;
+
+  runEnd = end;
+
+  emu_dispatch();
+
+  while (emu_cycle < end)
+  {
+    uint64_t next = emu_modelNextEvent();
+
+    advanceTo( (next < end) ? next : end );
+    emu_dispatch();
+  }
+
+  runEnd = outerEnd;
+}
+
+///////////////////////////////////////////
+
+bool emu_sleep()
+{
+  uint32_t total = emu_isrTotal();
+
+  // An interrupt pending before sleep_cpu() wakes the CPU up at once
+  emu_dispatch();
+
+  while (emu_isrTotal() == total)
+  {
+    uint64_t next = emu_modelNextEvent();
+
+    if (next == UINT64_MAX)
+      return false;
+
+    advanceTo(next);
+    emu_dispatch();
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////
+
+uint32_t emu_isrCount(const char* name)
+{
+  for (int i = 0; i < emu_modelNumVectors(); i++)
+  {
+    if (strcmp(emu_modelVectorName(i), name) == 0)
+      return isrCount[i];
+  }
+
+  return 0;
+}
+
+uint32_t emu_isrTotal()
+{
+  uint32_t total = 0;
+
+  for (int i = 0; i < emu_modelNumVectors(); i++)
+    total += isrCount[i];
+
+  return total;
+}
+
+///////////////////////////////////////////
+
+// Arduino runtime
+
+unsigned long millis()
+{
+  return (unsigned long) (emu_cycle * 1000 / F_CPU);
+}
+
+unsigned long micros()
+{
+  return (unsigned long) (emu_cycle * 1000000 / F_CPU);
+}
+
+void delay(unsigned long ms)
+{
+  emu_run( (uint64_t) ms * (F_CPU / 1000) );
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  emu_run( (uint64_t) us * (F_CPU / 1000000) );
+}
+
+static uint8_t pinState[256];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  pinState[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pinState[pin];
+}
+
+void sleep_cpu()
+{
+  emu_sleep();
+}
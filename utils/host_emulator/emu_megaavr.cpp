@@ -0,0 +1,468 @@
+/****************************************************************************************************************************
+  emu_megaavr.cpp
+  Host-side register-level model of the ATmega4809 TCA0 and TCB0-3, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  - TCBn clocked by CLK_PER, CLK_PER / 2 or CLK_TCA. In Periodic Interrupt mode, CNT counts up to CCMP, then the next
+    tick clears it and sets CAPT: a period of CCMP + 1 ticks. In the other modes CNT runs free, as no event comes in
+  - TCA0 in single mode, normal counting from 0 to PER, setting OVF and CMP0-2. In split mode, as left by the core,
+    TCA0 only gives CLK_TCA
+  - CPUINT: the flags are not cleared by the vector entry, and an ISR blocks the other ones until reti (LVL0EX)
+*****************************************************************************************************************************/
+
+#include "Arduino.h"
+#include "emu.h"
+
+///////////////////////////////////////////
+
+// Register file
+
+TCB_t     emu_TCB0, emu_TCB1, emu_TCB2, emu_TCB3;
+TCA_t     emu_TCA0;
+EVSYS_t   emu_EVSYS;
+
+///////////////////////////////////////////
+
+// Vectors not defined by the sketch / library. Their flag is never cleared, as on the real CPU
+#define EMU_DEFAULT_VECTOR(vector)    extern "C" void __attribute__((weak)) vector(void) {}
+
+EMU_DEFAULT_VECTOR(TCA0_OVF_vect)
+EMU_DEFAULT_VECTOR(TCA0_CMP0_vect)
+EMU_DEFAULT_VECTOR(TCA0_CMP1_vect)
+EMU_DEFAULT_VECTOR(TCA0_CMP2_vect)
+EMU_DEFAULT_VECTOR(TCB0_INT_vect)
+EMU_DEFAULT_VECTOR(TCB1_INT_vect)
+EMU_DEFAULT_VECTOR(TCB2_INT_vect)
+EMU_DEFAULT_VECTOR(TCB3_INT_vect)
+
+///////////////////////////////////////////
+
+// CPU cycles per CLK_TCA tick, 0 => TCA0 stopped
+static uint16_t tcaPrescaler()
+{
+  static const uint16_t prescaler[] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+  if ( !(TCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm) )
+    return 0;
+
+  return prescaler[ (TCA0.SINGLE.CTRLA & TCA_SINGLE_CLKSEL_gm) >> TCA_SINGLE_CLKSEL_gp ];
+}
+
+///////////////////////////////////////////
+
+// Common part of the TCA and TCB models: a counter ticking every 'prescaler' CPU cycles, from one event to the next
+class EmuCounter
+{
+  public:
+
+    const char* name;
+
+    EmuCounter(const char* name) : name(name)
+    {
+    }
+
+    virtual ~EmuCounter()
+    {
+    }
+
+    void reset()
+    {
+      prescaler = 0;
+      ticks     = 0;
+    }
+
+    // Timer clock in CPU cycles per tick, 0 => stopped
+    double cyclesPerTick()
+    {
+      sync();
+
+      return prescaler;
+    }
+
+    // CPU cycle of the next event, UINT64_MAX if stopped
+    uint64_t nextEvent()
+    {
+      sync();
+
+      if (prescaler == 0)
+        return UINT64_MAX;
+
+      return (ticks + ticksToEvent()) * prescaler;
+    }
+
+    void advanceTo(const uint64_t& cycle)
+    {
+      sync();
+
+      if (prescaler == 0)
+        return;
+
+      uint64_t target = cycle / prescaler;
+
+      while (ticks < target)
+      {
+        uint32_t distance = ticksToEvent();
+
+        if (ticks + distance > target)
+        {
+          count( (uint32_t) (target - ticks) );
+          ticks = target;
+        }
+        else
+        {
+          count(distance - 1);
+          tick();
+          ticks += distance;
+        }
+      }
+    }
+
+    virtual void trace() = 0;
+
+  protected:
+
+    virtual uint16_t  currentPrescaler()                  = 0;
+    virtual uint32_t  ticksToEvent()                      = 0;    // ticks up to the next one setting a flag, at least 1
+    virtual void      count(const uint32_t& ticks)        = 0;    // 'ticks' ticks with no event
+    virtual void      tick()                              = 0;    // one tick, with its flags
+
+  private:
+
+    uint16_t  prescaler;    // CPU cycles per tick, 0 => stopped
+    uint64_t  ticks;        // index of the last tick. The prescalers run free, so that the ticks fall on their multiples
+
+    void sync()
+    {
+      uint16_t newPrescaler = currentPrescaler();
+
+      if (newPrescaler != prescaler)
+      {
+        prescaler = newPrescaler;
+
+        if (prescaler != 0)
+          ticks = emu_cycle / prescaler;
+      }
+    }
+};
+
+///////////////////////////////////////////
+
+class EmuTCB : public EmuCounter
+{
+  public:
+
+    TCB_t&  TCB;
+
+    EmuTCB(const char* name, TCB_t& TCB) : EmuCounter(name), TCB(TCB)
+    {
+    }
+
+    void trace()
+    {
+      printf(" CNT=%-5u CCMP=%-5u CTRLA=0x%02X CTRLB=0x%02X", TCB.CNT, TCB.CCMP, TCB.CTRLA, TCB.CTRLB);
+    }
+
+  protected:
+
+    uint16_t currentPrescaler()
+    {
+      if ( !(TCB.CTRLA & TCB_ENABLE_bm) )
+        return 0;
+
+      switch (TCB.CTRLA & TCB_CLKSEL_gm)
+      {
+        case TCB_CLKSEL_CLKDIV1_gc:
+          return 1;
+
+        case TCB_CLKSEL_CLKDIV2_gc:
+          return 2;
+
+        case TCB_CLKSEL_CLKTCA_gc:
+          return tcaPrescaler();
+
+        default:
+          // CLK_EV, not emulated
+          return 0;
+      }
+    }
+
+    bool periodic()
+    {
+      return ( (TCB.CTRLB & TCB_CNTMODE_gm) == TCB_CNTMODE_INT_gc );
+    }
+
+    uint32_t ticksToEvent()
+    {
+      uint32_t value = TCB.CNT;
+
+      if (periodic())
+      {
+        if (value == TCB.CCMP)
+          return 1;
+
+        if (value < TCB.CCMP)
+          return TCB.CCMP - value + 1;
+      }
+
+      return 0x10000UL - value;
+    }
+
+    void count(const uint32_t& ticks)
+    {
+      TCB.CNT = (uint16_t) (TCB.CNT + ticks);
+    }
+
+    void tick()
+    {
+      if ( periodic() && (TCB.CNT == TCB.CCMP) )
+      {
+        TCB.CNT             = 0;
+        TCB.INTFLAGS.value |= TCB_CAPT_bm;
+      }
+      else
+        TCB.CNT = (uint16_t) (TCB.CNT + 1);
+    }
+};
+
+///////////////////////////////////////////
+
+class EmuTCA : public EmuCounter
+{
+  public:
+
+    EmuTCA() : EmuCounter("TCA0")
+    {
+    }
+
+    void trace()
+    {
+      printf(" CNT=%-5u PER=%-5u CMP0=%-5u CMP1=%-5u CMP2=%-5u", TCA0.SINGLE.CNT, TCA0.SINGLE.PER, TCA0.SINGLE.CMP0,
+             TCA0.SINGLE.CMP1, TCA0.SINGLE.CMP2);
+    }
+
+    bool split()
+    {
+      return (TCA0.SINGLE.CTRLD & TCA_SINGLE_SPLITM_bm);
+    }
+
+  protected:
+
+    uint16_t currentPrescaler()
+    {
+      // Split mode: TCA0 runs, but only for CLK_TCA
+      return split() ? 0 : tcaPrescaler();
+    }
+
+    uint32_t ticksToEvent()
+    {
+      uint32_t value    = TCA0.SINGLE.CNT;
+      uint32_t distance;
+
+      if (value >= TCA0.SINGLE.PER)
+        return 1;
+
+      distance = TCA0.SINGLE.PER - value;
+
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        uint32_t compare = (&TCA0.SINGLE.CMP0)[i];
+
+        if ( (compare > value) && (compare - value < distance) )
+          distance = compare - value;
+      }
+
+      return distance;
+    }
+
+    void count(const uint32_t& ticks)
+    {
+      TCA0.SINGLE.CNT = (uint16_t) (TCA0.SINGLE.CNT + ticks);
+    }
+
+    void tick()
+    {
+      uint16_t  value = TCA0.SINGLE.CNT;
+      uint8_t   flags = 0;
+
+      if (value >= TCA0.SINGLE.PER)
+      {
+        value = 0;
+        flags |= TCA_SINGLE_OVF_bm;
+      }
+      else
+        value++;
+
+      TCA0.SINGLE.CNT = value;
+
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        if (value == (&TCA0.SINGLE.CMP0)[i])
+          flags |= (TCA_SINGLE_CMP0_bm << i);
+      }
+
+      TCA0.SINGLE.INTFLAGS.value |= flags;
+    }
+};
+
+///////////////////////////////////////////
+
+static EmuTCB tcb0("TCB0", TCB0);
+static EmuTCB tcb1("TCB1", TCB1);
+static EmuTCB tcb2("TCB2", TCB2);
+static EmuTCB tcb3("TCB3", TCB3);
+static EmuTCA tca0;
+
+static EmuCounter* const counters[] = { &tcb0, &tcb1, &tcb2, &tcb3, &tca0 };
+
+#define EMU_NUM_COUNTERS    ( sizeof(counters) / sizeof(counters[0]) )
+
+typedef struct
+{
+  const char*   name;
+  EmuCounter*   counter;
+  register8_t*  INTCTRL;
+  emu_flags_t*  INTFLAGS;
+  uint8_t       mask;
+  void          (*handler)(void);
+} emu_vector_t;
+
+// In priority order, as in the vector table
+static const emu_vector_t vectors[] =
+{
+  { "TCA0_OVF",  &tca0, &TCA0.SINGLE.INTCTRL, &TCA0.SINGLE.INTFLAGS, TCA_SINGLE_OVF_bm,  TCA0_OVF_vect  },
+  { "TCA0_CMP0", &tca0, &TCA0.SINGLE.INTCTRL, &TCA0.SINGLE.INTFLAGS, TCA_SINGLE_CMP0_bm, TCA0_CMP0_vect },
+  { "TCA0_CMP1", &tca0, &TCA0.SINGLE.INTCTRL, &TCA0.SINGLE.INTFLAGS, TCA_SINGLE_CMP1_bm, TCA0_CMP1_vect },
+  { "TCA0_CMP2", &tca0, &TCA0.SINGLE.INTCTRL, &TCA0.SINGLE.INTFLAGS, TCA_SINGLE_CMP2_bm, TCA0_CMP2_vect },
+  { "TCB0_INT",  &tcb0, &TCB0.INTCTRL,        &TCB0.INTFLAGS,        TCB_CAPT_bm,        TCB0_INT_vect  },
+  { "TCB1_INT",  &tcb1, &TCB1.INTCTRL,        &TCB1.INTFLAGS,        TCB_CAPT_bm,        TCB1_INT_vect  },
+  { "TCB2_INT",  &tcb2, &TCB2.INTCTRL,        &TCB2.INTFLAGS,        TCB_CAPT_bm,        TCB2_INT_vect  },
+  { "TCB3_INT",  &tcb3, &TCB3.INTCTRL,        &TCB3.INTFLAGS,        TCB_CAPT_bm,        TCB3_INT_vect  }
+};
+
+#define EMU_NUM_VECTORS     ( sizeof(vectors) / sizeof(vectors[0]) )
+
+///////////////////////////////////////////
+
+// TCA0 CTRLESET commands. RESET only acts with TCA0 disabled
+void emu_tcaCommand(const uint8_t& command)
+{
+  if (command == TCA_SINGLE_CMD_RESTART_gc)
+  {
+    TCA0.SINGLE.CNT = 0;
+  }
+  else if ( (command == TCA_SINGLE_CMD_RESET_gc) && !(TCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm) )
+  {
+    TCA0.SINGLE.CTRLA           = 0;
+    TCA0.SINGLE.CTRLB           = 0;
+    TCA0.SINGLE.CTRLC           = 0;
+    TCA0.SINGLE.CTRLD           = 0;
+    TCA0.SINGLE.CTRLESET.value  = 0;
+    TCA0.SINGLE.INTCTRL         = 0;
+    TCA0.SINGLE.INTFLAGS.value  = 0;
+    TCA0.SINGLE.CNT             = 0;
+    TCA0.SINGLE.PER             = 0xFFFF;
+    TCA0.SINGLE.CMP0            = 0;
+    TCA0.SINGLE.CMP1            = 0;
+    TCA0.SINGLE.CMP2            = 0;
+  }
+}
+
+///////////////////////////////////////////
+
+void emu_modelReset()
+{
+  memset( (void*) &TCB0, 0, sizeof(TCB_t) );
+  memset( (void*) &TCB1, 0, sizeof(TCB_t) );
+  memset( (void*) &TCB2, 0, sizeof(TCB_t) );
+  memset( (void*) &TCB3, 0, sizeof(TCB_t) );
+  memset( (void*) &TCA0, 0, sizeof(TCA_t) );
+  memset( (void*) &EVSYS, 0, sizeof(EVSYS_t) );
+
+  // init() of the Arduino core: TCA0 in split mode for the PWM, CLK_PER / 64 => CLK_TCA = 250 kHz at 16 MHz
+  TCA0.SPLIT.CTRLD  = TCA_SPLIT_SPLITM_bm;
+  TCA0.SPLIT.CTRLA  = TCA_SPLIT_CLKSEL_DIV64_gc | TCA_SPLIT_ENABLE_bm;
+
+  for (uint8_t i = 0; i < EMU_NUM_COUNTERS; i++)
+    counters[i]->reset();
+}
+
+uint64_t emu_modelNextEvent()
+{
+  uint64_t next = UINT64_MAX;
+
+  for (uint8_t i = 0; i < EMU_NUM_COUNTERS; i++)
+  {
+    uint64_t event = counters[i]->nextEvent();
+
+    if (event < next)
+      next = event;
+  }
+
+  return next;
+}
+
+void emu_modelAdvanceTo(const uint64_t& cycle)
+{
+  for (uint8_t i = 0; i < EMU_NUM_COUNTERS; i++)
+    counters[i]->advanceTo(cycle);
+}
+
+int emu_modelPendingVector()
+{
+  for (uint8_t i = 0; i < EMU_NUM_VECTORS; i++)
+  {
+    const emu_vector_t& v = vectors[i];
+
+    if ( (v.counter == &tca0) && tca0.split() )
+      continue;
+
+    if (*v.INTFLAGS & *v.INTCTRL & v.mask)
+      return i;
+  }
+
+  return -1;
+}
+
+void emu_modelAcknowledge(const int& vector)
+{
+  // The ISR clears the flag
+  (void) vector;
+}
+
+void emu_modelCall(const int& vector)
+{
+  vectors[vector].handler();
+}
+
+const char* emu_modelVectorName(const int& vector)
+{
+  return vectors[vector].name;
+}
+
+int emu_modelNumVectors()
+{
+  return EMU_NUM_VECTORS;
+}
+
+void emu_modelTrace(const int& vector)
+{
+  vectors[vector].counter->trace();
+}
+
+bool emu_modelHasLevel0Ex()
+{
+  return true;
+}
+
+///////////////////////////////////////////
+
+double emu_timerCyclesPerTick(const uint8_t& timer)
+{
+  if (timer >= EMU_NUM_COUNTERS)
+    return 0;
+
+  return counters[timer]->cyclesPerTick();
+}
@@ -0,0 +1,318 @@
+/****************************************************************************************************************************
+  megaavr_sweep.cpp
+  Frequency sweep of megaAVR_TimerInterrupt_Generic.h (ATmega4809 TCB0-3 and TimerTCA) on the host-side emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  For each TCB and requested frequency: the TCB clock picked by setFrequency(), the CCMP ticks, then the callbacks
+  counted on the emulated registers: achieved frequency, error, interrupts per period, and the host time taken by
+  setFrequency(). A TCB must take exactly get_CCMPValue() ticks per period, a TimerTCA channel exactly getPeriod() ticks,
+  else it's a FAIL. An error over --max-ppm (default SWEEP_DEFAULT_MAX_PPM, 0 => no limit) is a FAIL too, and the exit
+  code is then 1.
+  Then each TCB runs 10 Hz (CLK_TCA) and 1 kHz (CLK_PER) with no init() after beginCapture() / endCapture() (TCBn_CAP),
+  and after detachInterrupt() (TCBn_DET): setFrequency() alone must start it again.
+
+  Usage: megaavr_sweep [--timer n]... [--freq f]... [--periods n] [--isr-cycles n] [--max-ppm x] [--trace] [--serial]
+         timer 0-3 => TCB0-3, 4-6 => TimerTCA channel 0-2
+*****************************************************************************************************************************/
+
+#include <chrono>
+
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+#define USE_TIMER_0     true
+#define USE_TIMER_1     true
+#define USE_TIMER_2     true
+#define USE_TIMER_3     true
+#define USE_TIMER_TCA   true
+
+#include "TimerInterrupt_Generic.h"
+
+#include "emu.h"
+
+///////////////////////////////////////////
+
+#define SWEEP_MAX_ITEMS           32
+#define SWEEP_SETFREQ_RUNS        200
+#define SWEEP_MAX_SECONDS         1000.0
+#define SWEEP_TCA_FIRST           4
+#define SWEEP_NUM_TIMERS          7
+
+// State of the TCB before setFrequency(): after init(), after beginCapture() / endCapture(), after detachInterrupt()
+#define SWEEP_FROM_INIT           0
+#define SWEEP_FROM_CAPTURE        1
+#define SWEEP_FROM_DETACH         2
+
+// Pin of beginCapture() in the SWEEP_FROM_CAPTURE cases
+#define SWEEP_CAPTURE_PIN         2
+
+// Over the rounding error of the default frequencies (100 ppm): an error of one tick per period fails from 16 kHz
+#define SWEEP_DEFAULT_MAX_PPM     1000.0
+
+static TimerInterrupt* const sweepTimers[] = { &ITimer0, &ITimer1, &ITimer2, &ITimer3 };
+
+static const float defaultFrequencies[] =
+{ 0.01f, 0.1f, 0.5f, 1.0f, 3.3f, 10.0f, 60.0f, 100.0f, 333.3f, 1000.0f, 4000.0f, 10000.0f, 33333.0f, 100000.0f };
+
+// Frequencies of the SWEEP_FROM_CAPTURE and SWEEP_FROM_DETACH cases: on CLK_TCA, and on CLK_PER
+static const float restartFrequencies[] = { 10.0f, 1000.0f };
+
+static const char*  isrName;
+static uint32_t     callbacks;
+static uint64_t     firstCycle, lastCycle;
+static uint32_t     firstISRs, lastISRs;
+
+static void sweepCallback()
+{
+  if (callbacks == 0)
+  {
+    firstCycle  = emu_cycle;
+    firstISRs   = emu_isrCount(isrName);
+  }
+
+  lastCycle = emu_cycle;
+  lastISRs  = emu_isrCount(isrName);
+
+  callbacks++;
+
+  if (emu_trace)
+    printf("%12llu   callback %u\n", (unsigned long long) emu_cycle, callbacks);
+}
+
+///////////////////////////////////////////
+
+// TCB 0-3 or TimerTCA channel 0-2: start the timer at 'frequency', returns false if refused
+static bool sweepStart(const uint8_t& timerNo, const float& frequency, const uint8_t& from = SWEEP_FROM_INIT)
+{
+  if (timerNo >= SWEEP_TCA_FIRST)
+  {
+    ITimerTCA.begin();
+
+    return ITimerTCA.setFrequency(timerNo - SWEEP_TCA_FIRST, frequency, sweepCallback);
+  }
+
+  sweepTimers[timerNo]->init();
+
+  // No init() between: setFrequency() alone must enable the TCB again
+  if (from == SWEEP_FROM_CAPTURE)
+  {
+    sweepTimers[timerNo]->beginCapture(SWEEP_CAPTURE_PIN, TCB_CAPTURE_FREQUENCY);
+    sweepTimers[timerNo]->endCapture();
+  }
+  else if (from == SWEEP_FROM_DETACH)
+  {
+    sweepTimers[timerNo]->setFrequency(frequency, sweepCallback);
+    sweepTimers[timerNo]->detachInterrupt();
+  }
+
+  return sweepTimers[timerNo]->setFrequency(frequency, sweepCallback);
+}
+
+static void sweepStop(const uint8_t& timerNo)
+{
+  if (timerNo >= SWEEP_TCA_FIRST)
+    ITimerTCA.end();
+  else
+    sweepTimers[timerNo]->detachInterrupt();
+}
+
+///////////////////////////////////////////
+
+// Returns true if OK
+static bool sweep(const uint8_t& timerNo, const float& frequency, const uint32_t& periods, const double& maxPPM,
+                  const uint8_t& from = SWEEP_FROM_INIT)
+{
+  static char isr[16];
+  static char name[16];
+  bool        isTCA = (timerNo >= SWEEP_TCA_FIRST);
+
+  if (isTCA)
+    snprintf(isr, sizeof(isr), "TCA0_CMP%u", timerNo - SWEEP_TCA_FIRST);
+  else
+    snprintf(isr, sizeof(isr), "TCB%u_INT", timerNo);
+
+  // TCBn_CAP / TCBn_DET: setFrequency() after endCapture() / detachInterrupt()
+  if (from == SWEEP_FROM_CAPTURE)
+    snprintf(name, sizeof(name), "TCB%u_CAP", timerNo);
+  else if (from == SWEEP_FROM_DETACH)
+    snprintf(name, sizeof(name), "TCB%u_DET", timerNo);
+  else
+    snprintf(name, sizeof(name), "%s", isr);
+
+  isrName = isr;
+
+  // Host time of setFrequency()
+  emu_reset();
+  sweepStart(timerNo, frequency);
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint16_t i = 0; i < SWEEP_SETFREQ_RUNS; i++)
+  {
+    if (isTCA)
+      ITimerTCA.setFrequency(timerNo - SWEEP_TCA_FIRST, frequency, sweepCallback);
+    else
+      sweepTimers[timerNo]->setFrequency(frequency, sweepCallback);
+  }
+
+  auto    stop          = std::chrono::steady_clock::now();
+  double  setFreqNanos  = std::chrono::duration<double, std::nano>(stop - start).count() / SWEEP_SETFREQ_RUNS;
+
+  // Emulated run
+  emu_reset();
+  callbacks = 0;
+
+  if (!sweepStart(timerNo, frequency, from))
+  {
+    printf("%-9s %12.4f  setFrequency() refused\n", name, frequency);
+
+    // Too short a period is refused by TimerTCA (TIMER_TCA_MIN_TICKS), and by the TCBs over F_CPU / 2
+    return isTCA || (2 * frequency > F_CPU);
+  }
+
+  double    cyclesPerTick = emu_timerCyclesPerTick(isTCA ? SWEEP_TCA_FIRST : timerNo);
+  uint32_t  ticks;
+  uint32_t  interrupts;
+
+  if (isTCA)
+  {
+    ticks       = ITimerTCA.getPeriod(timerNo - SWEEP_TCA_FIRST);
+    interrupts  = (ticks + MAX_COUNT_16BIT - 1) / MAX_COUNT_16BIT;
+  }
+  else
+  {
+    ticks       = sweepTimers[timerNo]->get_CCMPValue();
+    interrupts  = (ticks + MAX_COUNT_16BIT - 1) / MAX_COUNT_16BIT;
+  }
+
+  double    plannedCycles = ticks * cyclesPerTick;
+  uint64_t  step          = (uint64_t) plannedCycles + 1;
+
+  // A stopped timer fails after twice the expected time, instead of SWEEP_MAX_SECONDS
+  double    maxCycles     = min(SWEEP_MAX_SECONDS * F_CPU, 2.0 * (periods + 2) * plannedCycles);
+
+  while ( (callbacks < periods + 1) && (emu_cycle < maxCycles) )
+    emu_run(step);
+
+  sweepStop(timerNo);
+
+  if (callbacks < 2)
+  {
+    printf("%-9s %12.4f  %u callback(s) in %.0f s  FAIL\n", name, frequency, callbacks, (double) emu_cycle / F_CPU);
+
+    return false;
+  }
+
+  double  period        = (double) (lastCycle - firstCycle) / (callbacks - 1);
+  double  achieved      = F_CPU / period;
+  double  errorPPM      = (achieved - frequency) * 1000000.0 / frequency;
+  double  isrsPerPeriod = (double) (lastISRs - firstISRs) / (callbacks - 1);
+
+  bool  periodOK  = (period == plannedCycles);
+  bool  ppmOK     = (maxPPM <= 0) || (fabs(errorPPM) <= maxPPM);
+  bool  ok        = periodOK && ppmOK;
+
+  printf("%-9s %12.4f %6.0f %10u %5u %6.2f %14.6f %10.1f %5u %9.0f  %s%s%s\n", name, frequency, cyclesPerTick, ticks,
+         interrupts, isrsPerPeriod, achieved, errorPPM, callbacks, setFreqNanos, ok ? "OK" : "FAIL",
+         periodOK ? "" : " period", ppmOK ? "" : " ppm");
+
+  return ok;
+}
+
+///////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+  uint8_t   timerList[SWEEP_MAX_ITEMS];
+  float     freqList[SWEEP_MAX_ITEMS];
+  uint8_t   numTimers = 0;
+  uint8_t   numFreqs  = 0;
+  uint32_t  periods   = 5;
+  double    maxPPM    = SWEEP_DEFAULT_MAX_PPM;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool hasValue = (i + 1 < argc);
+
+    if (!strcmp(argv[i], "--timer") && hasValue && (numTimers < SWEEP_MAX_ITEMS))
+      timerList[numTimers++] = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--freq") && hasValue && (numFreqs < SWEEP_MAX_ITEMS))
+      freqList[numFreqs++] = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--periods") && hasValue)
+      periods = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--isr-cycles") && hasValue)
+      emu_isrCycles = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--max-ppm") && hasValue)
+      maxPPM = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--trace"))
+      emu_trace = true;
+    else if (!strcmp(argv[i], "--serial"))
+      emu_serialOutput = true;
+    else
+    {
+      fprintf(stderr, "Usage: %s [--timer n]... [--freq f]... [--periods n] [--isr-cycles n] [--max-ppm x] "
+              "[--trace] [--serial]\n", argv[0]);
+
+      return 2;
+    }
+  }
+
+  if (numTimers == 0)
+  {
+    for (uint8_t timerNo = 0; timerNo < SWEEP_NUM_TIMERS; timerNo++)
+      timerList[numTimers++] = timerNo;
+  }
+
+  if (numFreqs == 0)
+  {
+    for (uint8_t i = 0; i < sizeof(defaultFrequencies) / sizeof(defaultFrequencies[0]); i++)
+      freqList[numFreqs++] = defaultFrequencies[i];
+  }
+
+  if (periods < 1)
+    periods = 1;
+
+  printf("%s, F_CPU = %lu, ISR = %u cycles\n", MEGA_AVR_TIMER_INTERRUPT_VERSION, (unsigned long) F_CPU, emu_isrCycles);
+  printf("Timer     Requested(Hz)  Cyc/T      Ticks  Int/P  Meas    Achieved(Hz) Error(ppm) Calls  SetF(ns)  Check\n");
+
+  uint32_t failures = 0;
+
+  for (uint8_t t = 0; t < numTimers; t++)
+  {
+    if (timerList[t] >= SWEEP_NUM_TIMERS)
+    {
+      fprintf(stderr, "Timer%u not emulated\n", timerList[t]);
+
+      return 2;
+    }
+
+    for (uint8_t f = 0; f < numFreqs; f++)
+    {
+      if (!sweep(timerList[t], freqList[f], periods, maxPPM))
+        failures++;
+    }
+  }
+
+  // Back to the periodic interrupt mode from the capture mode, or after detachInterrupt()
+  for (uint8_t t = 0; t < numTimers; t++)
+  {
+    if (timerList[t] >= SWEEP_TCA_FIRST)
+      continue;
+
+    for (uint8_t f = 0; f < sizeof(restartFrequencies) / sizeof(restartFrequencies[0]); f++)
+    {
+      if (!sweep(timerList[t], restartFrequencies[f], periods, maxPPM, SWEEP_FROM_CAPTURE))
+        failures++;
+
+      if (!sweep(timerList[t], restartFrequencies[f], periods, maxPPM, SWEEP_FROM_DETACH))
+        failures++;
+    }
+  }
+
+  printf("%u FAIL\n", failures);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/****************************************************************************************************************************
+  Arduino.h
+  Host-side Arduino core, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Only what the AVR / megaAVR timer code and their examples use. millis(), micros() and delay() run on the
+  emulated CPU cycles, so that delay() lets the timers count and their ISRs run.
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_ARDUINO_H
+#define EMU_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#ifndef F_CPU
+  #define F_CPU     16000000UL
+#endif
+
+///////////////////////////////////////////
+
+#define HIGH            0x1
+#define LOW             0x0
+
+#define INPUT           0x0
+#define OUTPUT          0x1
+#define INPUT_PULLUP    0x2
+
+#define DEC             10
+#define HEX             16
+#define OCT             8
+#define BIN             2
+
+#define min(a,b)        ((a)<(b)?(a):(b))
+#define max(a,b)        ((a)>(b)?(a):(b))
+
+#define bit(b)                    (1UL << (b))
+#define bitRead(value, b)         (((value) >> (b)) & 0x01)
+#define bitSet(value, b)          ((value) |= (1UL << (b)))
+#define bitClear(value, b)        ((value) &= ~(1UL << (b)))
+#define bitWrite(value, b, x)     ((x) ? bitSet(value, b) : bitClear(value, b))
+
+#define interrupts()      sei()
+#define noInterrupts()    cli()
+
+typedef uint8_t   byte;
+typedef bool      boolean;
+
+///////////////////////////////////////////
+
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t value);
+int           digitalRead(uint8_t pin);
+
+///////////////////////////////////////////
+
+class __FlashStringHelper;
+
+#define F(s)    (s)
+
+// Serial to stdout, only if emu_serialOutput is true
+extern bool emu_serialOutput;
+
+class HardwareSerial
+{
+  public:
+
+    void begin(unsigned long baud)
+    {
+      (void) baud;
+    }
+
+    void flush()
+    {
+      fflush(stdout);
+    }
+
+    operator bool() const
+    {
+      return true;
+    }
+
+    void print(const char* s)
+    {
+      if (emu_serialOutput)
+        fputs(s, stdout);
+    }
+
+    void print(char c)
+    {
+      if (emu_serialOutput)
+        fputc(c, stdout);
+    }
+
+    void print(long long n, int base = DEC)
+    {
+      if (emu_serialOutput)
+        printf( (base == HEX) ? "%llX" : "%lld", n);
+    }
+
+    void print(unsigned long long n, int base = DEC)
+    {
+      if (emu_serialOutput)
+        printf( (base == HEX) ? "%llX" : "%llu", n);
+    }
+
+    void print(int n, int base = DEC)
+    {
+      print( (long long) n, base);
+    }
+
+    void print(unsigned int n, int base = DEC)
+    {
+      print( (unsigned long long) n, base);
+    }
+
+    void print(long n, int base = DEC)
+    {
+      print( (long long) n, base);
+    }
+
+    void print(unsigned long n, int base = DEC)
+    {
+      print( (unsigned long long) n, base);
+    }
+
+    void print(double x, int digits = 2)
+    {
+      if (emu_serialOutput)
+        printf("%.*f", digits, x);
+    }
+
+    void print(bool b)
+    {
+      print( (int) b);
+    }
+
+    void println()
+    {
+      print("\n");
+    }
+
+    template<typename T>
+    void println(const T& x)
+    {
+      print(x);
+      println();
+    }
+
+    template<typename T>
+    void println(const T& x, int format)
+    {
+      print(x, format);
+      println();
+    }
+};
+
+extern HardwareSerial Serial;
+
+#include "pins_arduino.h"
+
+#endif    // EMU_ARDUINO_H
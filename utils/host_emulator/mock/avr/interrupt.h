@@ -0,0 +1,30 @@
+/****************************************************************************************************************************
+  interrupt.h
+  Host-side <avr/interrupt.h>, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  sei() and cli() only set / clear the I-flag of SREG. As on the real CPU, a pending interrupt is taken later, here
+  when the emulated time moves on: emu_run(), delay(), sleep_cpu().
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_AVR_INTERRUPT_H
+#define EMU_AVR_INTERRUPT_H
+
+#include "io.h"
+
+#define ISR(vector, ...)    extern "C" void vector(void)
+
+#define sei()               do { SREG |= (1 << SREG_I); } while (0)
+#define cli()               do { SREG &= ~(1 << SREG_I); } while (0)
+
+#if defined(__AVR_ATmega4809__)
+// An inline 'reti' of the library, see TimerInterrupt_clearLevel0Ex(), becomes a jump to emu_reti() of the emulator
+__asm__(".macro reti\n\tjmp emu_reti@PLT\n.endm");
+#endif
+
+#endif    // EMU_AVR_INTERRUPT_H
@@ -0,0 +1,25 @@
+/****************************************************************************************************************************
+  io.h
+  Host-side <avr/io.h>, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_AVR_IO_H
+#define EMU_AVR_IO_H
+
+#include <stdint.h>
+
+#if defined(__AVR_ATmega2560__)
+  #include "iom2560.h"
+#elif defined(__AVR_ATmega4809__)
+  #include "iom4809.h"
+#else
+  #error Emulated MCUs: __AVR_ATmega2560__ or __AVR_ATmega4809__
+#endif
+
+#endif    // EMU_AVR_IO_H
@@ -0,0 +1,341 @@
+/****************************************************************************************************************************
+  iom2560.h
+  Host-side register file of the ATmega2560 timers, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Only Timer1-5 are emulated. Timer0 is left to the core, millis() / micros() come from the emulator cycle count.
+  Register and bit names as in iomxx0_1.h of avr-libc, so that the #if defined() of the library select the same code.
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_IOM2560_H
+#define EMU_IOM2560_H
+
+///////////////////////////////////////////
+
+// TIFRn: a flag is cleared by writing 1 to it. TIFR1 |= bit(ICF1) clears all the set flags, as the sbi / in-or-out
+// of the real code
+class emu_flags_t
+{
+  public:
+
+    uint8_t value;
+
+    operator uint8_t() const
+    {
+      return value;
+    }
+
+    emu_flags_t& operator=(const uint8_t& x)
+    {
+      value &= ~x;
+      return *this;
+    }
+
+    emu_flags_t& operator|=(const uint8_t& x)
+    {
+      value &= ~(value | x);
+      return *this;
+    }
+
+    emu_flags_t& operator&=(const uint8_t& x)
+    {
+      value &= ~(value & x);
+      return *this;
+    }
+};
+
+extern volatile uint8_t   emu_SREG;
+#define SREG              emu_SREG
+#define SREG_I            7
+
+///////////////////////////////////////////
+
+// Timer1, 16-bit
+
+extern volatile uint8_t  emu_TCCR1A;
+#define TCCR1A           emu_TCCR1A
+extern volatile uint8_t  emu_TCCR1B;
+#define TCCR1B           emu_TCCR1B
+extern volatile uint8_t  emu_TCCR1C;
+#define TCCR1C           emu_TCCR1C
+extern volatile uint8_t  emu_TIMSK1;
+#define TIMSK1           emu_TIMSK1
+extern emu_flags_t       emu_TIFR1;
+#define TIFR1            emu_TIFR1
+extern volatile uint16_t emu_TCNT1;
+#define TCNT1            emu_TCNT1
+extern volatile uint16_t emu_OCR1A;
+#define OCR1A            emu_OCR1A
+extern volatile uint16_t emu_OCR1B;
+#define OCR1B            emu_OCR1B
+extern volatile uint16_t emu_OCR1C;
+#define OCR1C            emu_OCR1C
+extern volatile uint16_t emu_ICR1;
+#define ICR1             emu_ICR1
+
+#define WGM10            0
+#define WGM11            1
+#define COM1C0           2
+#define COM1C1           3
+#define COM1B0           4
+#define COM1B1           5
+#define COM1A0           6
+#define COM1A1           7
+
+#define CS10             0
+#define CS11             1
+#define CS12             2
+#define WGM12            3
+#define WGM13            4
+#define ICES1            6
+#define ICNC1            7
+
+#define FOC1C            5
+#define FOC1B            6
+#define FOC1A            7
+
+#define TOIE1            0
+#define OCIE1A           1
+#define OCIE1B           2
+#define OCIE1C           3
+#define ICIE1            5
+
+#define TOV1             0
+#define OCF1A            1
+#define OCF1B            2
+#define OCF1C            3
+#define ICF1             5
+
+///////////////////////////////////////////
+
+// Timer3, 16-bit
+
+extern volatile uint8_t  emu_TCCR3A;
+#define TCCR3A           emu_TCCR3A
+extern volatile uint8_t  emu_TCCR3B;
+#define TCCR3B           emu_TCCR3B
+extern volatile uint8_t  emu_TCCR3C;
+#define TCCR3C           emu_TCCR3C
+extern volatile uint8_t  emu_TIMSK3;
+#define TIMSK3           emu_TIMSK3
+extern emu_flags_t       emu_TIFR3;
+#define TIFR3            emu_TIFR3
+extern volatile uint16_t emu_TCNT3;
+#define TCNT3            emu_TCNT3
+extern volatile uint16_t emu_OCR3A;
+#define OCR3A            emu_OCR3A
+extern volatile uint16_t emu_OCR3B;
+#define OCR3B            emu_OCR3B
+extern volatile uint16_t emu_OCR3C;
+#define OCR3C            emu_OCR3C
+extern volatile uint16_t emu_ICR3;
+#define ICR3             emu_ICR3
+
+#define WGM30            0
+#define WGM31            1
+#define COM3C0           2
+#define COM3C1           3
+#define COM3B0           4
+#define COM3B1           5
+#define COM3A0           6
+#define COM3A1           7
+
+#define CS30             0
+#define CS31             1
+#define CS32             2
+#define WGM32            3
+#define WGM33            4
+#define ICES3            6
+#define ICNC3            7
+
+#define FOC3C            5
+#define FOC3B            6
+#define FOC3A            7
+
+#define TOIE3            0
+#define OCIE3A           1
+#define OCIE3B           2
+#define OCIE3C           3
+#define ICIE3            5
+
+#define TOV3             0
+#define OCF3A            1
+#define OCF3B            2
+#define OCF3C            3
+#define ICF3             5
+
+///////////////////////////////////////////
+
+// Timer4, 16-bit
+
+extern volatile uint8_t  emu_TCCR4A;
+#define TCCR4A           emu_TCCR4A
+extern volatile uint8_t  emu_TCCR4B;
+#define TCCR4B           emu_TCCR4B
+extern volatile uint8_t  emu_TCCR4C;
+#define TCCR4C           emu_TCCR4C
+extern volatile uint8_t  emu_TIMSK4;
+#define TIMSK4           emu_TIMSK4
+extern emu_flags_t       emu_TIFR4;
+#define TIFR4            emu_TIFR4
+extern volatile uint16_t emu_TCNT4;
+#define TCNT4            emu_TCNT4
+extern volatile uint16_t emu_OCR4A;
+#define OCR4A            emu_OCR4A
+extern volatile uint16_t emu_OCR4B;
+#define OCR4B            emu_OCR4B
+extern volatile uint16_t emu_OCR4C;
+#define OCR4C            emu_OCR4C
+extern volatile uint16_t emu_ICR4;
+#define ICR4             emu_ICR4
+
+#define WGM40            0
+#define WGM41            1
+#define COM4C0           2
+#define COM4C1           3
+#define COM4B0           4
+#define COM4B1           5
+#define COM4A0           6
+#define COM4A1           7
+
+#define CS40             0
+#define CS41             1
+#define CS42             2
+#define WGM42            3
+#define WGM43            4
+#define ICES4            6
+#define ICNC4            7
+
+#define FOC4C            5
+#define FOC4B            6
+#define FOC4A            7
+
+#define TOIE4            0
+#define OCIE4A           1
+#define OCIE4B           2
+#define OCIE4C           3
+#define ICIE4            5
+
+#define TOV4             0
+#define OCF4A            1
+#define OCF4B            2
+#define OCF4C            3
+#define ICF4             5
+
+///////////////////////////////////////////
+
+// Timer5, 16-bit
+
+extern volatile uint8_t  emu_TCCR5A;
+#define TCCR5A           emu_TCCR5A
+extern volatile uint8_t  emu_TCCR5B;
+#define TCCR5B           emu_TCCR5B
+extern volatile uint8_t  emu_TCCR5C;
+#define TCCR5C           emu_TCCR5C
+extern volatile uint8_t  emu_TIMSK5;
+#define TIMSK5           emu_TIMSK5
+extern emu_flags_t       emu_TIFR5;
+#define TIFR5            emu_TIFR5
+extern volatile uint16_t emu_TCNT5;
+#define TCNT5            emu_TCNT5
+extern volatile uint16_t emu_OCR5A;
+#define OCR5A            emu_OCR5A
+extern volatile uint16_t emu_OCR5B;
+#define OCR5B            emu_OCR5B
+extern volatile uint16_t emu_OCR5C;
+#define OCR5C            emu_OCR5C
+extern volatile uint16_t emu_ICR5;
+#define ICR5             emu_ICR5
+
+#define WGM50            0
+#define WGM51            1
+#define COM5C0           2
+#define COM5C1           3
+#define COM5B0           4
+#define COM5B1           5
+#define COM5A0           6
+#define COM5A1           7
+
+#define CS50             0
+#define CS51             1
+#define CS52             2
+#define WGM52            3
+#define WGM53            4
+#define ICES5            6
+#define ICNC5            7
+
+#define FOC5C            5
+#define FOC5B            6
+#define FOC5A            7
+
+#define TOIE5            0
+#define OCIE5A           1
+#define OCIE5B           2
+#define OCIE5C           3
+#define ICIE5            5
+
+#define TOV5             0
+#define OCF5A            1
+#define OCF5B            2
+#define OCF5C            3
+#define ICF5             5
+
+///////////////////////////////////////////
+
+// Timer2, 8-bit, asynchronous clock from TOSC1 / TOSC2
+
+extern volatile uint8_t  emu_TCCR2A;
+#define TCCR2A           emu_TCCR2A
+extern volatile uint8_t  emu_TCCR2B;
+#define TCCR2B           emu_TCCR2B
+extern volatile uint8_t  emu_TIMSK2;
+#define TIMSK2           emu_TIMSK2
+extern volatile uint8_t  emu_ASSR;
+#define ASSR             emu_ASSR
+extern emu_flags_t       emu_TIFR2;
+#define TIFR2            emu_TIFR2
+extern volatile uint8_t  emu_TCNT2;
+#define TCNT2            emu_TCNT2
+extern volatile uint8_t  emu_OCR2A;
+#define OCR2A            emu_OCR2A
+extern volatile uint8_t  emu_OCR2B;
+#define OCR2B            emu_OCR2B
+
+#define WGM20            0
+#define WGM21            1
+#define COM2B0           4
+#define COM2B1           5
+#define COM2A0           6
+#define COM2A1           7
+
+#define CS20             0
+#define CS21             1
+#define CS22             2
+#define WGM22            3
+#define FOC2B            6
+#define FOC2A            7
+
+#define TOIE2            0
+#define OCIE2A           1
+#define OCIE2B           2
+
+#define TOV2             0
+#define OCF2A            1
+#define OCF2B            2
+
+#define TCR2BUB          0
+#define TCR2AUB          1
+#define OCR2BUB          2
+#define OCR2AUB          3
+#define TCN2UB           4
+#define AS2              5
+#define EXCLK            6
+
+///////////////////////////////////////////
+
+#endif    // EMU_IOM2560_H
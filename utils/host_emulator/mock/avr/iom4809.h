@@ -0,0 +1,253 @@
+/****************************************************************************************************************************
+  iom4809.h
+  Host-side register file of the ATmega4809 TCA0, TCB0-3 and EVSYS, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  Register, bit and group names as in iom4809.h of the Atmel toolchain. Only the registers used by the timers are there,
+  not their exact addresses, but the arrays indexed by the library (EVSYS.CHANNELn, EVSYS.USERTCBn, TCA0.SINGLE.CMPn)
+  are contiguous as in the real register file.
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_IOM4809_H
+#define EMU_IOM4809_H
+
+typedef volatile uint8_t  register8_t;
+typedef volatile uint16_t register16_t;
+
+///////////////////////////////////////////
+
+// INTFLAGS: a flag is cleared by writing 1 to it
+class emu_flags_t
+{
+  public:
+
+    uint8_t value;
+
+    operator uint8_t() const
+    {
+      return value;
+    }
+
+    emu_flags_t& operator=(const uint8_t& x)
+    {
+      value &= ~x;
+      return *this;
+    }
+
+    emu_flags_t& operator|=(const uint8_t& x)
+    {
+      value &= ~(value | x);
+      return *this;
+    }
+
+    emu_flags_t& operator&=(const uint8_t& x)
+    {
+      value &= ~(value & x);
+      return *this;
+    }
+};
+
+// TCA0 CTRLESET: the RESTART and RESET commands act at once on TCA0
+void emu_tcaCommand(const uint8_t& command);
+
+class emu_tca_cmd_t
+{
+  public:
+
+    uint8_t value;
+
+    operator uint8_t() const
+    {
+      return value;
+    }
+
+    emu_tca_cmd_t& operator=(const uint8_t& x)
+    {
+      value |= (x & 0x03);
+      emu_tcaCommand(x & 0x0C);
+      return *this;
+    }
+};
+
+extern volatile uint8_t   emu_SREG;
+#define SREG              emu_SREG
+#define SREG_I            7
+
+///////////////////////////////////////////
+
+// 16-bit Timer Type B
+
+typedef struct TCB_struct
+{
+  register8_t   CTRLA;
+  register8_t   CTRLB;
+  register8_t   reserved_1[2];
+  register8_t   EVCTRL;
+  register8_t   INTCTRL;
+  emu_flags_t   INTFLAGS;
+  register8_t   STATUS;
+  register8_t   DBGCTRL;
+  register8_t   TEMP;
+  register8_t   reserved_2[2];
+  register16_t  CNT;
+  register16_t  CCMP;
+} TCB_t;
+
+extern TCB_t  emu_TCB0, emu_TCB1, emu_TCB2, emu_TCB3;
+
+#define TCB0    emu_TCB0
+#define TCB1    emu_TCB1
+#define TCB2    emu_TCB2
+#define TCB3    emu_TCB3
+
+#define TCB_ENABLE_bm           0x01
+#define TCB_CLKSEL_gm           0x06
+#define TCB_CLKSEL_gp           1
+#define TCB_CLKSEL_CLKDIV1_gc   (0x00<<1)
+#define TCB_CLKSEL_CLKDIV2_gc   (0x01<<1)
+#define TCB_CLKSEL_CLKTCA_gc    (0x02<<1)
+#define TCB_SYNCUPD_bm          0x10
+#define TCB_RUNSTDBY_bm         0x40
+
+#define TCB_CNTMODE_gm          0x07
+#define TCB_CNTMODE_INT_gc      (0x00<<0)
+#define TCB_CNTMODE_TIMEOUT_gc  (0x01<<0)
+#define TCB_CNTMODE_CAPT_gc     (0x02<<0)
+#define TCB_CNTMODE_FRQ_gc      (0x03<<0)
+#define TCB_CNTMODE_PW_gc       (0x04<<0)
+#define TCB_CNTMODE_FRQPW_gc    (0x05<<0)
+#define TCB_CNTMODE_SINGLE_gc   (0x06<<0)
+#define TCB_CNTMODE_PWM8_gc     (0x07<<0)
+#define TCB_CCMPEN_bm           0x10
+#define TCB_CCMPINIT_bm         0x20
+#define TCB_ASYNC_bm            0x40
+
+#define TCB_CAPTEI_bm           0x01
+#define TCB_EDGE_bm             0x10
+#define TCB_FILTER_bm           0x40
+
+#define TCB_CAPT_bm             0x01
+
+///////////////////////////////////////////
+
+// 16-bit Timer/Counter Type A, single and split modes
+
+typedef struct TCA_SINGLE_struct
+{
+  register8_t   CTRLA;
+  register8_t   CTRLB;
+  register8_t   CTRLC;
+  register8_t   CTRLD;
+  register8_t   CTRLECLR;
+  emu_tca_cmd_t CTRLESET;
+  register8_t   CTRLFCLR;
+  register8_t   CTRLFSET;
+  register8_t   EVCTRL;
+  register8_t   INTCTRL;
+  emu_flags_t   INTFLAGS;
+  register8_t   reserved_1[2];
+  register8_t   DBGCTRL;
+  register8_t   TEMP;
+  register8_t   reserved_2[17];
+  register16_t  CNT;
+  register8_t   reserved_3[4];
+  register16_t  PER;
+  register16_t  CMP0;
+  register16_t  CMP1;
+  register16_t  CMP2;
+} TCA_SINGLE_t;
+
+typedef struct TCA_SPLIT_struct
+{
+  register8_t   CTRLA;
+  register8_t   CTRLB;
+  register8_t   CTRLC;
+  register8_t   CTRLD;
+  register8_t   CTRLECLR;
+  emu_tca_cmd_t CTRLESET;
+  register8_t   reserved_1[4];
+  register8_t   INTCTRL;
+  emu_flags_t   INTFLAGS;
+} TCA_SPLIT_t;
+
+typedef union TCA_union
+{
+  TCA_SINGLE_t  SINGLE;
+  TCA_SPLIT_t   SPLIT;
+} TCA_t;
+
+extern TCA_t  emu_TCA0;
+
+#define TCA0    emu_TCA0
+
+#define TCA_SINGLE_ENABLE_bm          0x01
+#define TCA_SINGLE_CLKSEL_gm          0x0E
+#define TCA_SINGLE_CLKSEL_gp          1
+#define TCA_SINGLE_CLKSEL_DIV1_gc     (0x00<<1)
+#define TCA_SINGLE_CLKSEL_DIV2_gc     (0x01<<1)
+#define TCA_SINGLE_CLKSEL_DIV4_gc     (0x02<<1)
+#define TCA_SINGLE_CLKSEL_DIV8_gc     (0x03<<1)
+#define TCA_SINGLE_CLKSEL_DIV16_gc    (0x04<<1)
+#define TCA_SINGLE_CLKSEL_DIV64_gc    (0x05<<1)
+#define TCA_SINGLE_CLKSEL_DIV256_gc   (0x06<<1)
+#define TCA_SINGLE_CLKSEL_DIV1024_gc  (0x07<<1)
+
+#define TCA_SINGLE_WGMODE_gm          0x07
+#define TCA_SINGLE_WGMODE_NORMAL_gc   (0x00<<0)
+#define TCA_SINGLE_WGMODE_FRQ_gc      (0x01<<0)
+#define TCA_SINGLE_WGMODE_SINGLESLOPE_gc  (0x03<<0)
+#define TCA_SINGLE_CMP0EN_bm          0x10
+#define TCA_SINGLE_CMP1EN_bm          0x20
+#define TCA_SINGLE_CMP2EN_bm          0x40
+
+#define TCA_SINGLE_SPLITM_bm          0x01
+
+#define TCA_SINGLE_CMD_gm             0x0C
+#define TCA_SINGLE_CMD_NONE_gc        (0x00<<2)
+#define TCA_SINGLE_CMD_UPDATE_gc      (0x01<<2)
+#define TCA_SINGLE_CMD_RESTART_gc     (0x02<<2)
+#define TCA_SINGLE_CMD_RESET_gc       (0x03<<2)
+
+#define TCA_SINGLE_OVF_bm             0x01
+#define TCA_SINGLE_CMP0_bm            0x10
+#define TCA_SINGLE_CMP1_bm            0x20
+#define TCA_SINGLE_CMP2_bm            0x40
+
+#define TCA_SPLIT_ENABLE_bm           0x01
+#define TCA_SPLIT_CLKSEL_DIV64_gc     (0x05<<1)
+#define TCA_SPLIT_SPLITM_bm           0x01
+#define TCA_SPLIT_CMD_RESET_gc        (0x03<<2)
+
+///////////////////////////////////////////
+
+// Event System, the channels and the TCB users
+
+typedef struct EVSYS_struct
+{
+  register8_t   STROBE;
+  register8_t   reserved_1[15];
+  register8_t   CHANNEL0;
+  register8_t   CHANNEL1;
+  register8_t   CHANNEL2;
+  register8_t   CHANNEL3;
+  register8_t   CHANNEL4;
+  register8_t   CHANNEL5;
+  register8_t   CHANNEL6;
+  register8_t   CHANNEL7;
+  register8_t   reserved_2[24];
+  register8_t   USERTCB0;
+  register8_t   USERTCB1;
+  register8_t   USERTCB2;
+  register8_t   USERTCB3;
+} EVSYS_t;
+
+extern EVSYS_t  emu_EVSYS;
+
+#define EVSYS   emu_EVSYS
+
+#endif    // EMU_IOM4809_H
@@ -0,0 +1,26 @@
+/****************************************************************************************************************************
+  pgmspace.h
+  Host-side <avr/pgmspace.h>, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_AVR_PGMSPACE_H
+#define EMU_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+
+#define pgm_read_byte(addr)     (*(const uint8_t*)  (addr))
+#define pgm_read_word(addr)     (*(const uint16_t*) (addr))
+#define pgm_read_dword(addr)    (*(const uint32_t*) (addr))
+#define pgm_read_float(addr)    (*(const float*)    (addr))
+#define pgm_read_ptr(addr)      (*(void* const*)    (addr))
+
+#endif    // EMU_AVR_PGMSPACE_H
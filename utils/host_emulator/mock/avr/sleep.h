@@ -0,0 +1,32 @@
+/****************************************************************************************************************************
+  sleep.h
+  Host-side <avr/sleep.h>, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+
+  sleep_cpu() runs the emulator until the next ISR. The sleep mode itself is not emulated: the timers keep counting,
+  as in idle mode, and as Timer2 clocked from its 32.768 kHz crystal in power-save mode
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_AVR_SLEEP_H
+#define EMU_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          1
+#define SLEEP_MODE_PWR_DOWN     2
+#define SLEEP_MODE_PWR_SAVE     3
+#define SLEEP_MODE_STANDBY      6
+#define SLEEP_MODE_EXT_STANDBY  7
+
+void sleep_cpu();
+
+#define set_sleep_mode(mode)    do { (void) (mode); } while (0)
+#define sleep_enable()          do { } while (0)
+#define sleep_disable()         do { } while (0)
+#define sleep_mode()            sleep_cpu()
+
+#endif    // EMU_AVR_SLEEP_H
@@ -0,0 +1,99 @@
+/****************************************************************************************************************************
+  pins_arduino.h
+  Host-side pin maps of the Arduino Mega2560 and Nano Every, for the emulator of utils/host_emulator
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/TimerInterrupt_Generic
+  Licensed under MIT license
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef EMU_PINS_ARDUINO_H
+#define EMU_PINS_ARDUINO_H
+
+#include <stdint.h>
+
+#define NOT_A_PIN         255
+
+#if defined(__AVR_ATmega2560__)
+
+#define NUM_DIGITAL_PINS  70
+#define LED_BUILTIN       13
+
+#define NOT_ON_TIMER      0
+#define TIMER0A           1
+#define TIMER0B           2
+#define TIMER1A           3
+#define TIMER1B           4
+#define TIMER1C           5
+#define TIMER2            6
+#define TIMER2A           7
+#define TIMER2B           8
+#define TIMER3A           9
+#define TIMER3B           10
+#define TIMER3C           11
+#define TIMER4A           12
+#define TIMER4B           13
+#define TIMER4C           14
+#define TIMER4D           15
+#define TIMER5A           16
+#define TIMER5B           17
+#define TIMER5C           18
+
+// digital_pin_to_timer_PGM[] of the Mega core
+inline uint8_t digitalPinToTimer(const uint8_t& pin)
+{
+  switch (pin)
+  {
+    case 2:   return TIMER3B;
+    case 3:   return TIMER3C;
+    case 4:   return TIMER0B;
+    case 5:   return TIMER3A;
+    case 6:   return TIMER4A;
+    case 7:   return TIMER4B;
+    case 8:   return TIMER4C;
+    case 9:   return TIMER2B;
+    case 10:  return TIMER2A;
+    case 11:  return TIMER1A;
+    case 12:  return TIMER1B;
+    case 13:  return TIMER0A;
+    case 44:  return TIMER5C;
+    case 45:  return TIMER5B;
+    case 46:  return TIMER5A;
+    default:  return NOT_ON_TIMER;
+  }
+}
+
+#elif defined(__AVR_ATmega4809__)
+
+#define NUM_DIGITAL_PINS  22
+#define LED_BUILTIN       13
+
+#define PA                0
+#define PB                1
+#define PC                2
+#define PD                3
+#define PE                4
+#define PF                5
+
+// Nano Every: port and bit of D0-D21
+inline uint8_t digitalPinToPort(const uint8_t& pin)
+{
+  static const uint8_t port[NUM_DIGITAL_PINS] =
+  { PC, PC, PA, PF, PC, PB, PF, PA, PE, PB, PB, PE, PE, PE, PD, PD, PD, PD, PA, PA, PD, PD };
+
+  return (pin < NUM_DIGITAL_PINS) ? port[pin] : NOT_A_PIN;
+}
+
+inline uint8_t digitalPinToBitPosition(const uint8_t& pin)
+{
+  static const uint8_t bitPosition[NUM_DIGITAL_PINS] =
+  { 5, 4, 0, 5, 6, 2, 4, 1, 3, 0, 1, 0, 1, 2, 3, 2, 1, 0, 2, 3, 4, 5 };
+
+  return (pin < NUM_DIGITAL_PINS) ? bitPosition[pin] : NOT_A_PIN;
+}
+
+#endif
+
+#endif    // EMU_PINS_ARDUINO_H
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Build the AVR (Mega2560) and megaAVR (Nano Every) sweeps with the host g++, then run them.
+# Arguments are passed to both sweeps, e.g. ./run.sh --periods 10 --max-ppm 500
+
+cd "$(dirname "$0")" || exit 2
+
+BUILD=${BUILD:-build}
+CXXFLAGS="-std=gnu++11 -O2 -Wall -Wextra -Imock -I../../src"
+
+mkdir -p $BUILD
+
+g++ $CXXFLAGS -D__AVR_ATmega2560__ -DF_CPU=16000000UL \
+    avr_sweep.cpp emu_core.cpp emu_avr.cpp -o $BUILD/avr_sweep || exit 2
+
+g++ $CXXFLAGS -D__AVR_ATmega4809__ -DARDUINO_AVR_NANO_EVERY -DF_CPU=16000000UL -fno-toplevel-reorder \
+    megaavr_sweep.cpp emu_core.cpp emu_megaavr.cpp -o $BUILD/megaavr_sweep || exit 2
+
+status=0
+
+$BUILD/avr_sweep "$@" || status=1
+$BUILD/megaavr_sweep "$@" || status=1
+
+exit $status
@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# IRAM and flash taken by each ISR_Timer function in an ESP32 / ESP8266 sketch build.
+# Usage: utils/iram_report.sh sketch.ino.elf [objdump]
+#   objdump: xtensa-esp32-elf-objdump (default), xtensa-esp32s2-elf-objdump, xtensa-esp32s3-elf-objdump,
+#            riscv32-esp-elf-objdump (ESP32_C3) or xtensa-lx106-elf-objdump (ESP8266), from the core toolchain
+# Build the sketch a second time with '#define ISR_TIMER_CONFIG_IN_IRAM true' before the includes: the difference of
+# the IRAM totals is the IRAM saved by keeping the configuration functions out of IRAM.
+
+if [ $# -lt 1 ] || [ ! -f "$1" ]; then
+  echo "Usage: $0 sketch.elf [objdump]" >&2
+  exit 2
+fi
+
+ELF=$1
+OBJDUMP=${2:-xtensa-esp32-elf-objdump}
+
+# ESP32 family: .iram0.text is IRAM, .flash.text flash. ESP8266: .text / .text1 are IRAM, .irom0.text flash
+$OBJDUMP -t -C "$ELF" | grep "ISR_Timer::" | awk -F '\t' '
+function hex(s,    i, v)
+{
+  v = 0
+
+  for (i = 1; i <= length(s); i++)
+    v = v * 16 + index("0123456789abcdef", tolower(substr(s, i, 1))) - 1
+
+  return v
+}
+
+{
+  n = split($1, head, " ")
+  section = head[n]
+
+  split($2, tail, " ")
+  size = hex(tail[1])
+  name = substr($2, length(tail[1]) + 2)
+
+  if (size == 0)
+    next
+
+  iram = (section ~ /^\.iram/) || (section == ".text") || (section == ".text1")
+
+  printf("%-6s %6u  %s\n", iram ? "IRAM" : "flash", size, name)
+}' | sort -k1,1 -k2,2nr | awk '
+{
+  print
+
+  if ($1 == "IRAM")
+    iramTotal += $2
+  else
+    flashTotal += $2
+}
+END {
+  printf("ISR_Timer: IRAM %u bytes, flash %u bytes\n", iramTotal, flashTotal)
+}'